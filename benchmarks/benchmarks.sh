@@ -64,6 +64,20 @@ CRIT1="-pserv $cost_pserv"
 CRIT2="$sum_bandw $dist_pserv $bad_pserv -leximax[$bad_pserv]"
 
 PRINT=0
+## share the generated models between the runs (set CACHE to a directory)
+if [ -n "$CACHE" ]; then
+    mkdir -p $CACHE
+    CACHE_OPT="-cache `readlink -f $CACHE`"
+fi
+## only the paths of length lower or equal than MAXLENGTH carry connections
+## (compare the optima with the whole model: ./compare.sh "" "-maxlength $MAXLENGTH" OBJECTIVE FILE...)
+if [ -n "$MAXLENGTH" ]; then
+    MAXLENGTH_OPT="-maxlength $MAXLENGTH"
+fi
+## solve all the objectives of an instance in a single run (set SWEEP to 1)
+SWEEP=${SWEEP:-0}
+## solve all the jobs in a single run (set BATCH to the number of concurrent solves)
+BATCH=${BATCH:-0}
 #--------------------------------------------------------------------
 # Test for prerequisites
 #--------------------------------------------------------------------
@@ -106,7 +120,44 @@ for C1 in $CRIT1; do
     done
 done
 
+##Generate a batch manifest
+if [ $BATCH -ne 0 ] ; then
+    echo "batch | $OBJECTIVES"
+    if [ $PRINT -eq 0 ] ; then
+	mkdir batch
+	for O in $OBJECTIVES; do
+	    for G in $GENERATORS; do
+		for ((J=1; J <= N ; J++))
+		do
+		    echo "$G $J $O" >> batch/manifest.txt
+		done
+	    done
+	done
+	echo "#!/bin/sh" > batch/batch.sh
+	echo "$EXEC -v0 $MAXLENGTH_OPT -batch `readlink -f batch/manifest.txt` -jobs $BATCH -o `readlink -f batch`/results.json" >> batch/batch.sh
+	chmod +x batch/batch.sh
+    fi
+    exit 0
+fi
 ##Generate shell scripts
+if [ $SWEEP -ne 0 ] ; then
+    ## the structural constraints are generated once per instance
+    echo "sweep | $OBJECTIVES"
+    if [ $PRINT -eq 0 ] ; then
+	mkdir sweep
+	for G in $GENERATORS; do
+	    gname=`basename $G .dat`
+	    for ((J=1; J <= N ; J++))
+	    do
+		name=`printf 'sweep/%s-%02d.sh\n'  $gname $J`
+		echo "#!/bin/sh" > $name
+		echo "$EXEC -v1 -s$J  -i $G $MAXLENGTH_OPT $OBJECTIVES" >> $name
+		chmod +x $name
+	    done
+	done
+    fi
+    exit 0
+fi
 I=1
 for O in $OBJECTIVES; do
     dirname=`printf 'obj-%02d' $I`
@@ -120,7 +171,7 @@ for O in $OBJECTIVES; do
 		name=`printf '%s/%s-%02d.sh\n'  $dirname $gname $J`
 	    ##echo $name
 		echo "#!/bin/sh" > $name
-		echo "$EXEC -v1 -s$J  -i $G  $O" >> $name
+		echo "$EXEC -v1 -s$J  -i $G $CACHE_OPT $MAXLENGTH_OPT $O" >> $name
 		chmod +x $name
 	    done
 	done
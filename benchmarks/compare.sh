@@ -0,0 +1,147 @@
+#!/bin/bash
+###################################################
+#     Copyright (C) 2012 Arnaud Malapert.
+#
+#     This program is free software: you can redistribute it and/or modify
+#     it under the terms of the GNU General Public License as published by
+#     the Free Software Foundation, either version 3 of the License, or
+#     (at your option) any later version.
+#
+#     This program is distributed in the hope that it will be useful,
+#     but WITHOUT ANY WARRANTY; without even the implied warranty of
+#     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#     GNU General Public License for more details.
+#
+#     You should have received a copy of the GNU General Public License
+#     along with this program.  If not, see <http://ww.gnu.org/licenses/>.
+###################################################
+
+PROG=`basename $0 .sh`
+version() {
+
+    cat <<EOF
+$PROG 0.1
+Copyright (C) 2012 Arnaud Malapert.
+License GPLv3+: GNU GPL version 3 or later <http://gnu.org/licenses/gpl.html>.
+This  is free software: you are free to change and redistribute it.  There is NO WARRANTY, to the extent permitted by law.
+
+Written by A. Malapert."
+EOF
+}
+
+help() {
+cat <<EOF
+$PROG solves the same runs with two sets of options of the opossum solver, and compares the models and the optima.
+
+Usage: $PROG [OPTION] REFERENCE COMPARED OBJECTIVE FILE...
+
+REFERENCE and COMPARED are the options of the two runs ("" for none), OBJECTIVE is a criteria combination.
+Each instance FILE is solved with the seeds 1 to N. A line is printed for each run:
+  instance seed | rows columns nonzeros of both models | objective values of both runs | wall times | verdict
+The verdict compares the values of the objective levels in the lexicographic order:
+SAME, BETTER or WORSE (for the compared run), UNSAT if only the compared run is infeasible,
+or UNSOLVED if a run is not solved to optimality.
+The last line counts the verdicts.
+
+Options:
+  --help        display this help and exit
+  --version     output version information and exit
+
+Environment:
+  EXEC          opossum binary (../bin/Release/opossum-0.1)
+  N             number of seeds (5)
+  SOLVER        options selecting the solver, e.g. "-lp /usr/bin/scip" (the default solver)
+
+Examples:
+  $PROG "" "-flow" "-lex[-pserv,-conn]" instances/gen*.dat
+                the flow formulation must give the same optima (with about 10% more nonzeros on these instances)
+  $PROG "" "-maxlength 1" "-lex[-pserv,-conn]" instances/gen*.dat
+                the optima lost (or the instances made infeasible) by the paths of length 1 only
+
+Report bugs to <arnaud (dot) malapert (at) unice (dot) fr>."
+EOF
+}
+
+#--------------------------------------------------------------------
+# Setup Global Variables
+#--------------------------------------------------------------------
+
+EXEC=${EXEC:-`readlink -f ../bin/Release/opossum-0.1`}
+N=${N:-5}
+TMP=`mktemp -d`
+trap "rm -rf $TMP" EXIT
+
+#--------------------------------------------------------------------
+# Test for prerequisites
+#--------------------------------------------------------------------
+
+if [ $# -eq 0 ] || [ "$1" = "--help" ]; then
+    help
+    exit 0
+elif [ "$1" = "--version" ]; then
+    version
+    exit 0
+elif [ $# -lt 4 ]; then
+    help
+    exit -1
+elif [ ! -x "$EXEC" ]; then
+    echo "$EXEC is not an executable file"
+    exit -1
+fi
+
+REFERENCE=$1
+COMPARED=$2
+OBJECTIVE=$3
+shift 3
+
+#--------------------------------------------------------------------
+# Do something
+#--------------------------------------------------------------------
+
+## run opossum, print the model size, the status and the objective values of the levels
+## (read from the statistics and the report of the run)
+run() {
+    local options=$1 instance=$2 seed=$3
+    $EXEC -v0 -s$seed -i $instance $SOLVER $options -stats $TMP/stats.json -report $TMP/report.json "$OBJECTIVE" > /dev/null 2>&1
+    awk -F'[:,]' 'NR == 1 {
+        for (i = 1; i < NF; i++) {
+            if ($i ~ /"(rows|columns|nonzeros)"/) printf "%d ", $(i+1)
+        }
+        exit
+    }' $TMP/stats.json 2> /dev/null
+    awk 'NR == 1 {
+        match($0, /"status": "[A-Z_]*"/); status = substr($0, RSTART + 11, RLENGTH - 12)
+        match($0, /"wall": [0-9.e+-]*/); wall = substr($0, RSTART + 8, RLENGTH - 8)
+    }
+    /"objective": [0-9]+,/ {
+        if (match($0, /"value": [0-9.e+-]*/)) values = values (values ? "," : "") substr($0, RSTART + 9, RLENGTH - 9)
+    }
+    END { printf "%s %s %s\n", status ? status : "ERROR", values ? values : "-", wall ? wall : "-" }' $TMP/report.json 2> /dev/null
+    rm -f $TMP/stats.json $TMP/report.json
+}
+
+printf "# %s | %s | %s\n" "${REFERENCE:-(none)}" "${COMPARED:-(none)}" "$OBJECTIVE"
+for G in $*; do
+    for ((J=1; J <= N ; J++)); do
+	A=(`run "$REFERENCE" $G $J`)
+	B=(`run "$COMPARED" $G $J`)
+	## rows columns nonzeros status values wall
+	if [ "${A[3]}" = "OPTIMUM_FOUND" ] && [ "${B[3]}" = "UNSAT" ]; then
+	    VERDICT=UNSAT
+	elif [ "${A[3]}" != "OPTIMUM_FOUND" ] || [ "${B[3]}" != "OPTIMUM_FOUND" ]; then
+	    VERDICT=UNSOLVED
+	else
+	    VERDICT=`echo "${A[4]} ${B[4]}" | awk '{
+	        n = split($1, a, ","); split($2, b, ",")
+	        for (i = 1; i <= n; i++) {
+	            if (b[i] + 0 < a[i] + 0) { print "BETTER"; exit }
+	            if (b[i] + 0 > a[i] + 0) { print "WORSE"; exit }
+	        }
+	        print "SAME"
+	    }'`
+	fi
+	printf "%s %d | %s %s %s | %s %s %s | %s | %s | %s %s | %s\n" `basename $G .dat` $J \
+	    "${A[0]}" "${A[1]}" "${A[2]}" "${B[0]}" "${B[1]}" "${B[2]}" "${A[4]}" "${B[4]}" "${A[5]}" "${B[5]}" $VERDICT
+    done
+done | tee $TMP/runs.txt
+awk '{ count[$NF]++ } END { for (v in count) printf "# %s %d\n", v, count[v] }' $TMP/runs.txt
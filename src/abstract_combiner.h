@@ -15,7 +15,7 @@
 class abstract_combiner {
  public:
   // Called to know the number of columns required by the combiner
-  virtual int column_allocation(int first_rank) { return first_rank; }
+  virtual Rank column_allocation(Rank first_rank) { return first_rank; }
 
   // Method in charge of the combiner objective generation
   virtual int objective_generation() { return 0; }
@@ -20,7 +20,7 @@
 class abstract_criteria {
 public:
 	// Method called to allocate some variables (columns) to the criteria
-	virtual int set_variable_range(int first_free_var) { return 0; }
+	virtual Rank set_variable_range(Rank first_free_var) { return 0; }
 	// Method called to add the criteria to the current objective
 	virtual int add_criteria_to_objective(CUDFcoefficient lambda) { return 0; };
 	// Method called to add the criteria to the constraints
@@ -176,5 +176,19 @@ public:
 		return _max;
 	}
 };
+
+// Number of stages of the generated problem within a stage range represented by each stage (see PSLProblem::aggregateGroups).
+// The range can not separate the groups merged into a stage.
+inline IntList stage_weights_of(PSLProblem *problem, param_range &stage_range) {
+	IntList weights = problem->getStageWeights(stage_range.min(), stage_range.max());
+	IntList groups = problem->getStageWeights(0, problem->originalStageCount() - 1);
+	for (unsigned int s = 0; s < weights.size(); ++s) {
+		if(weights[s] > 0 && weights[s] < groups[s]) {
+			fprintf(stderr, "ERROR: the stage range of a criteria separates merged groups of clients (see -mergegroups).\n");
+			exit(-1);
+		}
+	}
+	return weights;
+}
 #endif
 
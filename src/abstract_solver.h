@@ -90,6 +90,11 @@ public:
 	// write the internal representation of the problem to a file
 	virtual int writelp(char *filename) { return 0; };
 
+	// ******************************************************************
+	// give a feasible starting solution of the columns of the problem (called once all constraints have been defined)
+	// the solvers without warm start ignore it
+	virtual int set_mip_start(const vector<double> &start) { return 0; };
+
 	// ******************************************************************
 	// solve the problem (must return a value > 0 if a solution has been found)
 	virtual int solve() { return 0; };
@@ -154,7 +159,7 @@ protected:
 				NodeIterator j = i->nbegin();
 				j++;
 				while(j !=  i->nend()) {
-					for (int s = 0; s < problem->stageCount(); ++s) {
+					for (int s = 0; problem->hasPath(*i, *j) && s < problem->stageCount(); ++s) {
 						set_intvar(problem->rankZ(*i, *j, s), sprint_var("z%d_%d'%d", i->getID(), j->getID(), s));
 						set_realvar(problem->rankB(*i, *j, s), sprint_var("b%d_%d'%d", i->getID(), j->getID(), s));
 					}
@@ -170,11 +175,13 @@ protected:
 		return 0;
 	}
 
+	// allocate the name of a variable (NULL if variable names are disabled)
 	inline char* sprint_var(const char * format, ...) {
-		char buffer[16];
+		if(! variable_names) return NULL;
+		char buffer[64];
 		va_list args;
 		va_start(args, format);
-		vsprintf(buffer, format, args);
+		vsnprintf(buffer, sizeof(buffer), format, args);
 		va_end(args);
 		char *name;
 		if ((name = (char *)malloc(strlen(buffer)+1)) == (char *)NULL) {
@@ -182,6 +189,7 @@ protected:
 			exit(-1);
 		}
 		strcpy(name, buffer);
+		memory_alloc(MEM_NAMES, strlen(buffer)+1);
 		return name;
 	}
 };
@@ -0,0 +1,665 @@
+/*******************************************************/
+/* oPoSSuM solver: batch.c                             */
+/* Batch of problems solved by a single invocation     */
+/* (c) Arnaud Malapert I3S (UNS-CNRS) 2012             */
+/*******************************************************/
+
+#include <batch.h>
+#include <constraint_generation.h>
+#include <run_report.h>
+#include <presolve.h>
+#include <evaluator.h>
+#include <fstream>
+#include <sstream>
+#include <deque>
+#include <algorithm>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/prctl.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+// A job of the manifest or a request of the daemon
+struct batch_job {
+	string input;
+	unsigned int seed;
+	string objective;
+	string solver;                // solver option (empty for the default solver)
+	string lpsolver;              // external solver of the -lp:<lpsolver> option
+	double time_limit;            // negative for the global time limit
+	string text;                  // line of the job (sent to the worker which solves it)
+	abstract_combiner *combiner;
+
+	batch_job() : seed(0), time_limit(-1), combiner(NULL) {}
+};
+
+//----------------------------------------------------------------------------------------------------
+// Jobs
+//----------------------------------------------------------------------------------------------------
+
+// parse a job: <input_file> <seed> <criteria combination> [<solver> [<time limit>]]
+// return 1 if a job is read, 0 for an empty line or a comment, -1 on error
+static int parse_job(const string &text, batch_job &job, string &error) {
+	job.text = text;
+	istringstream fields(text);
+	if (!(fields >> job.input) || job.input[0] == '#') return 0;
+	if (!(fields >> job.seed >> job.objective)) {
+		error = "a job requires an input file, a seed and a criteria combination";
+		return -1;
+	}
+	string solver;
+	if (fields >> solver && solver != "-") {
+		if (solver.compare(0, 4, "-lp:") == 0) {
+			job.solver = "-lp";
+			job.lpsolver = solver.substr(4);
+		} else if (solver == "-cplex" || solver == "-highs" || solver == "-glpk" || solver == "-lpsolve") {
+			job.solver = solver;
+		} else {
+			error = "unrecognized solver " + solver;
+			return -1;
+		}
+	}
+	if (!fields.eof() && !(fields >> job.time_limit)) {
+		error = "invalid time limit";
+		return -1;
+	}
+	return 1;
+}
+
+// generate the network of a job into the_problem (the input files are read once)
+static bool load_network(const batch_job &job, map<string, string> &inputs) {
+	report_phase phase("network");
+	map<string, string>::iterator it = inputs.find(job.input);
+	if (it == inputs.end()) {
+		ifstream in(job.input.c_str());
+		if (!in) return false;
+		ostringstream content;
+		content << in.rdbuf();
+		it = inputs.insert(make_pair(job.input, content.str())).first;
+	}
+	istringstream in(it->second);
+	if (parse_pslp(in) != 0) return false;
+	the_problem->setSeed(job.seed);
+	the_problem->setMaxPathLength(max_path_length);
+	the_problem->generateNetwork(HIERARCHIC);
+	if (merge_groups) the_problem->aggregateGroups();
+	if (contract_chains) the_problem->contractChains();
+	if (merge_leaves) the_problem->aggregateLeaves();
+	return true;
+}
+
+// solve a job (in a forked worker), return the fields of its result
+static string solve_job(const batch_job &job, int &status) {
+	if (job.time_limit >= 0) time_limit = job.time_limit;
+	PSLProblem *problem = the_problem;
+	abstract_solver *solver = create_solver(job.solver.empty() ? NULL : job.solver.c_str(), (char *) job.lpsolver.c_str());
+	if (presolve_model) solver = new presolve_solver(solver);
+	job.combiner->initialize(problem, solver);
+	status = ERROR;
+	if (generate_constraints(problem, *solver, *job.combiner) == 0) {
+		if (warm_start) set_warm_start(problem, *solver);
+		status = solver->solve();
+	}
+
+	// the objective of merged leaves is only a bound (see evaluate_merged_leaves)
+	const bool relaxed = (status == OPTIMUM || status == SAT) && problem->mergedLeafCount() > 0;
+	placement_evaluator evaluation;
+	if (status == OPTIMUM || status == SAT) {
+		solver->init_solutions();
+		if (relaxed) status = evaluate_merged_leaves(problem, solver, job.seed, (char *) job.objective.c_str(), evaluation);
+	}
+	ostringstream result;
+	result << ", \"status\": " << json_string(status_name(status))
+			<< ", \"objectives\": " << solver->objectiveCount();
+	if (relaxed) {
+		result << ", \"bound\": " << solver->objective_value();
+		if (status == SAT && evaluation.objectiveCount() > 0) result << ", \"value\": " << evaluation.objective_value();
+		result << ", \"pservers\": " << evaluation.pservCount;
+	} else if (status == OPTIMUM || status == SAT) {
+		CUDFcoefficient pservers = 0;
+		for(NodeIterator i = problem->nbegin() ; i!=  problem->nend() ; i++) {
+			pservers += solver->get_solution(problem->rankX(*i));
+		}
+		result << ", \"value\": " << solver->objective_value()
+				<< ", \"pservers\": " << pservers;
+	}
+	result << ", \"runtime\": " << solver->timeCount()
+			<< ", \"nodes\": " << solver->nodeCount()
+			<< ", \"solutions\": " << solver->solutionCount();
+	return result.str();
+}
+
+// fields describing a job
+static string job_fields(const batch_job &job) {
+	ostringstream fields;
+	fields << "\"input\": " << json_string(job.input)
+			<< ", \"seed\": " << job.seed
+			<< ", \"objective\": " << json_string(job.objective)
+			<< ", \"solver\": " << json_string(job.solver.empty() ? "default" : job.solver);
+	return fields.str();
+}
+
+static void write_all(int fd, const string &s) {
+	size_t done = 0;
+	while (done < s.size()) {
+		ssize_t n = write(fd, s.data() + done, s.size() - done);
+		if (n <= 0) break;
+		done += n;
+	}
+}
+
+// fork a worker (which must not print out the output buffered by the main process)
+static pid_t fork_worker(ostream &out) {
+	out.flush();
+	cout.flush();
+	fflush(stdout);
+	pid_t pid = fork();
+	if (pid == -1) {
+		perror("fork_worker: fork");
+		exit(-1);
+	}
+	return pid;
+}
+
+// end a worker (its own buffers are flushed)
+static void exit_worker(int code) {
+	cout.flush();
+	fflush(stdout);
+	_exit(code);
+}
+
+// solve a request (in a forked process), the progress of the levels is streamed to the client
+static void serve_request(batch_job &job, int fd) {
+	write_all(fd, "{\"event\": \"running\", " + job_fields(job) + "}\n");
+	phase_timer timer;
+	the_report.progress_fd = fd;
+	int status;
+	string result = solve_job(job, status);
+	ostringstream line;
+	line << "{\"event\": \"result\"" << result << ", \"wall\": " << timer.wall() << "}" << endl;
+	write_all(fd, line.str());
+	close(fd);
+	exit_worker(0);
+}
+
+//----------------------------------------------------------------------------------------------------
+// Worker pool
+//----------------------------------------------------------------------------------------------------
+
+// The workers of the pool live as long as the batch or the daemon. A worker opens the environment of a solver
+// the first time one of its jobs uses it, and solves each job in a forked process, so that a job which crashes
+// or leaks does not end the worker. The worker generates the network of its next job while the previous one is solved.
+// The main process sends a job on the socket of a worker as a message: its number and its line,
+// with the socket of the client of a request (daemon). The process solving a job sends its result to the main process (batch),
+// then the worker sends the end of the job: its number, the exit code of the process (-1 if it crashed) and its wall time.
+
+// A worker seen from the main process
+struct pool_worker {
+	pid_t pid;
+	int channel;                  // socket to the worker
+	deque<size_t> jobs;           // jobs sent to the worker which have not ended yet
+
+	pool_worker() : pid(0), channel(-1) {}
+};
+
+// A message of a worker to the main process
+struct pool_message {
+	size_t job;
+	bool end;                     // the end of the job, or its result
+	int code;                     // exit code of the job (-1 if it crashed)
+	double wall;
+	string result;                // fields of the result
+
+	pool_message() : job(0), end(false), code(-1), wall(0) {}
+};
+
+// A job received by a worker
+struct received_job {
+	size_t number;
+	batch_job job;
+	int fd;                       // client socket (daemon) or -1
+	bool generated;               // is the network of the job in the_problem ?
+};
+
+// send a message on a channel with a socket (if fd >= 0)
+static bool send_message(int channel, const string &text, int fd) {
+	struct iovec data = {(void *) text.data(), text.size()};
+	struct msghdr message;
+	memset(&message, 0, sizeof(message));
+	message.msg_iov = &data;
+	message.msg_iovlen = 1;
+	char control[CMSG_SPACE(sizeof(int))];
+	if (fd >= 0) {
+		message.msg_control = control;
+		message.msg_controllen = sizeof(control);
+		struct cmsghdr *header = CMSG_FIRSTHDR(&message);
+		header->cmsg_level = SOL_SOCKET;
+		header->cmsg_type = SCM_RIGHTS;
+		header->cmsg_len = CMSG_LEN(sizeof(int));
+		memcpy(CMSG_DATA(header), &fd, sizeof(int));
+	}
+	return sendmsg(channel, &message, MSG_NOSIGNAL) == (ssize_t) text.size();
+}
+
+// receive a message on a channel with its socket (-1 if none), return false if the channel is closed
+static bool receive_message(int channel, string &text, int &fd) {
+	static char buffer[65536];
+	struct iovec data = {buffer, sizeof(buffer)};
+	struct msghdr message;
+	memset(&message, 0, sizeof(message));
+	message.msg_iov = &data;
+	message.msg_iovlen = 1;
+	char control[CMSG_SPACE(sizeof(int))];
+	message.msg_control = control;
+	message.msg_controllen = sizeof(control);
+	ssize_t n;
+	while ((n = recvmsg(channel, &message, MSG_CMSG_CLOEXEC)) == -1 && errno == EINTR);
+	if (n <= 0) return false;
+	text.assign(buffer, n);
+	fd = -1;
+	struct cmsghdr *header = CMSG_FIRSTHDR(&message);
+	if (header != NULL && header->cmsg_type == SCM_RIGHTS) memcpy(&fd, CMSG_DATA(header), sizeof(int));
+	return true;
+}
+
+// solve a job received by a worker (in a forked process)
+static void solve_received(received_job &received, int channel) {
+	// an invalid criteria combination ends the process (see get_criteria)
+	vector<abstract_criteria *> criteria_with_property;
+	received.job.combiner = new_combiner(strdup(received.job.objective.c_str()), &criteria_with_property);
+	if (received.job.combiner == NULL) exit_worker(1);
+	if (received.fd >= 0) serve_request(received.job, received.fd);
+	int status;
+	ostringstream result;
+	result << "R " << received.number << solve_job(received.job, status);
+	send_message(channel, result.str(), -1);
+	exit_worker(status == ERROR ? 1 : 0);
+}
+
+// send the end of a job to the main process
+static void end_received(int channel, const received_job &received, int code, double wall) {
+	ostringstream end;
+	end << "E " << received.number << " " << code << " " << wall;
+	send_message(channel, end.str(), -1);
+	if (received.fd >= 0) close(received.fd);
+}
+
+// solve the jobs sent by the main process until it closes the channel
+static void run_worker(int channel) {
+	map<string, string> inputs;
+	deque<received_job> received;
+	pid_t solving = 0;
+	phase_timer timer;
+	bool open = true;
+	while (open || ! received.empty()) {
+		// solve the next job
+		if (! solving && ! received.empty()) {
+			received_job &next = received.front();
+			if (! next.generated && ! load_network(next.job, inputs)) {
+				end_received(channel, next, 1, 0);
+				received.pop_front();
+				continue;
+			}
+			open_solver_environment(next.job.solver.empty() ? NULL : next.job.solver.c_str());
+			timer.start();
+			solving = fork_worker(cout);
+			if (solving == 0) {
+				// the job ends with its worker (see receive_pool)
+				prctl(PR_SET_PDEATHSIG, SIGKILL);
+				for (size_t r = 1; r < received.size(); r++) {
+					if (received[r].fd >= 0) close(received[r].fd);
+				}
+				solve_received(next, channel);
+			}
+			if (next.fd >= 0) close(next.fd);
+			next.fd = -1;
+		}
+		// the network of the next job is generated while the previous one is solved
+		if (solving && received.size() > 1 && ! received[1].generated) {
+			received[1].generated = load_network(received[1].job, inputs);
+			if (! received[1].generated) {
+				end_received(channel, received[1], 1, 0);
+				received.erase(received.begin() + 1);
+			}
+		}
+		// receive the jobs
+		struct pollfd polled = {channel, POLLIN, 0};
+		if (open && poll(&polled, 1, solving ? 100 : -1) > 0) {
+			string text, error;
+			received_job job;
+			if (receive_message(channel, text, job.fd)) {
+				istringstream in(text);
+				in >> job.number;
+				getline(in, text);
+				// the job has been checked by the main process
+				parse_job(text, job.job, error);
+				job.generated = false;
+				received.push_back(job);
+			} else open = false;
+		} else if (! open) usleep(10000);
+		// end the solved job
+		int wstatus;
+		if (solving && waitpid(solving, &wstatus, WNOHANG) == solving) {
+			end_received(channel, received.front(), WIFEXITED(wstatus) ? WEXITSTATUS(wstatus) : -1, timer.wall());
+			received.pop_front();
+			solving = 0;
+		}
+	}
+	exit_worker(0);
+}
+
+// start the worker w of the pool, which closes the sockets of the main process (the other workers and the inherited sockets)
+static void start_worker(vector<pool_worker> &pool, size_t w, ostream &out, const vector<int> &inherited) {
+	int fds[2];
+	if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, fds) == -1) {
+		perror("start_worker: socketpair");
+		exit(-1);
+	}
+	// the external solvers do not keep the channel open (see lp_solver.c)
+	fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+	fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+	pid_t pid = fork_worker(out);
+	if (pid == 0) {
+		close(fds[0]);
+		for (size_t k = 0; k < pool.size(); k++) {
+			if (pool[k].channel >= 0) close(pool[k].channel);
+		}
+		for (size_t k = 0; k < inherited.size(); k++) close(inherited[k]);
+		run_worker(fds[1]);
+	}
+	close(fds[1]);
+	pool[w].pid = pid;
+	pool[w].channel = fds[0];
+	pool[w].jobs.clear();
+}
+
+static void start_pool(vector<pool_worker> &pool, int workers, ostream &out, const vector<int> &inherited) {
+	pool.assign(workers, pool_worker());
+	for (int w = 0; w < workers; w++) start_worker(pool, w, out, inherited);
+}
+
+// stop the workers once their jobs are solved
+static void stop_pool(vector<pool_worker> &pool) {
+	for (size_t w = 0; w < pool.size(); w++) close(pool[w].channel);
+	for (size_t w = 0; w < pool.size(); w++) waitpid(pool[w].pid, NULL, 0);
+	pool.clear();
+}
+
+// send a job to the least busy worker which has less than depth jobs, return false if there is none
+static bool dispatch_job(vector<pool_worker> &pool, size_t job, const string &text, int fd, size_t depth) {
+	ostringstream message;
+	message << job << " " << text;
+	size_t best = pool.size();
+	for (size_t w = 0; w < pool.size(); w++) {
+		if (pool[w].jobs.size() < depth && (best == pool.size() || pool[w].jobs.size() < pool[best].jobs.size())) best = w;
+	}
+	// a worker which has crashed is started again when its channel is read (see receive_pool)
+	if (best == pool.size() || ! send_message(pool[best].channel, message.str(), fd)) return false;
+	pool[best].jobs.push_back(job);
+	return true;
+}
+
+// receive the messages of the workers within timeout milliseconds (-1 to wait for a message)
+// a worker which has crashed is started again and its jobs end with a crash
+static void receive_pool(vector<pool_worker> &pool, vector<pool_message> &messages, int timeout, ostream &out, const vector<int> &inherited) {
+	vector<struct pollfd> polled(pool.size());
+	for (size_t w = 0; w < pool.size(); w++) {
+		polled[w].fd = pool[w].channel;
+		polled[w].events = POLLIN;
+		polled[w].revents = 0;
+	}
+	if (poll(&polled[0], polled.size(), timeout) <= 0) return;
+	for (size_t w = 0; w < pool.size(); w++) {
+		if (! polled[w].revents) continue;
+		string text;
+		int fd;
+		if (receive_message(pool[w].channel, text, fd)) {
+			pool_message message;
+			char kind;
+			istringstream in(text);
+			in >> kind >> message.job;
+			message.end = kind == 'E';
+			if (message.end) {
+				in >> message.code >> message.wall;
+				pool[w].jobs.erase(find(pool[w].jobs.begin(), pool[w].jobs.end(), message.job));
+			} else getline(in, message.result);
+			messages.push_back(message);
+			continue;
+		}
+		close(pool[w].channel);
+		waitpid(pool[w].pid, NULL, 0);
+		for (size_t j = 0; j < pool[w].jobs.size(); j++) {
+			pool_message message;
+			message.job = pool[w].jobs[j];
+			message.end = true;
+			messages.push_back(message);
+		}
+		pool[w].channel = -1;
+		start_worker(pool, w, out, inherited);
+	}
+}
+
+//----------------------------------------------------------------------------------------------------
+// Batch
+//----------------------------------------------------------------------------------------------------
+
+static void read_manifest(const char *manifest, vector<batch_job> &jobs) {
+	ifstream in(manifest);
+	if (!in) {
+		fprintf(stderr, "ERROR: cannot open file %s as batch manifest.\n", manifest);
+		exit(-1);
+	}
+	vector<abstract_criteria *> criteria_with_property;
+	string text, error;
+	int line = 0;
+	while (getline(in, text)) {
+		line++;
+		batch_job job;
+		switch (parse_job(text, job, error)) {
+		case 0: continue;
+		case -1:
+			fprintf(stderr, "ERROR: %s:%d: %s.\n", manifest, line, error.c_str());
+			exit(-1);
+		}
+		// the input files and the criteria are checked before any job is run
+		if (! ifstream(job.input.c_str())) {
+			fprintf(stderr, "ERROR: cannot open file %s as input file.\n", job.input.c_str());
+			exit(-1);
+		}
+		job.combiner = new_combiner(strdup(job.objective.c_str()), &criteria_with_property);
+		if (job.combiner == NULL) {
+			fprintf(stderr, "ERROR: %s:%d: unrecognized criteria combination %s.\n", manifest, line, job.objective.c_str());
+			exit(-1);
+		}
+		jobs.push_back(job);
+	}
+}
+
+int run_batch(const char *manifest, ostream &out, int max_workers) {
+	report_phase phase("batch");
+	vector<batch_job> jobs;
+	read_manifest(manifest, jobs);
+
+	vector<pool_worker> pool;
+	start_pool(pool, max_workers, out, vector<int>());
+	map<size_t, string> results;
+	int failures = 0;
+	size_t next = 0, ended = 0;
+	while (ended < jobs.size()) {
+		// a worker receives its next job while it solves the previous one, so that it generates the network meanwhile
+		while (next < jobs.size() && dispatch_job(pool, next, jobs[next].text, -1, 2)) next++;
+		vector<pool_message> messages;
+		receive_pool(pool, messages, -1, out, vector<int>());
+		for (size_t m = 0; m < messages.size(); m++) {
+			const pool_message &message = messages[m];
+			if (! message.end) {
+				results[message.job] = message.result;
+				continue;
+			}
+			// the job exits with an error if it is not solved, it may also crash
+			bool crashed = message.code < 0 || results[message.job].empty();
+			out << "{\"job\": " << message.job + 1 << ", " << job_fields(jobs[message.job]);
+			if (crashed) out << ", \"status\": " << json_string(status_name(ERROR));
+			else out << results[message.job];
+			out << ", \"wall\": " << message.wall << "}" << endl;
+			results.erase(message.job);
+			if (crashed || message.code != 0) failures++;
+			ended++;
+		}
+	}
+	stop_pool(pool);
+	return failures;
+}
+
+//----------------------------------------------------------------------------------------------------
+// Daemon
+//----------------------------------------------------------------------------------------------------
+
+// the clients have a few seconds to send their request
+#define REQUEST_TIMEOUT 5
+
+// A client whose request line is not complete yet
+struct pending_request {
+	string request;
+	phase_timer timer;
+};
+
+// read what a client has sent of its request line (the socket does not block)
+// return 1 if the request is complete, 0 if it is not complete yet, -1 if the client sent no valid request
+static int read_request(int fd, string &request) {
+	char buffer[512];
+	ssize_t n;
+	while ((n = read(fd, buffer, sizeof(buffer))) > 0) {
+		char *end = (char *) memchr(buffer, '\n', n);
+		request.append(buffer, end ? end - buffer : n);
+		if (request.size() > 4096) return -1;
+		if (end) return 1;
+	}
+	if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) return 0;
+	// the client has closed its side of the socket
+	return request.empty() ? -1 : 1;
+}
+
+// only the user running the daemon (or root) may stop it
+static bool may_quit(int fd) {
+	struct ucred credentials;
+	socklen_t length = sizeof(credentials);
+	if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &credentials, &length) == -1) return false;
+	return credentials.uid == 0 || credentials.uid == getuid();
+}
+
+// answer an error to a client
+static void reject_request(int fd, const string &error) {
+	write_all(fd, "{\"event\": \"result\", \"status\": " + json_string(status_name(ERROR)) + ", \"error\": " + json_string(error) + "}\n");
+	close(fd);
+}
+
+int run_daemon(const char *socket_path, int max_workers) {
+	int server = socket(AF_UNIX, SOCK_STREAM, 0);
+	struct sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	if (server == -1 || strlen(socket_path) >= sizeof(address.sun_path)) {
+		fprintf(stderr, "ERROR: cannot create the socket %s.\n", socket_path);
+		exit(-1);
+	}
+	strcpy(address.sun_path, socket_path);
+	unlink(socket_path);
+	if (bind(server, (struct sockaddr *) &address, sizeof(address)) == -1 || listen(server, 64) == -1) {
+		perror("run_daemon: bind");
+		exit(-1);
+	}
+	// a client may leave before its result
+	signal(SIGPIPE, SIG_IGN);
+	if (verbosity >= DEFAULT) cout << "c LISTENING " << socket_path << endl;
+
+	deque< pair<int, batch_job> > queue;
+	map<int, pending_request> pending;
+	map<size_t, int> running;     // client sockets of the requests sent to the workers
+	size_t requests = 0;
+	vector<pool_worker> pool;
+	start_pool(pool, max_workers, cout, vector<int>(1, server));
+	bool listening = true;
+	while (listening || ! queue.empty() || ! running.empty()) {
+		// end the requests (a worker started again does not keep the sockets of the daemon)
+		vector<int> inherited(1, server);
+		for (map<int, pending_request>::iterator it = pending.begin(); it != pending.end(); it++) inherited.push_back(it->first);
+		for (size_t q = 0; q < queue.size(); q++) inherited.push_back(queue[q].first);
+		for (map<size_t, int>::iterator it = running.begin(); it != running.end(); it++) inherited.push_back(it->second);
+		vector<pool_message> messages;
+		receive_pool(pool, messages, listening ? 0 : 10, cout, inherited);
+		for (size_t m = 0; m < messages.size(); m++) {
+			if (! messages[m].end) continue;
+			int fd = running[messages[m].job];
+			running.erase(messages[m].job);
+			if (messages[m].code != 0) reject_request(fd, "the worker failed");
+			else close(fd);
+		}
+		// start the queued requests on the idle workers
+		while (! queue.empty() && dispatch_job(pool, requests, queue.front().second.text, queue.front().first, 1)) {
+			running[requests++] = queue.front().first;
+			queue.pop_front();
+		}
+		if (! listening) continue;
+		// accept the clients and read their requests without blocking
+		vector<struct pollfd> polled(1);
+		polled[0].fd = server;
+		polled[0].events = POLLIN;
+		polled[0].revents = 0;
+		for (map<int, pending_request>::iterator it = pending.begin(); it != pending.end(); it++) {
+			struct pollfd p = {it->first, POLLIN, 0};
+			polled.push_back(p);
+		}
+		if (poll(&polled[0], polled.size(), 100) == -1) continue;
+		if (polled[0].revents & POLLIN) {
+			int fd = accept(server, NULL, NULL);
+			if (fd != -1) {
+				fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+				pending[fd] = pending_request();
+			}
+		}
+		for (size_t i = 1; i < polled.size() && listening; i++) {
+			int fd = polled[i].fd;
+			int complete = polled[i].revents ? read_request(fd, pending[fd].request) : 0;
+			if (complete == 0 && pending[fd].timer.wall() < REQUEST_TIMEOUT) continue;
+			string request = pending[fd].request, error;
+			pending.erase(fd);
+			batch_job job;
+			if (complete != 1) {
+				reject_request(fd, "no request");
+			} else if (request == "quit") {
+				if (may_quit(fd)) {
+					// the queued requests are still solved
+					listening = false;
+					close(fd);
+				} else reject_request(fd, "only the owner of the daemon can stop it");
+			} else if (parse_job(request, job, error) != 1) {
+				reject_request(fd, error.empty() ? "empty request" : error);
+			} else if (! ifstream(job.input.c_str())) {
+				reject_request(fd, "cannot open file " + job.input);
+			} else {
+				// the worker writes its events in blocking mode
+				fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+				queue.push_back(make_pair(fd, job));
+				ostringstream line;
+				line << "{\"event\": \"queued\", \"position\": " << queue.size() << "}" << endl;
+				write_all(fd, line.str());
+			}
+		}
+		if (! listening) {
+			// the clients which have not sent their request yet are not served
+			for (map<int, pending_request>::iterator it = pending.begin(); it != pending.end(); it++)
+				reject_request(it->first, "the daemon is stopping");
+			pending.clear();
+		}
+	}
+	stop_pool(pool);
+	close(server);
+	unlink(socket_path);
+	return 0;
+}
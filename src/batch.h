@@ -0,0 +1,49 @@
+/*******************************************************/
+/* oPoSSuM solver: batch.h                             */
+/* Batch of problems solved by a single invocation     */
+/* (c) Arnaud Malapert I3S (UNS-CNRS) 2012             */
+/*******************************************************/
+
+// A manifest lists the jobs of a batch, one per line (empty lines and lines starting with # are ignored):
+//   <input_file> <seed> <criteria combination> [<solver> [<time limit>]]
+// where <solver> is -cplex, -highs, -glpk, -lpsolve, -lp:<lpsolver> or - (default solver).
+// The jobs are solved by a pool of -jobs workers which live as long as the batch: each worker reads the input files
+// and opens the environment of a solver (CPLEX) once, and solves each of its jobs in a forked process.
+// A worker generates the network of its next job while the previous one is solved.
+// Each job is reported as a JSON object on a single line, in the order in which the jobs end.
+//
+// The daemon listens on a Unix domain socket. A client sends a job on a single line within a few seconds
+// (or quit to stop the daemon, which is only accepted from the user running the daemon)
+// and receives JSON lines: the queued and running events, a level event at the end of each objective level,
+// and the result event. The queued jobs are sent to the idle workers of the pool, which lives as long as the daemon.
+
+#ifndef _BATCH_H
+#define _BATCH_H
+
+#include <abstract_solver.h>
+#include <combiner.h>
+#include <evaluator.h>
+
+// create the solver selected by a command line option, the default solver if NULL (see opossum.c)
+extern abstract_solver *create_solver(const char *option, char *lpsolver);
+
+// open the environment of the solver selected by a command line option once by process, the default solver if NULL (see opossum.c)
+extern void open_solver_environment(const char *option);
+
+// create the criteria combiner described by a command line option, NULL if it is not a combiner (see opossum.c)
+extern abstract_combiner *new_combiner(char *descr, vector<abstract_criteria *> *criteria_with_property);
+
+// evaluate the placement of a solution of a model with merged leaves (see PSLProblem::aggregateLeaves)
+// on the network generated again from the last parsed input and the seed without merging the leaves,
+// return SAT if the placement is feasible, UNKNOWN otherwise (the objective of the model is only a bound, see opossum.c);
+// the evaluator gives the objectives of the combination descr for the placement (none if it requires additional columns)
+extern int evaluate_merged_leaves(PSLProblem *problem, abstract_solver *solver, unsigned int seed, char *descr, placement_evaluator &evaluator);
+
+// run the jobs of a manifest with at most max_workers concurrent solves
+// return the number of jobs which ended with an error
+extern int run_batch(const char *manifest, ostream &out, int max_workers);
+
+// serve the jobs sent on a Unix domain socket with at most max_workers concurrent solves (until a quit request)
+extern int run_daemon(const char *socket_path, int max_workers);
+
+#endif
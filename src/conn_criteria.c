@@ -11,8 +11,9 @@
 // Criteria initialization
 void conn_criteria::initialize(PSLProblem *problem, abstract_solver *solver) {
 	stage_range.set_min_limit(0);
-	stage_range.set_max_limit(problem->stageCount() - 1);
+	stage_range.set_max_limit(problem->originalStageCount() - 1);
 	length_range.set_min_limit(1); //Ignore local connections
+	stage_weights = stage_weights_of(problem, stage_range);
 	pslp_criteria::initialize(problem, solver);
 }
 
@@ -31,7 +32,7 @@ int conn_criteria::rank(pair<FacilityNode*,FacilityNode*> const &path, const uns
 }
 
 // Computing the number of columns required to handle the criteria
-int conn_criteria::set_variable_range(int first_free_var) {
+Rank conn_criteria::set_variable_range(Rank first_free_var) {
 	return first_free_var;
 }
 
@@ -41,8 +42,15 @@ int conn_criteria::set_variable_range(int first_free_var) {
 int conn_criteria::add_criteria_to_objective(CUDFcoefficient lambda) {
 	for (PathIterator p = problem->getRoot()->pbegin(); p != problem->getRoot()->pend(); ++p) {
 		if(isRLSelected(*p)) {
-			for (int s = stage_range.min(); s <= stage_range.max(); ++s) {
-				set_obj_coeff(rank(*p, s), lambda);
+			for (unsigned int s = 0; s < problem->stageCount(); ++s) {
+				if(stage_weights[s] == 0) continue;
+				set_obj_coeff(rank(*p, s), lambda * stage_weights[s]);
+				if(flow_formulation) {
+					// the flows leaving the destination do not belong to the path
+					for(LinkListIterator l = (*p).second->cbegin(); l != (*p).second->cend() ; l++) {
+						if(problem->hasPath((*p).first, (*l)->getDestination())) set_obj_coeff(rank(make_pair((*p).first, (*l)->getDestination()), s), -lambda * stage_weights[s]);
+					}
+				}
 			}
 		}
 	}
@@ -53,8 +61,15 @@ int conn_criteria::add_criteria_to_objective(CUDFcoefficient lambda) {
 int conn_criteria::add_criteria_to_constraint(CUDFcoefficient lambda) {
 	for (PathIterator p = problem->getRoot()->pbegin(); p != problem->getRoot()->pend(); ++p) {
 		if(isRLSelected(*p)) {
-			for (int s = stage_range.min(); s <= stage_range.max(); ++s) {
-				set_constraint_coeff(rank(*p, s), lambda);
+			for (unsigned int s = 0; s < problem->stageCount(); ++s) {
+				if(stage_weights[s] == 0) continue;
+				if(flow_formulation) {
+					// the coefficients of the paths sharing a source are accumulated
+					add_constraint_coeff(rank(*p, s), lambda * stage_weights[s]);
+					for(LinkListIterator l = (*p).second->cbegin(); l != (*p).second->cend() ; l++) {
+						if(problem->hasPath((*p).first, (*l)->getDestination())) add_constraint_coeff(rank(make_pair((*p).first, (*l)->getDestination()), s), -lambda * stage_weights[s]);
+					}
+				} else set_constraint_coeff(rank(*p, s), lambda * stage_weights[s]);
 			}
 		}
 	}
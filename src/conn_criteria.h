@@ -16,6 +16,8 @@ class conn_criteria: public pslp_criteria{
 public:
 
 	param_range stage_range;
+	// number of groups of each stage within the stage range (see PSLProblem::aggregateGroups)
+	IntList stage_weights;
 	param_range length_range;
 
 	conn_criteria(CUDFcoefficient lambda_crit, int reliable, param_range stage_range, param_range length_range) : pslp_criteria(lambda_crit, reliable), stage_range(stage_range), length_range(length_range) {};
@@ -25,7 +27,7 @@ public:
 	// Criteria initialization
 	void initialize(PSLProblem *problem, abstract_solver *solver);
 	// Allocate some columns for the criteria
-	int set_variable_range(int first_free_var);
+	Rank set_variable_range(Rank first_free_var);
 	// Add the criteria to the objective
 	int add_criteria_to_objective(CUDFcoefficient lambda);
 	// Add the criteria to the constraint set
@@ -39,8 +41,13 @@ protected :
 
 private :
 
+	// accumulate a coefficient of the current constraint
+	inline void add_constraint_coeff(int rank, CUDFcoefficient value) {
+		solver->set_constraint_coeff(rank, lambda_crit * value + solver->get_constraint_coeff(rank));
+	}
+
 	inline bool isRLSelected(pair<FacilityNode*, FacilityNode*> const &path) {
-		if(length_range.contains(path.second->getType()->getLevel() - path.first->getType()->getLevel())) {
+		if(problem->hasPath(path.first, path.second) && length_range.contains(path.second->getType()->getLevel() - path.first->getType()->getLevel())) {
 			return reliable == RELIABLE ? isReliablePath(path.first, path.second) :
 					reliable == NON_RELIABLE ? isReliablePath(path.first, path.second) : true;
 		}
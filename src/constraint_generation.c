@@ -7,6 +7,8 @@
 // translate a PSL problem in a MILP problem
 
 #include <constraint_generation.h>
+#include <model_stats.h>
+#include <run_report.h>
 
 
 
@@ -30,6 +32,7 @@ public:
 	inline unsigned int getVarType() const { return varBorZ; }
 	inline void setVarType(bool varBorZ) { this->varBorZ = varBorZ; };
 	void operator()(FacilityNode* s, FacilityNode* d) {
+		if( ! problem->hasPath(s, d)) return;
 		int rank = varBorZ ? problem->rankB(s, d, stage) : problem->rankZ(s, d, stage);
 		solver->set_constraint_coeff(rank, 1);
 		;
@@ -43,35 +46,173 @@ private:
 
 };
 
-// Generate MILP objective function(s) and constraints for a given solver
-// and a given criteria combination
-int generate_constraints(PSLProblem *problem, abstract_solver &solver, abstract_combiner &combiner) {
+// Set the coefficient of the connections (or of the bandwidth if varB) of a path.
+// With the flow formulation, the column of a path is the flow from its source entering the subtree of its destination,
+// so that the path carries the flow which does not leave its destination.
+// A link row then holds the flows of the ancestors of its destination instead of the paths crossing it, which only pays off
+// on deep networks: the path rows get the flows of the children, and the model of a generated instance is larger (see benchmarks/compare.sh).
+static void set_path_coeff(PSLProblem *problem, abstract_solver &solver, FacilityNode *source, FacilityNode *destination, unsigned int stage, bool varB, CUDFcoefficient value) {
+	solver.set_constraint_coeff(varB ? problem->rankB(source, destination, stage) : problem->rankZ(source, destination, stage), value);
+	if(flow_formulation) {
+		for(LinkListIterator l = destination->cbegin(); l != destination->cend() ; l++) {
+			FacilityNode *child = (*l)->getDestination();
+			if(problem->hasPath(source, child)) solver.set_constraint_coeff(varB ? problem->rankB(source, child, stage) : problem->rankZ(source, child, stage), -value);
+		}
+	}
+}
+
+CUDFcoefficient path_connections(PSLProblem *problem, abstract_solver &solver, FacilityNode *source, FacilityNode *destination, unsigned int stage) {
+	CUDFcoefficient connections = solver.get_solution(problem->rankZ(source, destination, stage));
+	if(flow_formulation) {
+		for(LinkListIterator l = destination->cbegin(); l != destination->cend() ; l++) {
+			if(problem->hasPath(source, (*l)->getDestination())) connections -= solver.get_solution(problem->rankZ(source, (*l)->getDestination(), stage));
+		}
+	}
+	return connections;
+}
+
+double path_bandwidth(PSLProblem *problem, abstract_solver &solver, FacilityNode *source, FacilityNode *destination, unsigned int stage) {
+	double bandwidth = solver.get_real_solution(problem->rankB(source, destination, stage));
+	if(flow_formulation) {
+		for(LinkListIterator l = destination->cbegin(); l != destination->cend() ; l++) {
+			if(problem->hasPath(source, (*l)->getDestination())) bandwidth -= solver.get_real_solution(problem->rankB(source, (*l)->getDestination(), stage));
+		}
+	}
+	return bandwidth;
+}
+
+// abort if the network can not be translated
+static void check_network(PSLProblem *problem) {
 	if ( ! problem->getRoot() ) { // we lack a problem then ...
 		fprintf(stderr, "generate_constraints: no declared network !\n");
 		exit(-1);
 	}
+	// the solvers use 32 bits column indices
+	if ( ! problem->hasCompactRanks() ) {
+		fprintf(stderr, "generate_constraints: too many variables for the solver (%lld) !\n", problem->rankCount());
+		exit(-1);
+	}
+}
+
+// Set finite upper bounds on the columns of the network (see column_bounds)
+void set_column_bounds(PSLProblem *problem, abstract_solver &solver) {
+	int stages = problem->stageCount();
+	// nodes in preorder, so that a subtree is summed up before its root
+	vector<FacilityNode *> nodes;
+	for(NodeIterator i = problem->nbegin() ; i!=  problem->nend() ; i++) nodes.push_back(*i);
+	// demand (stages > 0) or number of pservers (stage 0) of each subtree
+	vector<CUDFcoefficient> subtree(problem->nodeCount() * stages, 0);
+	for (int n = nodes.size() - 1; n >= 0; --n) {
+		FacilityNode *i = nodes[n];
+		CUDFcoefficient *sums = &subtree[i->getID() * stages];
+		sums[0] += i->getType()->getTotalCapacity();
+		for (int s = 1; s < stages; ++s) sums[s] += i->getType()->getDemand(s - 1);
+		if(! i->isRoot()) {
+			CUDFcoefficient *father = &subtree[i->toFather()->getOrigin()->getID() * stages];
+			for (int s = 0; s < stages; ++s) father[s] += sums[s];
+		}
+	}
+
+	for (size_t n = 0; n < nodes.size(); ++n) {
+		FacilityNode *i = nodes[n];
+		CUDFcoefficient connections = 0;
+		for (int k = 0; k < problem->serverTypeCount(); ++k) {
+			solver.set_intvar_range(problem->rankX(i, k), 0, i->getType()->getServerCapacity(k));
+			connections += i->getType()->getServerCapacity(k) * problem->getServer(k)->getMaxConnections();
+		}
+		solver.set_intvar_range(problem->rankX(i), 0, i->getType()->getTotalCapacity());
+		for (int s = 0; s < stages; ++s) {
+			// the connections provided by a facility are limited by its pservers
+			solver.set_intvar_range(problem->rankY(i, s), 0, connections);
+			// the local connections are limited by the local demand
+			solver.set_intvar_range(problem->rankZ(i, s), 0, s == 0 ? i->getType()->getTotalCapacity() : i->getType()->getDemand(s - 1));
+		}
+		if(! i->isRoot()) {
+			// the connections entering a subtree are limited by its demand
+			for (int s = 0; s < stages; ++s) {
+				solver.set_intvar_range(problem->rankY(i->toFather(), s), 0, subtree[i->getID() * stages + s]);
+			}
+		}
+	}
+
+	for (size_t n = 0; n < nodes.size(); ++n) {
+		FacilityNode *i = nodes[n];
+		if( ! i->isLeaf()) {
+			NodeIterator j = i->nbegin();
+			j++;
+			while(j !=  i->nend()) {
+				// the connections of a path are limited by the demand of its destination (of its subtree for a flow),
+				// and the bandwidth of a path by the last link of the path
+				for (int s = 0; problem->hasPath(i, *j) && s < stages; ++s) {
+					CUDFcoefficient demand = flow_formulation ? subtree[j->getID() * stages + s] :
+							s == 0 ? j->getType()->getTotalCapacity() : j->getType()->getDemand(s - 1);
+					solver.set_intvar_range(problem->rankZ(i, *j, s), 0, demand);
+					solver.set_realvar_range(problem->rankB(i, *j, s), 0, min(demand * max_bandwidth, (CUDFcoefficient) j->toFather()->getBandwidth()));
+				}
+				j++;
+			}
+		}
+	}
+}
+
+// Generate MILP objective function(s) and constraints for a given solver
+// and a given criteria combination
+int generate_constraints(PSLProblem *problem, abstract_solver &solver, abstract_combiner &combiner, const milp_model *structure) {
+	check_network(problem);
+	report_phase phase("generate_constraints");
 
 	//----------------------------------------------------------------------------------------------------
 	// Objective function
-	int nb_vars=problem->rankCount();
-	nb_vars = combiner.column_allocation(nb_vars);
+	int phase_objectives = the_report.begin_phase("objectives");
+	// the columns are counted with 64 bits integers before being handed to the 32 bits indices of the solvers
+	Rank nb_vars = combiner.column_allocation(problem->rankCount());
+	if ( nb_vars < problem->rankCount() || nb_vars > INT_MAX ) {
+		fprintf(stderr, "generate_constraints: too many additional variables for the solver !\n");
+		exit(-1);
+	}
 	int other_vars=nb_vars - problem->rankCount();
 	solver.init_solver(problem, other_vars);
+	if(column_bounds) set_column_bounds(problem, solver);
 	solver.begin_objectives();
 	combiner.objective_generation();
 	solver.end_objectives();
+	the_report.end_phase(phase_objectives);
 
 	//----------------------------------------------------------------------------------------------------
 	// Constraints generation
 
+	int phase_constraints = the_report.begin_phase("constraints");
 	solver.begin_add_constraints();
 
 	combiner.constraint_generation();
+	if(structure) structure->replay_rows(solver);
+	else generate_structural_constraints(problem, solver);
+	solver.end_add_constraints();
+	the_report.end_phase(phase_constraints);
+	return 0;
+}
+
+// Record the structural constraints once, so that they are shared by several criteria combinations
+int record_structural_constraints(PSLProblem *problem, milp_model &structure) {
+	check_network(problem);
+	report_phase phase("structure");
+	abstract_solver none;
+	model_recorder recorder(&none, &structure);
+	recorder.init_solver(problem, 0);
+	recorder.begin_add_constraints();
+	generate_structural_constraints(problem, recorder);
+	recorder.end_add_constraints();
+	return 0;
+}
+
+// Generate the constraints of the network which do not depend on the criteria
+void generate_structural_constraints(PSLProblem *problem, abstract_solver &solver) {
 	//TODO access node/link iterator directly thru the problem
 	///////////////////////
 	//for each facility ...
 	///////////////////////
 	for(NodeIterator i = problem->nbegin() ; i!=  problem->nend() ; i++) {
+		stats_scope family(FAMILY_SERVER_COUNT);
 		///////////
 		//compute the total number of servers at facilities
 		solver.new_constraint();
@@ -80,9 +221,10 @@ int generate_constraints(PSLProblem *problem, abstract_solver &solver, abstract_
 			solver.set_constraint_coeff( problem->rankX(*i, k), 1);
 		}
 		solver.add_constraint_eq(0);
+		family.enter(FAMILY_CAPACITY);
 		///////////
-		//limit the number of servers of a given type at facilities
-		for (int k = 0; k < problem->serverTypeCount(); ++k) {
+		//limit the number of servers of a given type at facilities (unless the columns are bounded)
+		for (int k = 0; ! column_bounds && k < problem->serverTypeCount(); ++k) {
 			solver.new_constraint();
 			solver.set_constraint_coeff( problem->rankX(*i, k), 1);
 			solver.add_constraint_leq(i->getType()->getServerCapacity(k));
@@ -98,13 +240,14 @@ int generate_constraints(PSLProblem *problem, abstract_solver &solver, abstract_
 			solver.add_constraint_geq(0);
 		}
 
+		family.enter(FAMILY_LOCAL);
 		///////////
 		//Number of local connections
 		for (int s = 0; s < problem->stageCount(); ++s) {
 			solver.new_constraint();
 			solver.set_constraint_coeff(problem->rankZ(*i, s),1);
-			for(AncestorIterator p = i->abegin() ; p!=  i->aend() ; p++) {
-				solver.set_constraint_coeff( problem->rankZ(*p, *i, s), 1);
+			for(AncestorIterator p = i->abegin() ; p!=  i->aend() && problem->hasPath(*p, *i) ; p++) {
+				set_path_coeff(problem, solver, *p, *i, s, false, 1);
 			}
 			if(s == 0) {
 				//special case: initial broadcast (s=0)
@@ -123,17 +266,20 @@ int generate_constraints(PSLProblem *problem, abstract_solver &solver, abstract_
 		//Additional constraints for the initial broadcast(s=0)
 		if(i->isRoot()) {
 			//the central facility contains the root pserver
+			family.enter(FAMILY_SERVER_COUNT);
 			solver.new_constraint();
 			solver.set_constraint_coeff( problem->rankX(*i, 0), 1);
 			solver.add_constraint_geq(1);
 		} else {
 			//other facilities only receive the initial broadcast
+			family.enter(FAMILY_CAPACITY);
 			solver.new_constraint();
 			solver.set_constraint_coeff( problem->rankY(*i, 0), 1);
 			solver.add_constraint_eq(0);
 		}
 
 
+		family.enter(FAMILY_FLOW);
 		///////////
 		//connections flow conservation
 		//special case: initial broadcast (s=0)
@@ -171,19 +317,31 @@ int generate_constraints(PSLProblem *problem, abstract_solver &solver, abstract_
 	for (int s = 0; s < problem->groupCount() + 1; ++s) {
 		setPC.setStage(s);
 		for(LinkIterator l = problem->lbegin() ; l!=  problem->lend() ; l++) {
+			FacilityNode *destination = l->getDestination();
+			stats_scope family(FAMILY_LINK_BANDWIDTH);
 			///////////
 			//bandwidth passing through the link
 			setPC.setVarType(true);
 			solver.new_constraint();
-			l->forEachPath(setPC);
+			if(flow_formulation) {
+				//the flows entering the subtree of the destination
+				for(AncestorIterator p = destination->abegin() ; p!=  destination->aend() && problem->hasPath(*p, destination) ; p++) {
+					solver.set_constraint_coeff(problem->rankB(*p, destination, s), 1);
+				}
+			} else l->forEachPath(setPC);
 			solver.add_constraint_leq(l->getBandwidth());
 
+			family.enter(FAMILY_LINK_CONNECTIONS);
 			///////////
 			//number of connections passing through the link
 			setPC.setVarType(false);
 			solver.new_constraint();
 			solver.set_constraint_coeff(problem->rankY(*l, s), -1);
-			l->forEachPath(setPC);
+			if(flow_formulation) {
+				for(AncestorIterator p = destination->abegin() ; p!=  destination->aend() && problem->hasPath(*p, destination) ; p++) {
+					solver.set_constraint_coeff(problem->rankZ(*p, destination, s), 1);
+				}
+			} else l->forEachPath(setPC);
 			solver.add_constraint_eq(0);
 		}
 	}
@@ -199,25 +357,42 @@ int generate_constraints(PSLProblem *problem, abstract_solver &solver, abstract_
 			while(j !=  i->nend()) {
 				///////////
 				//for each stage ...
-				for (int s = 0; s < problem->stageCount(); ++s) {
+				stats_scope family(FAMILY_PATH_BANDWIDTH);
+				//(with the flow formulation, the connections of a path are non negative since min_bandwidth < max_bandwidth)
+				for (int s = 0; problem->hasPath(*i, *j) && s < problem->stageCount(); ++s) {
 					///////////
 					//minimal bandwidth for a single connection
 					solver.new_constraint();
-					solver.set_constraint_coeff(problem->rankB(*i, *j, s), 1);
-					solver.set_constraint_coeff(problem->rankZ(*i, *j, s), - min_bandwidth);
+					set_path_coeff(problem, solver, *i, *j, s, true, 1);
+					set_path_coeff(problem, solver, *i, *j, s, false, - min_bandwidth);
 					solver.add_constraint_geq(0);
 					///////////
 					//maximal bandwidth for a single connection
 					solver.new_constraint();
-					solver.set_constraint_coeff(problem->rankB(*i, *j, s), 1);
-					solver.set_constraint_coeff(problem->rankZ(*i, *j, s), - max_bandwidth);
+					set_path_coeff(problem, solver, *i, *j, s, true, 1);
+					set_path_coeff(problem, solver, *i, *j, s, false, - max_bandwidth);
 					solver.add_constraint_leq(0);
 				}
 				j++;
 			}
 		}
 	}
-	solver.end_add_constraints();
-	return 0;
+
+	if(symmetry_breaking) {
+		stats_scope family(FAMILY_SYMMETRY);
+		///////////////////////
+		//for each group of isomorphic siblings ...
+		///////////////////////
+		//any solution can be permuted so that their numbers of servers are non increasing
+		vector<FacilityList> groups = problem->isomorphicSiblings();
+		for (size_t g = 0; g < groups.size(); ++g) {
+			for (size_t k = 1; k < groups[g].size(); ++k) {
+				solver.new_constraint();
+				solver.set_constraint_coeff(problem->rankX(groups[g][k - 1]), 1);
+				solver.set_constraint_coeff(problem->rankX(groups[g][k]), -1);
+				solver.add_constraint_geq(0);
+			}
+		}
+	}
 }
 
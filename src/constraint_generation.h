@@ -12,6 +12,7 @@
 #include <abstract_solver.h>
 #include <criteria.h>
 #include <combiner.h>
+#include <milp_model.h>
 
 
 extern int new_var;
@@ -20,7 +21,21 @@ extern CUDFcoefficient max_bandwidth;
 
 
 // main function for constraint generation (translate a CUDF problem into MILP problem for a given solver and a given criteria)
-extern int generate_constraints(PSLProblem *problem, abstract_solver &solver, abstract_combiner &combiner);
+// the structural constraints are replayed from a recorded model if any (see record_structural_constraints)
+extern int generate_constraints(PSLProblem *problem, abstract_solver &solver, abstract_combiner &combiner, const milp_model *structure = NULL);
+
+// set finite upper bounds on the columns of the network (capacities, subtree demands and link bandwidths)
+extern void set_column_bounds(PSLProblem *problem, abstract_solver &solver);
+
+// connections and bandwidth of a path in a solution (see flow_formulation)
+extern CUDFcoefficient path_connections(PSLProblem *problem, abstract_solver &solver, FacilityNode *source, FacilityNode *destination, unsigned int stage);
+extern double path_bandwidth(PSLProblem *problem, abstract_solver &solver, FacilityNode *source, FacilityNode *destination, unsigned int stage);
+
+// record the structural constraints (server counts, capacities, flows, links and paths) which do not depend on the criteria
+extern int record_structural_constraints(PSLProblem *problem, milp_model &structure);
+
+// generate the structural constraints into a solver (between begin_add_constraints and end_add_constraints)
+extern void generate_structural_constraints(PSLProblem *problem, abstract_solver &solver);
 
 
 #endif
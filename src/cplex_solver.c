@@ -13,6 +13,27 @@
 // solver creation 
 abstract_solver *new_cplex_solver() { return new cplex_solver(); }
 
+// the environment is opened once by process and shared by its solvers,
+// so that a worker of the batch or of the daemon opens it before forking its jobs (see batch.h)
+static CPXENVptr cplex_environment = NULL;
+
+static CPXENVptr shared_environment() {
+	if (cplex_environment == NULL) {
+		int status;
+		cplex_environment = CPXopenCPLEX (&status);
+		if ( cplex_environment == NULL ) {
+			char  errmsg[1024];
+			fprintf (stderr, "Could not open CPLEX environment.\n");
+			CPXgeterrorstring (NULL, status, errmsg);
+			fprintf (stderr, "%s", errmsg);
+			exit(-1);
+		}
+	}
+	return cplex_environment;
+}
+
+void open_cplex_environment() { shared_environment(); }
+
 // solver initialisation 
 // requires the list of versioned packages and the total amount of variables (including additional ones)
 int cplex_solver::init_solver(PSLProblem *problem, int other_vars) {
@@ -20,19 +41,14 @@ int cplex_solver::init_solver(PSLProblem *problem, int other_vars) {
 	_solutionCount = 0;
 	_nodeCount = 0;
 	_timeCount = 0;
+	this->problem = problem;
+	lazy_names = false;
 
 	// Coefficient initialization
 	initialize_coeffs(problem->rankCount() + other_vars);
 
 	/* Initialize the CPLEX environment */
-	env = CPXopenCPLEX (&status);
-	if ( env == NULL ) {
-		char  errmsg[1024];
-		fprintf (stderr, "Could not open CPLEX environment.\n");
-		CPXgeterrorstring (env, status, errmsg);
-		fprintf (stderr, "%s", errmsg);
-		exit(-1);
-	}
+	env = shared_environment();
 
 	/* Set the value of the time limit*/
 	status = CPXsetdblparam (env, CPX_PARAM_TILIM, time_limit);
@@ -48,10 +64,10 @@ int cplex_solver::init_solver(PSLProblem *problem, int other_vars) {
 		exit(-1);
 	}
 
-	/* Limit the number of thread to 1 */
-	status = CPXsetintparam (env, CPX_PARAM_THREADS, 1);
+	/* Limit the number of threads (1 by default) */
+	status = CPXsetintparam (env, CPX_PARAM_THREADS, solver_threads);
 	if ( status ) {
-		fprintf (stderr, "Failure to set thread limit to 1, error %d.\n", status);
+		fprintf (stderr, "Failure to set thread limit to %d, error %d.\n", solver_threads, status);
 		exit(-1);
 	}
 
@@ -104,6 +120,7 @@ int cplex_solver::init_solver(PSLProblem *problem, int other_vars) {
 		fprintf(stderr, "cplex_solver: initialization: not enough memory.\n");
 		exit(-1);
 	}
+	memory_alloc(MEM_SOLVER, nb_vars * (2 * sizeof(double) + sizeof(char) + sizeof(char *)));
 
 	init_vars(problem, nb_vars);
 	return 0;
@@ -162,13 +179,37 @@ int cplex_solver::set_boolvar(int rank, char* name) {
 	return 0;
 }
 
+// Name the columns once from their rank (if the variables were created without names)
+void cplex_solver::name_columns() {
+	if(variable_names || lazy_names) return;
+	lazy_names = true;
+	int nb_names = problem->rankCount() < nb_vars ? problem->rankCount() : nb_vars;
+	if(nb_names <= 0) return;
+	int *indices = (int *)malloc(nb_names * sizeof(int));
+	if(indices == (int *)NULL) {
+		fprintf(stderr, "cplex_solver: name_columns: not enough memory.\n");
+		exit(-1);
+	}
+	for (int k = 0; k < nb_names; k++) {
+		indices[k] = k;
+		varname[k] = strdup(problem->rankName(k).c_str());
+		memory_alloc(MEM_NAMES, strlen(varname[k]) + 1);
+	}
+	int status = CPXchgcolname(env, lp, nb_names, indices, varname);
+	if (status) fprintf(stderr, "cplex_solver: name_columns: cannot name the columns (error %d).\n", status);
+	free(indices);
+}
+
 // Just write the lp problem in a file
 int cplex_solver::writelp(char *filename) { 
+	trace_span span(filename, "writer");
+	name_columns();
 	return CPXwriteprob (env, lp, filename, NULL);
 }
 
 // Just write the solution in a file
 int cplex_solver::writesol(char *filename) {
+	trace_span span(filename, "writer");
 	return CPXsolwrite(env, lp, filename);
 }
 
@@ -180,21 +221,27 @@ int cplex_solver::solve() {
 	int mipstat, status;
 
 	// Presolving the problem
-	time_t ptime = time(NULL);
-	if (CPXpresolve(env, lp, CPX_ALG_NONE)) return 0;
-	time_t ctime = time(NULL);
-	_timeCount += difftime(ctime, ptime);
+	phase_timer timer;
+	{
+		report_phase phase("presolve");
+		if (CPXpresolve(env, lp, CPX_ALG_NONE)) return 0;
+	}
+	_timeCount = timer.wall();
 	// Solve the objectives in a lexical order
 	for (int i = first_objective; i < nb_objectives; i++) {
-		ptime = ctime;
+		level_record level(i);
+		the_report.begin_level(level);
 		// Solve the mip problem
 		if (CPXmipopt (env, lp)) return ERROR;
-		ctime = time(NULL);
-		_solutionCount += CPXgetsolnpoolnumsolns(env, lp) + CPXgetsolnpoolnumreplaced(env, lp);
-		_timeCount += difftime(ctime, ptime);
-		_nodeCount += CPXgetnodecnt(env, lp);
+		int solutions = CPXgetsolnpoolnumsolns(env, lp) + CPXgetsolnpoolnumreplaced(env, lp);
+		int nodes = CPXgetnodecnt(env, lp);
+		_solutionCount += solutions;
+		_timeCount = timer.wall();
+		_nodeCount += nodes;
 		// Get solution status
-		if ((mipstat = CPXgetstat(env, lp)) == CPXMIP_OPTIMAL) {
+		mipstat = CPXgetstat(env, lp);
+		report_level(level, mipstat, nodes, solutions);
+		if (mipstat == CPXMIP_OPTIMAL) {
 			if (i < nb_objectives - 1) {
 				// Get next non empty objective
 				// (must be done here to avoid conflicting method calls
@@ -269,6 +316,28 @@ int cplex_solver::solve() {
 	return 0;
 }
 
+// record the statistics of the objective level which has just been solved
+void cplex_solver::report_level(level_record &level, int mipstat, int nodes, int solutions) {
+	level.nodes = nodes;
+	level.solutions = solutions;
+	switch (mipstat) {
+	case CPXMIP_OPTIMAL: level.status = OPTIMUM; break;
+	case CPXMIP_TIME_LIM_FEAS: level.status = SAT; break;
+	case CPXMIP_TIME_LIM_INFEAS: level.status = UNKNOWN; break;
+	case CPXMIP_INFEASIBLE: level.status = UNSAT; break;
+	default: level.status = ERROR; break;
+	}
+	if (solutions > 0) {
+		double gap, objval;
+		if (CPXgetmiprelgap(env, lp, &gap) == 0) level.gap = gap;
+		if (CPXgetobjval(env, lp, &objval) == 0) {
+			level.has_value = true;
+			level.value = objval;
+		}
+	}
+	the_report.end_level(level);
+}
+
 // return the objective value
 CUDFcoefficient cplex_solver::objective_value() { 
 	double objval;
@@ -286,12 +355,16 @@ int cplex_solver::init_solutions() {
 	int status;
 	int cur_numcols = CPXgetnumcols (env, lp);
 
-	if (solution != (double *)NULL) free(solution);
+	if (solution != (double *)NULL) {
+		free(solution);
+		memory_free(MEM_SOLVER, nb_vars*sizeof(double));
+	}
 
 	if ((solution = (double *)malloc(nb_vars*sizeof(double))) == (double *)NULL) {
 		fprintf (stderr, "cplex_solver: init_solutions: cannot get enough memory to store solutions.\n");
 		exit(-1);
 	}
+	memory_alloc(MEM_SOLVER, nb_vars*sizeof(double));
 
 	status = CPXgetx (env, lp, solution, 0, cur_numcols-1);
 	if ( status ) {
@@ -349,7 +422,7 @@ int cplex_solver::end_objectives(void) {
 				coefficients[objectives[first_objective]->sindex[k]] = objectives[first_objective]->coefficients[k];
 		else
 			if (first_objective == (int)objectives.size()) first_objective--; // So that we solve at least one pbs
-		status = CPXnewcols (env, lp, nb_vars, coefficients, lb, ub, vartype, varname);
+		status = CPXnewcols (env, lp, nb_vars, coefficients, lb, ub, vartype, variable_names ? varname : NULL);
 		if (status) {
 			fprintf(stderr, "cplex_solver: end_objective: cannot create objective function.\n");
 			exit(-1);
@@ -438,6 +511,19 @@ int cplex_solver::end_add_constraints(void) {
 	return 0;
 }
 
+// give a starting solution to the solver (cplex completes the additional columns and checks it)
+int cplex_solver::set_mip_start(const vector<double> &start) {
+	int beg = 0;
+	int effort = CPX_MIPSTART_AUTO;
+	vector<int> index(start.size());
+	for (size_t k = 0; k < start.size(); k++) index[k] = k;
+	if (CPXaddmipstarts(env, lp, 1, start.size(), &beg, &index[0], &start[0], &effort, NULL)) {
+		fprintf(stderr, "cplex_solver: set_mip_start: cannot add the starting solution.\n");
+		return -1;
+	}
+	return 0;
+}
+
 int cplex_solver::objectiveCount()
 {
 	return objectives.size();
@@ -12,6 +12,7 @@
 
 #include <abstract_solver.h>
 #include <scoeff_solver.h>
+#include <run_report.h>
 #include <ilcplex/cplex.h>
 
 class cplex_solver: public abstract_solver, public scoeff_solver<double, 0, 0> {
@@ -70,6 +71,9 @@ public:
 	int writelp(char *filename);
 	int writesol(char *filename);
 
+	// Give a starting solution to the solver
+	int set_mip_start(const vector<double> &start);
+
 	// Solve the problem
 	int solve();
 	// Get the objective value (final one)
@@ -101,6 +105,8 @@ public:
 	double *ub;          // array of upper bounds
 	char *vartype;       // array of variable types
 	char **varname;      // array of variable names
+	PSLProblem *problem; // problem (used to generate the variable names on demand)
+	bool lazy_names;     // have the variable names been generated on demand ?
 
 	// Store the solutions
 	double *solution;
@@ -111,6 +117,11 @@ public:
 	}
 
 private:
+	// generate the names of the variables (if disabled during the model construction)
+	void name_columns();
+	// record the statistics of the objective level which has just been solved
+	void report_level(level_record &level, int mipstat, int nodes, int solutions);
+
 	int _solutionCount;
 	int _nodeCount;
 	double _timeCount;
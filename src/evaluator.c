@@ -0,0 +1,482 @@
+/*******************************************************/
+/* oPoSSuM solver: evaluator.c                         */
+/* Evaluation of a placement of the servers            */
+/* (c) Arnaud Malapert I3S (UNS-CNRS) 2012             */
+/*******************************************************/
+
+#include <evaluator.h>
+#include <constraint_generation.h>
+#include <run_report.h>
+#include <fstream>
+#include <sstream>
+#include <map>
+#include <numeric>
+#include <math.h>
+#include <ctype.h>
+
+// solver initialisation
+int placement_evaluator::init_solver(PSLProblem *problem, int other_vars) {
+	if(other_vars > 0) {
+		fprintf(stderr, "ERROR: the evaluation of a placement does not handle the additional variables of the criteria combination.\n");
+		exit(-1);
+	}
+	this->problem = problem;
+	coefficients.assign(problem->rankCount(), 0);
+	objectives.clear();
+	if(filename != NULL) {
+		servers = read_placement(problem, filename);
+	}
+	return 0;
+}
+
+// called before defining a new objective
+int placement_evaluator::new_objective(void) {
+	coefficients.assign(coefficients.size(), 0);
+	return 0;
+}
+
+// called to add a new objective
+int placement_evaluator::add_objective(void) {
+	vector< pair<int, CUDFcoefficient> > objective;
+	for (size_t k = 0; k < coefficients.size(); ++k) {
+		if(coefficients[k] != 0) objective.push_back(make_pair((int) k, coefficients[k]));
+	}
+	objectives.push_back(objective);
+	return 0;
+}
+
+// value of an objective on the evaluated placement
+CUDFcoefficient placement_evaluator::objective_value(int i) {
+	if(i < 0 || i >= objectiveCount()) return 0;
+	double value = 0;
+	for (size_t k = 0; k < objectives[i].size(); ++k) {
+		value += objectives[i][k].second * values[objectives[i][k].first];
+	}
+	return (CUDFcoefficient) nearbyint(value);
+}
+
+// evaluate the placement
+int placement_evaluator::solve() {
+	evaluate(problem, servers);
+	if(verbosity >= DEFAULT) {
+		for (int i = 0; i + 1 < objectiveCount(); ++i) {
+			printf(">>>> Objective value %d = " CUDFflags "\n", i, objective_value(i));
+		}
+		printf("c EVALUATION " CUDFflags " PSERV    " CUDFflags " LOCAL    " CUDFflags " CONN    %.0f BANDW\n",
+				pservCount, localCount, connCount, bandwidth);
+		if(! feasible) {
+			printf("c EVALUATION " CUDFflags " UNCONNECTED CLIENTS\n", unconnected);
+		}
+	}
+	return feasible ? SAT : UNSAT;
+}
+
+CUDFcoefficientList placement_evaluator::read_placement(PSLProblem *problem, const char *filename) {
+	ifstream in(filename);
+	if(! in) {
+		fprintf(stderr, "ERROR: cannot open the placement file %s.\n", filename);
+		exit(-1);
+	}
+	//the node which represents each generated facility
+	map<unsigned int, FacilityNode*> facilities;
+	for(NodeIterator i = problem->nbegin() ; i!=  problem->nend() ; i++) {
+		IntList ids = problem->getOriginalIDs(*i);
+		for (size_t c = 0; c < ids.size(); ++c) {
+			facilities[ids[c]] = *i;
+		}
+	}
+	const unsigned int stypes = problem->serverTypeCount();
+	CUDFcoefficientList servers(problem->nodeCount() * stypes, 0);
+	string line;
+	while(getline(in, line)) {
+		//only the solution lines, i.e. id[servers(/capacity)]{servers of each type}
+		if(line.size() < 2 || line[0] != 's' || ! isspace(line[1])) continue;
+		istringstream tokens(line.substr(1));
+		string token;
+		while(tokens >> token) {
+			if(! isdigit(token[0])) continue;
+			unsigned int id;
+			long long count;
+			char sep;
+			istringstream facility(token);
+			if(! (facility >> id >> sep) || sep != '[' || ! (facility >> count)) {
+				fprintf(stderr, "ERROR: invalid facility %s in the placement file %s.\n", token.c_str(), filename);
+				exit(-1);
+			}
+			if(facilities.find(id) == facilities.end()) {
+				fprintf(stderr, "ERROR: facility %u of the placement file %s is not in the network.\n", id, filename);
+				exit(-1);
+			}
+			FacilityNode *node = facilities[id];
+			size_t types = token.find('{');
+			if(types == string::npos) {
+				if(stypes > 1) {
+					fprintf(stderr, "ERROR: missing server types of the facility %u in the placement file %s.\n", id, filename);
+					exit(-1);
+				}
+				servers[node->getID() * stypes] += count;
+			} else {
+				istringstream counts(token.substr(types + 1));
+				for (unsigned int k = 0; k < stypes; ++k) {
+					if(! (counts >> count >> sep) || sep != (k + 1 < stypes ? ',' : '}')) {
+						fprintf(stderr, "ERROR: invalid server types of the facility %u in the placement file %s.\n", id, filename);
+						exit(-1);
+					}
+					servers[node->getID() * stypes + k] += count;
+				}
+			}
+		}
+	}
+	return servers;
+}
+
+bool placement_evaluator::evaluate(PSLProblem *problem, const CUDFcoefficientList &servers) {
+	this->problem = problem;
+	this->servers = servers;
+	values.assign(problem->rankCount(), 0);
+	unconnected = 0;
+	pservCount = 0;
+	for(NodeIterator i = problem->nbegin() ; i!=  problem->nend() ; i++) {
+		for (unsigned int k = 0; k < problem->serverTypeCount(); ++k) {
+			CUDFcoefficient count = servers[i->getID() * problem->serverTypeCount() + k];
+			//the servers beyond the capacity of the facility are not connected
+			unconnected += max(count - i->getType()->getServerCapacity(k), 0LL);
+			values[problem->rankX(*i, k)] = count;
+			values[problem->rankX(*i)] += count;
+			pservCount += count;
+		}
+	}
+	//the central facility contains the root pserver (the missing pserver is counted as an unconnected client)
+	if(servers[problem->getRoot()->getID() * problem->serverTypeCount()] < 1) unconnected++;
+	localCount = 0;
+	connCount = 0;
+	bandwidth = 0;
+	IntList weights = problem->getStageWeights(0, problem->originalStageCount() - 1);
+	for (unsigned int s = 0; s < problem->stageCount(); ++s) {
+		evaluate_stage(s, weights[s]);
+	}
+	feasible = unconnected == 0;
+	return feasible;
+}
+
+// clients of a node at a stage (its servers at the initial broadcast)
+static CUDFcoefficient stage_demand(PSLProblem *problem, const CUDFcoefficientList &servers, FacilityNode *i, unsigned int s) {
+	if(s > 0) return i->getType()->getDemand(s - 1);
+	CUDFcoefficient demand = 0;
+	for (unsigned int k = 0; k < problem->serverTypeCount(); ++k) {
+		demand += servers[i->getID() * problem->serverTypeCount() + k];
+	}
+	return demand;
+}
+
+// lowest level of the facilities which can connect the clients of a node (maximal path length)
+static inline unsigned int lowest_level(PSLProblem *problem, FacilityNode *i) {
+	const unsigned int level = i->getType()->getLevel();
+	return level > problem->getMaxPathLength() ? level - problem->getMaxPathLength() : 0;
+}
+
+// Connect the clients of the subtree of a node at a stage from the clients left by its children,
+// the most constrained clients first (the clients are bucketed by the lowest level of the facilities which can connect them).
+// Set the clients connected by the node and the clients left to its father (by bucket), return the number of unconnected clients.
+static CUDFcoefficient connect_subtree(PSLProblem *problem, const CUDFcoefficientList &servers, FacilityNode *i, unsigned int s,
+		CUDFcoefficientList &served, CUDFcoefficientList &up) {
+	const unsigned int H = problem->levelCount();
+	const unsigned int stypes = problem->serverTypeCount();
+	const unsigned int id = i->getID();
+	//only the root provides the initial broadcast (s=0)
+	CUDFcoefficient capacity = 0;
+	for (unsigned int k = 0; (s > 0 || i->isRoot()) && k < stypes; ++k) {
+		capacity += servers[id * stypes + k] * problem->getServer(k)->getMaxConnections();
+	}
+	CUDFcoefficientList pool(H, 0);
+	pool[lowest_level(problem, i)] += stage_demand(problem, servers, i, s);
+	for (unsigned int c = 0; c < i->getChildrenCount(); ++c) {
+		const unsigned int child = i->getChild(c)->getID();
+		for (unsigned int l = 0; l < H; ++l) pool[l] += up[child * H + l];
+	}
+	for (int l = i->getType()->getLevel(); l >= 0; --l) {
+		served[id * H + l] = min(capacity, pool[l]);
+		capacity -= served[id * H + l];
+		pool[l] -= served[id * H + l];
+	}
+	//the remaining clients are connected higher if the length of their paths and the link allow it
+	const unsigned int above = i->isRoot() ? 0 : i->getFather()->getType()->getLevel() + 1;
+	CUDFcoefficient room = i->isRoot() ? 0 : i->toFather()->getBandwidth() / max(min_bandwidth, 1LL);
+	CUDFcoefficient unconnected = 0;
+	for (int l = H - 1; l >= 0; --l) {
+		up[id * H + l] = (unsigned int) l >= above ? 0 : min(pool[l], room);
+		unconnected += pool[l] - up[id * H + l];
+		room -= up[id * H + l];
+	}
+	return unconnected;
+}
+
+// Evaluate a stage of the placement.
+void placement_evaluator::evaluate_stage(unsigned int s, CUDFcoefficient weight) {
+	const unsigned int n = problem->nodeCount();
+	const unsigned int H = problem->levelCount();
+
+	//clients of the subtree of each node which are connected higher (by bucket)
+	CUDFcoefficientList up(n * H, 0);
+	//clients of the subtree of each node which are connected by the node (by bucket)
+	CUDFcoefficientList served(n * H, 0);
+
+	///////////////////////
+	//from the leaves to the root, connect the most constrained clients first
+	for (int id = n - 1; id >= 0; --id) {
+		unconnected += connect_subtree(problem, servers, problem->getNode(id), s, served, up);
+	}
+
+	///////////////////////
+	//from the root to the leaves, decompose the connections into paths (and flows entering the subtrees)
+	//clients of the subtree of each node which are connected by the ancestor of each level (by bucket)
+	//the buckets keep a client away from the ancestors beyond the maximal path length:
+	//without maximal path length, all the clients are in the first bucket
+	const unsigned int B = problem->getMaxPathLength() >= H - 1 ? 1 : H;
+	CUDFcoefficientList inflow(n * B * H, 0);
+	//own clients of each node which are connected by the ancestor of each level
+	CUDFcoefficientList paths(n * H, 0);
+	FacilityList ancestors(H);
+	for (unsigned int id = 0; id < n; ++id) {
+		FacilityNode *i = problem->getNode(id);
+		const unsigned int level = i->getType()->getLevel();
+		ancestors.assign(H, NULL);
+		for (FacilityNode *p = i; ; p = p->getFather()) {
+			ancestors[p->getType()->getLevel()] = p;
+			if(p->isRoot()) break;
+		}
+		const unsigned int lowest = lowest_level(problem, i);
+		const CUDFcoefficient demand = stage_demand(problem, servers, i, s);
+		CUDFcoefficient local = 0;
+		for (unsigned int l = 0; l <= level && l < B; ++l) {
+			//the suppliers are the node then its ancestors, the consumers are the node then its children
+			int supplier = level;
+			CUDFcoefficient supply = served[id * H + l];
+			for (int c = -1; c < (int) i->getChildrenCount(); ++c) {
+				const unsigned int child = c < 0 ? id : i->getChild(c)->getID();
+				CUDFcoefficient consumption = c < 0 ? (lowest == l ? demand : 0) : up[child * H + l];
+				while(consumption > 0 && supplier >= 0) {
+					if(supply == 0) {
+						if(--supplier < 0) break;
+						supply = ancestors[supplier] == NULL ? 0 : inflow[(id * B + l) * H + supplier];
+						continue;
+					}
+					CUDFcoefficient amount = min(supply, consumption);
+					if(c >= 0) inflow[(child * B + l) * H + supplier] += amount;
+					else if(supplier == (int) level) local += amount;
+					else paths[id * H + supplier] += amount;
+					supply -= amount;
+					consumption -= amount;
+				}
+			}
+		}
+		values[problem->rankY(i, s)] = accumulate(served.begin() + id * H, served.begin() + (id + 1) * H, 0LL);
+		values[problem->rankZ(i, s)] = local;
+		localCount += weight * local;
+		if(! i->isRoot()) {
+			values[problem->rankY(i->toFather(), s)] = accumulate(inflow.begin() + id * B * H, inflow.begin() + (id + 1) * B * H, 0LL);
+		}
+	}
+
+	///////////////////////
+	//the bandwidth of a connection is its share of the most loaded link of its path
+	//bandwidth of the flows entering the subtree of each node from the ancestor of each level
+	vector<double> flows(n * H, 0);
+	for (int id = n - 1; id > 0; --id) {
+		FacilityNode *i = problem->getNode(id);
+		double rate = max_bandwidth;
+		for (FacilityNode *j = i; ! j->isRoot(); j = j->getFather()) {
+			CUDFcoefficient connections = (CUDFcoefficient) values[problem->rankY(j->toFather(), s)];
+			if(connections > 0) rate = min(rate, (double) j->toFather()->getBandwidth() / connections);
+			FacilityNode *p = j->getFather();
+			const unsigned int a = p->getType()->getLevel();
+			if(! problem->hasPath(p, i)) break;
+			const double b = paths[id * H + a] * rate;
+			connCount += weight * paths[id * H + a];
+			bandwidth += weight * b;
+			flows[id * H + a] += b;
+			if(flow_formulation) {
+				CUDFcoefficient flow = 0;
+				for (unsigned int l = 0; l < B; ++l) flow += inflow[(id * B + l) * H + a];
+				values[problem->rankZ(p, i, s)] = flow;
+				values[problem->rankB(p, i, s)] = flows[id * H + a];
+			} else {
+				values[problem->rankZ(p, i, s)] = paths[id * H + a];
+				values[problem->rankB(p, i, s)] = b;
+			}
+		}
+		//the flows entering the subtree of the father
+		if(flow_formulation) {
+			const unsigned int father = i->getFather()->getID();
+			for (unsigned int a = 0; a < H; ++a) flows[father * H + a] += flows[id * H + a];
+		}
+	}
+}
+
+// order the server types by decreasing number of connections
+struct more_connections {
+	PSLProblem *problem;
+	more_connections(PSLProblem *problem) : problem(problem) {}
+	bool operator()(unsigned int k1, unsigned int k2) const {
+		return problem->getServer(k1)->getMaxConnections() > problem->getServer(k2)->getMaxConnections();
+	}
+};
+
+// the servers opened by a facility for the clients of its subtree (see evaluator.h)
+enum greedy_mode {
+	GREEDY_LAZY,  // for the clients which can not be connected higher
+	GREEDY_FULL,  // for the clients which use servers completely, and then the ones which can not be connected higher
+	GREEDY_ALL    // all the servers which can be connected by the root (see evaluator.h)
+};
+
+// Greedy placement of the servers from the leaves to the root (see evaluator.h)
+static CUDFcoefficientList greedy_placement(PSLProblem *problem, const IntList &types, greedy_mode mode) {
+	const unsigned int n = problem->nodeCount();
+	const unsigned int H = problem->levelCount();
+	const unsigned int stypes = problem->serverTypeCount();
+	const unsigned int stages = problem->stageCount();
+	CUDFcoefficientList servers(n * stypes, 0);
+	//clients of the subtree of each node which are left to its father (by stage and bucket)
+	vector<CUDFcoefficientList> up(stages, CUDFcoefficientList(n * H, 0));
+	CUDFcoefficientList served(n * H, 0);
+	for (int id = n - 1; id >= 0; --id) {
+		FacilityNode *i = problem->getNode(id);
+		const unsigned int above = i->isRoot() ? 0 : i->getFather()->getType()->getLevel() + 1;
+		const CUDFcoefficient room = i->isRoot() ? 0 : i->toFather()->getBandwidth() / max(min_bandwidth, 1LL);
+		//connections required by the clients which can not be connected higher, and by all the clients
+		CUDFcoefficient required = 0;
+		CUDFcoefficient clients = 0;
+		for (unsigned int s = i->isRoot() ? 0 : 1; s < stages; ++s) {
+			CUDFcoefficientList pool(H, 0);
+			pool[lowest_level(problem, i)] += s > 0 ? i->getType()->getDemand(s - 1) : 0;
+			for (unsigned int c = 0; c < i->getChildrenCount(); ++c) {
+				const unsigned int child = i->getChild(c)->getID();
+				for (unsigned int l = 0; l < H; ++l) pool[l] += up[s][child * H + l];
+			}
+			CUDFcoefficient forced = 0, passing = 0;
+			for (unsigned int l = 0; l < H; ++l) {
+				if(l >= above) forced += pool[l];
+				else passing += pool[l];
+			}
+			required = max(required, forced + max(passing - room, 0LL));
+			clients = max(clients, forced + passing);
+		}
+		//the servers of a node are connected by the root at the initial broadcast
+		if(lowest_level(problem, i) == 0) {
+			CUDFcoefficient capacity = 0;
+			CUDFcoefficient count = 0;
+			if(i->isRoot() && i->getType()->getServerCapacity(0) > 0) {
+				servers[0] = 1;
+				capacity = problem->getServer(0)->getMaxConnections();
+				count = 1;
+			}
+			for (unsigned int t = 0; t < stypes; ++t) {
+				const unsigned int k = types[t];
+				const CUDFcoefficient connections = problem->getServer(k)->getMaxConnections();
+				while(servers[id * stypes + k] < i->getType()->getServerCapacity(k)
+						&& (mode == GREEDY_ALL || capacity < required || (mode == GREEDY_FULL && capacity + connections <= clients)
+								|| (i->isRoot() && capacity < clients + count))) {
+					servers[id * stypes + k]++;
+					capacity += connections;
+					count++;
+				}
+			}
+		}
+		for (unsigned int s = 0; s < stages; ++s) {
+			connect_subtree(problem, servers, i, s, served, up[s]);
+		}
+	}
+	return servers;
+}
+
+// Remove the servers which are not needed from a feasible placement, from the leaves and from the smallest servers.
+// The removal of a server only changes the connections of the clients of its ancestors.
+static void remove_servers(PSLProblem *problem, const IntList &types, CUDFcoefficientList &servers) {
+	const unsigned int n = problem->nodeCount();
+	const unsigned int H = problem->levelCount();
+	const unsigned int stypes = problem->serverTypeCount();
+	const unsigned int stages = problem->stageCount();
+	vector<CUDFcoefficientList> up(stages, CUDFcoefficientList(n * H, 0));
+	CUDFcoefficientList served(n * H, 0);
+	for (unsigned int s = 0; s < stages; ++s) {
+		for (int id = n - 1; id >= 0; --id) {
+			connect_subtree(problem, servers, problem->getNode(id), s, served, up[s]);
+		}
+	}
+	for (int id = n - 1; id >= 0; --id) {
+		for (int t = stypes - 1; t >= 0; --t) {
+			CUDFcoefficient &count = servers[id * stypes + types[t]];
+			//the central facility contains the root pserver
+			while(count > (id == 0 && types[t] == 0 ? 1 : 0)) {
+				count--;
+				CUDFcoefficient unconnected = 0;
+				for (FacilityNode *j = problem->getNode(id); ; j = j->getFather()) {
+					for (unsigned int s = 0; s < stages; ++s) {
+						unconnected += connect_subtree(problem, servers, j, s, served, up[s]);
+					}
+					if(j->isRoot()) break;
+				}
+				if(unconnected > 0) {
+					count++;
+					for (FacilityNode *j = problem->getNode(id); ; j = j->getFather()) {
+						for (unsigned int s = 0; s < stages; ++s) {
+							connect_subtree(problem, servers, j, s, served, up[s]);
+						}
+						if(j->isRoot()) break;
+					}
+					break;
+				}
+			}
+		}
+	}
+}
+
+CUDFcoefficientList place_servers(PSLProblem *problem) {
+	const unsigned int stypes = problem->serverTypeCount();
+	IntList types(stypes);
+	for (unsigned int k = 0; k < stypes; ++k) types[k] = k;
+	stable_sort(types.begin(), types.end(), more_connections(problem));
+	//the lazy placement uses less servers, but the other ones are more often feasible
+	placement_evaluator evaluator;
+	CUDFcoefficientList placement;
+	CUDFcoefficient best = 0;
+	for (int mode = GREEDY_LAZY; mode <= GREEDY_ALL; ++mode) {
+		CUDFcoefficientList servers = greedy_placement(problem, types, (greedy_mode) mode);
+		if(! evaluator.evaluate(problem, servers)) continue;
+		remove_servers(problem, types, servers);
+		evaluator.evaluate(problem, servers);
+		if(placement.empty() || evaluator.pservCount < best) {
+			placement = servers;
+			best = evaluator.pservCount;
+		}
+	}
+	return placement;
+}
+
+void set_warm_start(PSLProblem *problem, abstract_solver &solver) {
+	report_phase phase("warm_start");
+	CUDFcoefficientList servers = place_servers(problem);
+	placement_evaluator evaluator;
+	if(servers.empty() || ! evaluator.evaluate(problem, servers)) {
+		if(verbosity >= VERBOSE) printf("c WARM START NONE\n");
+		return;
+	}
+	//the isomorphic siblings are ordered by their numbers of servers (see -symmetry)
+	if(symmetry_breaking) {
+		vector<FacilityList> groups = problem->isomorphicSiblings();
+		for (size_t g = 0; g < groups.size(); ++g) {
+			for (size_t k = 1; k < groups[g].size(); ++k) {
+				if(evaluator.get_solution(problem->rankX(groups[g][k - 1])) < evaluator.get_solution(problem->rankX(groups[g][k]))) {
+					if(verbosity >= VERBOSE) printf("c WARM START NONE\n");
+					return;
+				}
+			}
+		}
+	}
+	vector<double> start(problem->rankCount());
+	for (Rank k = 0; k < problem->rankCount(); ++k) {
+		start[k] = evaluator.get_real_solution(k);
+	}
+	if(verbosity >= VERBOSE) printf("c WARM START " CUDFflags " PSERVERS\n", evaluator.pservCount);
+	solver.set_mip_start(start);
+}
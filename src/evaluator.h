@@ -0,0 +1,96 @@
+/*******************************************************/
+/* oPoSSuM solver: evaluator.h                         */
+/* Evaluation of a placement of the servers            */
+/* (c) Arnaud Malapert I3S (UNS-CNRS) 2012             */
+/*******************************************************/
+
+// Once the servers are placed, the stages are independent flow problems on the tree which are solved without any solver.
+// The clients of a facility are connected by the facility or by its ancestors (within the maximal path length),
+// and a link carries at most bandwidth / min_bandwidth connections.
+// From the leaves to the root, each facility connects as many clients of its subtree as possible:
+// first the clients which can not be connected higher, then its own clients.
+// The initial broadcast (first stage) is only provided by the root.
+// A placement is feasible if and only if all the clients are connected this way.
+// The bandwidth of a connection is its fair share of the most loaded link of its path (at most max_bandwidth).
+// A stage is evaluated in O(nodes x levels) operations. With a maximal path length, the clients are bucketed by the lowest level
+// of the facilities which can connect them, and the decomposition into paths keeps the connections of each ancestor by bucket
+// (a client must not receive the connection of an ancestor beyond its path length): O(nodes x levels^2) operations and memory.
+//
+// The evaluator is a solver whose solution is the evaluated placement:
+// the constraints are ignored and the objectives are evaluated on the solution.
+//
+// The greedy heuristic places the servers from the leaves to the root: a facility opens servers
+// (the types with the most connections first) for the clients of its subtree which can not be connected higher
+// because of the path length or the link bandwidth (lazy), for the clients which use them completely (full),
+// or all the servers it can host (all). The servers of a facility beyond the maximal path length from the root are never opened.
+// The servers which are not needed are then removed one by one, from the leaves and from the smallest servers,
+// and the feasible placement with the fewest servers is kept.
+
+#ifndef _EVALUATOR_H
+#define _EVALUATOR_H
+
+#include <abstract_solver.h>
+
+class placement_evaluator: public abstract_solver {
+public:
+	// the placement is read from a file at the initialization of the solver (see read_placement)
+	int init_solver(PSLProblem *problem, int other_vars);
+
+	CUDFcoefficient get_obj_coeff(int rank) { return coefficients[rank]; }
+	int set_obj_coeff(int rank, CUDFcoefficient value) { coefficients[rank] = value; return 0; }
+	int new_objective(void);
+	int add_objective(void);
+
+	// evaluate the placement: SAT if it is feasible, UNSAT otherwise
+	int solve();
+
+	CUDFcoefficient objective_value() { return objective_value(objectiveCount() - 1); }
+	CUDFcoefficient objective_value(int i);
+	CUDFcoefficient get_solution(int k) { return (CUDFcoefficient) values[k]; }
+	double get_real_solution(int k) { return values[k]; }
+	int solutionCount() { return feasible ? 1 : 0; }
+	int objectiveCount() { return objectives.size(); }
+
+	// read a placement in the format of the solutions ("s" lines of id[servers]{servers by type}),
+	// return the numbers of servers of each type at each node (see evaluate)
+	static CUDFcoefficientList read_placement(PSLProblem *problem, const char *filename);
+
+	// evaluate the numbers of servers servers[node->getID() * serverTypeCount() + k],
+	// return true if the placement is feasible
+	bool evaluate(PSLProblem *problem, const CUDFcoefficientList &servers);
+
+	// number of clients which are not connected by the last evaluated placement (at any stage)
+	inline CUDFcoefficient unconnectedCount() const { return unconnected; }
+
+	// values of the pserv, local, conn and bandw criteria (without properties) for the last evaluated placement
+	CUDFcoefficient pservCount;
+	CUDFcoefficient localCount;
+	CUDFcoefficient connCount;
+	double bandwidth;
+
+	placement_evaluator(const char *filename = NULL) : pservCount(0), localCount(0), connCount(0), bandwidth(0),
+			filename(filename), problem(NULL), feasible(false), unconnected(0) {}
+	virtual ~placement_evaluator() {}
+
+private:
+	const char *filename;
+	PSLProblem *problem;
+	CUDFcoefficientList servers;
+	vector<double> values;               // value of each rank
+	bool feasible;
+	CUDFcoefficient unconnected;
+
+	vector<CUDFcoefficient> coefficients; // coefficients of the current objective
+	vector< vector< pair<int, CUDFcoefficient> > > objectives;
+
+	// evaluate a stage of the placement
+	void evaluate_stage(unsigned int stage, CUDFcoefficient weight);
+};
+
+// Place the servers with the greedy heuristic, return an empty list if no feasible placement is found
+extern CUDFcoefficientList place_servers(PSLProblem *problem);
+
+// Give the placement of the greedy heuristic as a starting solution to the solver (see abstract_solver::set_mip_start)
+extern void set_warm_start(PSLProblem *problem, abstract_solver &solver);
+
+#endif
@@ -16,179 +16,366 @@ abstract_solver *new_glpk_solver(bool use_exact) { return new glpk_solver(use_ex
 
 // solver initialisation
 int glpk_solver::init_solver(PSLProblem* problem, int other_vars) {
-  nb_packages = 0;//all_versioned_packages->size();
-
-  // Coefficient initialization
-  initialize_coeffs(nb_packages + other_vars);
-
-  lp = glp_create_prob();
-  glp_add_cols(lp, nb_vars);
-
-  if ((lb = (CUDFcoefficient *)malloc((nb_vars+1)*sizeof(CUDFcoefficient))) == (CUDFcoefficient *)NULL) {
-    fprintf(stderr, "glpk_solver: init_solver: not enough memory for lb.\n");
-    exit(-1);
-  }
-
-  if ((ub = (CUDFcoefficient *)malloc((nb_vars+1)*sizeof(CUDFcoefficient))) == (CUDFcoefficient *)NULL) {
-    fprintf(stderr, "glpk_solver: init_solver: not enough memory for ub.\n");
-    exit(-1);
-  }
+	_solutionCount = 0;
+	_nodeCount = 0;
+	_timeCount = 0;
+	first_objective = 0;
+	current_objective = 0;
+	has_incumbent = false;
+	incumbent_pending = false;
+	this->problem = problem;
+
+	// Coefficient initialization
+	initialize_coeffs(problem->rankCount() + other_vars);
+
+	lp = glp_create_prob();
+	glp_add_cols(lp, nb_vars);
+
+	// columns are indexed from 1
+	lb = (double *)malloc((nb_vars+1)*sizeof(double));
+	ub = (double *)malloc((nb_vars+1)*sizeof(double));
+	vartype = (int *)malloc((nb_vars+1)*sizeof(int));
+	varname = (char **)malloc((nb_vars+1)*sizeof(char *));
+	incumbent = (double *)malloc((nb_vars+1)*sizeof(double));
+
+	if ((lb  == (double *)NULL) ||
+			(ub  == (double *)NULL) ||
+			(vartype  == (int *)NULL) ||
+			(varname  == (char **)NULL) ||
+			(incumbent  == (double *)NULL)) {
+		fprintf(stderr, "glpk_solver: init_solver: not enough memory.\n");
+		exit(-1);
+	}
+	memory_alloc(MEM_SOLVER, (nb_vars+1) * (3 * sizeof(double) + sizeof(int) + sizeof(char *)));
+
+	for (int i = 0; i <= nb_vars; i++) {
+		lb[i] = 0;
+		ub[i] = 1;
+		vartype[i] = GLP_BV;
+		varname[i] = (char *)NULL;
+	}
+
+	init_vars(problem, nb_vars);
+	return 0;
+}
 
-  for (int i = 0; i <= nb_vars; i++) { lb[i] = 0; ub[i] = 1; }
+// solver destruction
+glpk_solver::~glpk_solver() {
+	if (lp != (glp_prob *)NULL) {
+		glp_delete_prob(lp);
+		free(lb);
+		free(ub);
+		free(vartype);
+		free(varname);
+		free(incumbent);
+		memory_free(MEM_SOLVER, (nb_vars+1) * (3 * sizeof(double) + sizeof(int) + sizeof(char *)));
+	}
+	if (solution != (double *)NULL) {
+		free(solution);
+		memory_free(MEM_SOLVER, (nb_vars+1)*sizeof(double));
+	}
+}
 
-  return 0;
+// set the bounds and the type of a column
+void glpk_solver::set_column(int rank, int type, double lower, double upper) {
+	lb[rank+1] = lower;
+	ub[rank+1] = upper;
+	vartype[rank+1] = type;
 }
 
 // Set range of an integer variable
-int glpk_solver::set_intvar_range(int rank, CUDFcoefficient lower, CUDFcoefficient upper) { 
-  lb[rank+1] = lower;
-  ub[rank+1] = upper;
-  return 0; 
+int glpk_solver::set_intvar_range(int rank, CUDFcoefficient lower, CUDFcoefficient upper) {
+	set_column(rank, GLP_IV, lower, upper);
+	return 0;
 }
 
 int glpk_solver::set_realvar_range(int rank, CUDFcoefficient lower, CUDFcoefficient upper) {
+	set_column(rank, GLP_CV, lower, upper);
 	return 0;
 }
 
 // set variable type to int and its range to [lower, upper] and its name to name (must be used before end_objectives)
 int glpk_solver::set_intvar(int rank, char* name, CUDFcoefficient lower, CUDFcoefficient upper) {
-	return 0;
+	varname[rank+1] = name;
+	return set_intvar_range(rank, lower, upper);
 }
 // set variable type to real and its range to [lower, upper] and its name to name (must be used before end_objectives)
 int glpk_solver::set_realvar(int rank, char* name, CUDFcoefficient lower, CUDFcoefficient upper) {
-	return 0;
+	varname[rank+1] = name;
+	return set_realvar_range(rank, lower, upper);
 }
 
 // set variable type to int and its range to [0, +inf[ and its name to name (must be used before end_objectives)
 int glpk_solver::set_intvar(int rank, char* name){
+	varname[rank+1] = name;
+	set_column(rank, GLP_IV, 0, HUGE_VAL);
 	return 0;
 }
 // set variable type to real and its range to [0, +inf[ and its name to name (must be used before end_objectives)
 int glpk_solver::set_realvar(int rank, char* name) {
+	varname[rank+1] = name;
+	set_column(rank, GLP_CV, 0, HUGE_VAL);
 	return 0;
 }
 
 // set variable type to bool and its name to name (must be used before end_objectives)
 int glpk_solver::set_boolvar(int rank, char* name) {
+	varname[rank+1] = name;
+	set_column(rank, GLP_BV, 0, 1);
 	return 0;
 }
 
 
 // write the problem into a file
-int glpk_solver::writelp(char *filename) { glp_write_lp(lp, NULL, filename); return 0; }
+int glpk_solver::writelp(char *filename) {
+	trace_span span(filename, "writer");
+	// name the columns from their rank (if the variables were created without names)
+	if (! variable_names) {
+		for (int k = 0; k < problem->rankCount() && k < nb_vars; k++)
+			glp_set_col_name(lp, k+1, problem->rankName(k).c_str());
+	}
+	return glp_write_lp(lp, NULL, filename);
+}
+
+// branch-and-cut callback:
+// submit the incumbent of the previous level and collect the statistics of the current one
+static void glpk_callback(glp_tree *tree, void *info) {
+	glpk_solver *solver = (glpk_solver *)info;
+	switch (glp_ios_reason(tree)) {
+	case GLP_IHEUR:
+		if (solver->incumbent_pending) {
+			solver->incumbent_pending = false;
+			if (glp_ios_heur_sol(tree, solver->incumbent) == 0) solver->level_solutions++;
+		}
+		break;
+	case GLP_IBINGO:
+		solver->level_solutions++;
+		break;
+	}
+	int active, nodes, total;
+	glp_ios_tree_size(tree, &active, &nodes, &total);
+	solver->level_nodes = total;
+	if (solver->level_solutions > 0) solver->level_gap = glp_ios_mip_gap(tree);
+}
 
 // solve the current lp problem
 int glpk_solver::solve() {
-  int status = 0, nb_objectives = objectives.size();
-  glp_iocp mip_params;
-    
-  glp_init_iocp(&mip_params);
-  mip_params.gmi_cuts = GLP_ON;
-  mip_params.mir_cuts = GLP_ON;
-  mip_params.cov_cuts = GLP_ON;
-  mip_params.clq_cuts = GLP_ON;
-  mip_params.presolve = GLP_ON;
-  mip_params.binarize = GLP_ON;
-
-  for (int k = 0; k < nb_objectives; k++) {
-    
-    glp_cpx_basis(lp);
-  
-    if (status == 0) status = glp_intopt(lp, &mip_params);
-
-    if (k + 1 < nb_objectives) {
-      // Get objective value
-      CUDFcoefficient objval = objective_value();
-
-      if (verbosity > 0) printf(">>> Objective %d value : "CUDFflags"\n", k, objval);
-
-      // Reset objective i coefficients
-      for (int i = 1; i < objectives[k]->nb_coeffs + 1; i++) 
-	glp_set_obj_coef(lp, objectives[k]->sindex[i], 0);
-
-      // Set objective i+1 as the actual objective function
-      for (int i = 1; i < objectives[k+1]->nb_coeffs + 1; i++) 
-	glp_set_obj_coef(lp, objectives[k+1]->sindex[i], objectives[k+1]->coefficients[i]);
-
-      // Add objective i = objval constraint
-      int irow = glp_add_rows(lp, 1);
-      glp_set_row_bnds(lp, irow, GLP_FX, objval, objval);
-      glp_set_mat_row(lp, irow, objectives[k]->nb_coeffs, objectives[k]->sindex, objectives[k]->coefficients);    
-
-      if (OUTPUT_MODEL) glp_write_lp(lp, NULL, "glpkpbs1.lp");
-    }
-  }
-  if (status == 0)  return 1; else return 0;
+	int nb_objectives = objectives.size();
+	glp_smcp lp_params;
+	glp_iocp mip_params;
+
+	glp_init_smcp(&lp_params);
+	lp_params.msg_lev = verbosity >= DEFAULT ? GLP_MSG_ON : GLP_MSG_OFF;
+	// the objective constraint added between two levels makes the previous basis primal infeasible
+	lp_params.meth = GLP_DUALP;
+
+	glp_init_iocp(&mip_params);
+	mip_params.msg_lev = lp_params.msg_lev;
+	mip_params.gmi_cuts = GLP_ON;
+	mip_params.mir_cuts = GLP_ON;
+	mip_params.cov_cuts = GLP_ON;
+	mip_params.clq_cuts = GLP_ON;
+	mip_params.mip_gap = 0.0;
+	// the MIP presolver would discard the basis and the incumbent of the previous level
+	mip_params.presolve = GLP_OFF;
+	mip_params.cb_func = glpk_callback;
+	mip_params.cb_info = this;
+
+	phase_timer timer;
+	// Only the first level starts from scratch, the next ones start from the final basis of the previous one
+	glp_adv_basis(lp, 0);
+	// Solve the objectives in a lexical order
+	for (int i = first_objective; i < nb_objectives; i++) {
+		level_record level(i);
+		the_report.begin_level(level);
+		current_objective = i;
+		level_nodes = 0;
+		level_solutions = 0;
+		level_gap = -1;
+		incumbent_pending = has_incumbent;
+
+		// Solve the lp relaxation, then the mip problem
+		phase_timer level_timer;
+		lp_params.tm_lim = (int) (time_limit * 1000);
+		int status = glp_simplex(lp, &lp_params);
+		if (status == 0 && glp_get_status(lp) == GLP_OPT) {
+			double remaining = time_limit - level_timer.wall();
+			mip_params.tm_lim = remaining > 0.001 ? (int) (remaining * 1000) : 1;
+			status = glp_intopt(lp, &mip_params);
+			switch (glp_mip_status(lp)) {
+			case GLP_OPT: level.status = status == 0 ? OPTIMUM : SAT; break;
+			case GLP_FEAS: level.status = SAT; break;
+			case GLP_NOFEAS: level.status = UNSAT; break;
+			default: level.status = status == GLP_ETMLIM ? UNKNOWN : ERROR; break;
+			}
+		} else if (status == 0 && glp_get_status(lp) == GLP_NOFEAS) {
+			level.status = UNSAT;
+		} else {
+			level.status = status == GLP_ETMLIM ? UNKNOWN : ERROR;
+		}
+		_solutionCount += level_solutions;
+		_nodeCount += level_nodes;
+		_timeCount = timer.wall();
+		report_level(level);
+
+		if (level.status == OPTIMUM) {
+			// Save the incumbent (starting point of the next level)
+			for (int k = 1; k <= nb_vars; k++) incumbent[k] = glp_mip_col_val(lp, k);
+			has_incumbent = true;
+			if (i < nb_objectives - 1) {
+				// Get next non empty objective
+				int previ = i, nexti, nexti_nb_coeffs = 0;
+
+				for (; i < nb_objectives - 1; i++) {
+					nexti = i + 1;
+					nexti_nb_coeffs = objectives[nexti]->nb_coeffs;
+					if (nexti_nb_coeffs > 0) break;
+				}
+
+				if (nexti_nb_coeffs > 0) { // there is one more objective to solve
+					CUDFcoefficient objval = objective_value();
+
+					if (verbosity >= DEFAULT)
+						printf(">>>> Objective value %d = " CUDFflags "\n", previ, objval);
+
+					// Add objective previ = objval constraint (its auxiliary variable is basic, so the basis remains valid)
+					int irow = glp_add_rows(lp, 1);
+					glp_set_row_bnds(lp, irow, GLP_FX, objval, objval);
+					glp_set_mat_row(lp, irow, objectives[previ]->nb_coeffs, objectives[previ]->sindex, objectives[previ]->coefficients);
+
+					// Set previous objective coefficients to zero
+					for (int k = 1; k < objectives[previ]->nb_coeffs + 1; k++)
+						glp_set_obj_coef(lp, objectives[previ]->sindex[k], 0);
+
+					// Set objective nexti as the actual objective function
+					for (int k = 1; k < nexti_nb_coeffs + 1; k++)
+						glp_set_obj_coef(lp, objectives[nexti]->sindex[k], objectives[nexti]->coefficients[k]);
+
+					// Output model to file (when requested)
+					if (verbosity >= VERBOSE) {
+						char buffer[1024];
+						sprintf(buffer, "glpkpb-%d.lp", i);
+						writelp(buffer);
+					}
+				} else
+					return OPTIMUM;
+			} else
+				return OPTIMUM;
+		} else if (level.status == SAT || level.status == UNKNOWN) {
+			// time limit: the incumbent of the previous level is still a solution
+			return _solutionCount > 0 ? SAT : UNKNOWN;
+		} else {
+			if (verbosity >= DEFAULT)
+				fprintf(stderr, "GLPK solution status = %d (error %d)\n", glp_mip_status(lp), status);
+			return level.status;
+		}
+	}
+
+	return 0;
+}
+
+// record the statistics of the objective level which has just been solved
+void glpk_solver::report_level(level_record &level) {
+	level.nodes = level_nodes;
+	level.solutions = level_solutions;
+	if (level.status == OPTIMUM) level.gap = 0;
+	else if (level_solutions > 0) level.gap = level_gap;
+	if (level.status == OPTIMUM || level.status == SAT) {
+		level.has_value = true;
+		level.value = glp_mip_status(lp) == GLP_UNDEF ? incumbent_value(current_objective) : glp_mip_obj_val(lp);
+	}
+	the_report.end_level(level);
+}
+
+// value of an objective for the incumbent
+double glpk_solver::incumbent_value(int objective) {
+	double value = 0;
+	for (int k = 1; k < objectives[objective]->nb_coeffs + 1; k++)
+		value += objectives[objective]->coefficients[k] * incumbent[objectives[objective]->sindex[k]];
+	return value;
 }
 
 // get objective function value
-CUDFcoefficient glpk_solver::objective_value() { return (CUDFcoefficient)nearbyint(glp_mip_obj_val(lp)); }
+CUDFcoefficient glpk_solver::objective_value() {
+	// the branch-and-cut may have stopped before finding the incumbent of the previous level
+	if (glp_mip_status(lp) != GLP_OPT && glp_mip_status(lp) != GLP_FEAS)
+		return (CUDFcoefficient)nearbyint(incumbent_value(current_objective));
+	return (CUDFcoefficient)nearbyint(glp_mip_obj_val(lp));
+}
 
 // solution initialisation
-int glpk_solver::init_solutions() { return 0; }
+int glpk_solver::init_solutions() {
+	if (solution == (double *)NULL) {
+		if ((solution = (double *)malloc((nb_vars+1)*sizeof(double))) == (double *)NULL) {
+			fprintf(stderr, "glpk_solver: init_solutions: cannot get enough memory to store solutions.\n");
+			exit(-1);
+		}
+		memory_alloc(MEM_SOLVER, (nb_vars+1)*sizeof(double));
+	}
+	if (glp_mip_status(lp) == GLP_OPT || glp_mip_status(lp) == GLP_FEAS) {
+		for (int k = 1; k <= nb_vars; k++) solution[k] = glp_mip_col_val(lp, k);
+	} else {
+		for (int k = 1; k <= nb_vars; k++) solution[k] = incumbent[k];
+	}
+	if (verbosity >= VERBOSE) glp_write_mip(lp, "sol-glpk.txt");
+	return 0;
+}
 
-// return the status of a package within the final configuration
-//CUDFcoefficient glpk_solver::get_solution(CUDFVersionedPackage *package) { return (CUDFcoefficient)nearbyint(glp_mip_col_val(lp, package->rank+1)); }
+CUDFcoefficient glpk_solver::get_solution(int k) { return (CUDFcoefficient)nearbyint(solution[k+1]); }
+double glpk_solver::get_real_solution(int k) { return solution[k+1]; }
 
 // initialize objective function
-int glpk_solver::begin_objectives(void) { 
-  glp_set_obj_dir(lp, GLP_MIN);  // Problem is minimization
-  return 0; 
+int glpk_solver::begin_objectives(void) {
+	glp_set_obj_dir(lp, GLP_MIN);  // Problem is minimization
+	return 0;
 }
 
-// return the package coefficient of the objective function 
+// return the package coefficient of the objective function
 CUDFcoefficient glpk_solver::get_obj_coeff(int rank) { return (CUDFcoefficient)get_coeff(rank); }
 
 // set column coefficient to a value
 int glpk_solver::set_obj_coeff(int rank, CUDFcoefficient value) { set_coeff(rank, value); return 0; }
 
-// initialize an additional objective function 
+// initialize an additional objective function
 int glpk_solver::new_objective(void) {
-  reset_coeffs();
-  return 0;
+	reset_coeffs();
+	return 0;
 }
 
 // add an additional objective function
-int glpk_solver::add_objective(void) { 
-  push_obj(); 
-  return 0;
+int glpk_solver::add_objective(void) {
+	push_obj();
+	return 0;
 }
 
 // finalize the objective function
 int glpk_solver::end_objectives(void) {
-  int i = 1;
-//  for (CUDFVersionedPackageListIterator ipkg = all_versioned_packages->begin(); ipkg != all_versioned_packages->end(); ipkg++) {
-//    glp_set_col_bnds(lp, i, GLP_DB, 0, 1);  // Set bounds to [0, 1]
-//    glp_set_col_name(lp, i, (*ipkg)->versioned_name); // Set the colunm name
-//    glp_set_col_kind(lp, i, GLP_BV); // It is a binary variable ...
-//    i++;
-//  }
-  for (i = nb_packages+1; i <= nb_vars; i++) {
-    char *name;
-    char buffer[20];
-
-    sprintf(buffer, "x%d", i);
-    if ((name = (char *)malloc(strlen(buffer)+1)) == (char *)NULL) {
-      fprintf(stderr, "CUDF error: can not alloc memory for variable name in glpk_solver::end_objective.\n");
-      exit(-1);
-    }
-    strcpy(name, buffer);
-
-    if ((lb[i] == 0) && (ub[i] == 1)) {
-      glp_set_col_bnds(lp, i, GLP_DB, 0, 1);  // Set bounds to [0, 1]
-      glp_set_col_name(lp, i, name); // Set the colunm name
-      glp_set_col_kind(lp, i, GLP_BV); // It is a binary variable ...
-    } else {
-      glp_set_col_bnds(lp, i, GLP_DB, lb[i], ub[i]);  // Set bounds to [0, 1]
-      glp_set_col_name(lp, i, name); // Set the colunm name
-      glp_set_col_kind(lp, i, GLP_IV); // It is an integer variable ...
-    }
-  }
-
-  // Set objective 0 as the actual objective function
-  for (int k = 1; k < objectives[0]->nb_coeffs + 1; k++) glp_set_obj_coef(lp, objectives[0]->sindex[k], objectives[0]->coefficients[k]);
-
-  return 0;
+	for (int i = 1; i <= nb_vars; i++) {
+		glp_set_col_kind(lp, i, vartype[i]);
+		if (vartype[i] != GLP_BV) {
+			if (ub[i] == HUGE_VAL) glp_set_col_bnds(lp, i, GLP_LO, lb[i], 0);
+			else if (lb[i] == ub[i]) glp_set_col_bnds(lp, i, GLP_FX, lb[i], ub[i]);
+			else glp_set_col_bnds(lp, i, GLP_DB, lb[i], ub[i]);
+		}
+		// glpk keeps its own copy of the names
+		if (varname[i] != (char *)NULL) {
+			glp_set_col_name(lp, i, varname[i]);
+			memory_free(MEM_NAMES, strlen(varname[i]) + 1);
+			free(varname[i]);
+			varname[i] = (char *)NULL;
+		}
+	}
+
+	if (objectives.size() > 0) {
+		// Set the first non empty objective as the actual objective function
+		for (; first_objective < (int)objectives.size(); first_objective++)
+			if (objectives[first_objective]->nb_coeffs > 0) break;
+		if (first_objective == (int)objectives.size()) first_objective--; // So that we solve at least one pbs
+		for (int k = 1; k < objectives[first_objective]->nb_coeffs + 1; k++)
+			glp_set_obj_coef(lp, objectives[first_objective]->sindex[k], objectives[first_objective]->coefficients[k]);
+	}
+
+	return 0;
 }
 
 // initialize constraints
@@ -210,45 +397,54 @@ CUDFcoefficient glpk_solver::get_constraint_coeff(int rank) { return (CUDFcoeffi
 //}
 
 // set column coefficient of the current constraint
-int glpk_solver::set_constraint_coeff(int rank, CUDFcoefficient value) { 
-  set_coeff(rank, value);
-  return 0;
+int glpk_solver::set_constraint_coeff(int rank, CUDFcoefficient value) {
+	set_coeff(rank, value);
+	return 0;
 }
 
 // add current constraint as a greater or equal constraint
 int glpk_solver::add_constraint_geq(CUDFcoefficient bound) {
-  if (nb_coeffs > 0 ) {
-    int irow = glp_add_rows(lp, 1);
-    glp_set_row_bnds(lp, irow, GLP_LO, bound, 0);
-    glp_set_mat_row(lp, irow, nb_coeffs, sindex, coefficients);
-  }
-  return 0;
+	if (nb_coeffs > 0 ) {
+		int irow = glp_add_rows(lp, 1);
+		glp_set_row_bnds(lp, irow, GLP_LO, bound, 0);
+		glp_set_mat_row(lp, irow, nb_coeffs, sindex, coefficients);
+	}
+	return 0;
 }
 
 // add current constraint as a less or equal constraint
 int glpk_solver::add_constraint_leq(CUDFcoefficient bound) {
-  if (nb_coeffs > 0 ) {
-    int irow = glp_add_rows(lp, 1);
-    glp_set_row_bnds(lp, irow, GLP_UP, 0, bound);
-    glp_set_mat_row(lp, irow, nb_coeffs, sindex, coefficients);
-  }
-  return 0;
+	if (nb_coeffs > 0 ) {
+		int irow = glp_add_rows(lp, 1);
+		glp_set_row_bnds(lp, irow, GLP_UP, 0, bound);
+		glp_set_mat_row(lp, irow, nb_coeffs, sindex, coefficients);
+	}
+	return 0;
 }
 
 // add current constraint as an equality constraint
 int glpk_solver::add_constraint_eq(CUDFcoefficient bound) {
-  if (nb_coeffs > 0 ) {
-    int irow = glp_add_rows(lp, 1);
-    glp_set_row_bnds(lp, irow, GLP_FX, bound, bound);
-    glp_set_mat_row(lp, irow, nb_coeffs, sindex, coefficients);
-  }
-  return 0;
+	if (nb_coeffs > 0 ) {
+		int irow = glp_add_rows(lp, 1);
+		glp_set_row_bnds(lp, irow, GLP_FX, bound, bound);
+		glp_set_mat_row(lp, irow, nb_coeffs, sindex, coefficients);
+	}
+	return 0;
 }
 
 // finalize constraints
-int glpk_solver::end_add_constraints(void) { 
-  if (OUTPUT_MODEL) glp_write_lp(lp, NULL, "glpkpbs.lp"); 
-  return 0; 
+int glpk_solver::end_add_constraints(void) {
+	if (OUTPUT_MODEL || verbosity >= VERBOSE) writelp(C_STR("glpkpb.lp"));
+	return 0;
+}
+
+// give a starting solution to the solver (submitted as the incumbent of the first level)
+// glpk does not check the rows of a heuristic solution, so the additional columns must be given
+int glpk_solver::set_mip_start(const vector<double> &start) {
+	if ((int) start.size() < nb_vars) return 0;
+	for (int k = 1; k <= nb_vars; k++) incumbent[k] = start[k-1];
+	has_incumbent = true;
+	return 0;
 }
 
 #endif
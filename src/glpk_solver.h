@@ -13,6 +13,7 @@
 
 #include <abstract_solver.h>
 #include <scoeff_solver.h>
+#include <run_report.h>
 #include <glpk.h>
 
 class glpk_solver: public abstract_solver, public scoeff_solver<double, 1, 1>  {
@@ -23,26 +24,41 @@ public:
 	// Allocate some columns for integer variables
 	int set_intvar_range(int rank, CUDFcoefficient lower, CUDFcoefficient upper);
 	//set variable type to int and its range to [lower, upper] (must be used before end_objectives)
-	int set_realvar_range(int rank, CUDFcoefficient lower, CUDFcoefficient upper); //TODO
+	int set_realvar_range(int rank, CUDFcoefficient lower, CUDFcoefficient upper);
 	// set variable type to int and its range to [lower, upper] and its name to name (must be used before end_objectives)
-	int set_intvar(int rank, char* name, CUDFcoefficient lower, CUDFcoefficient upper); //TODO
+	int set_intvar(int rank, char* name, CUDFcoefficient lower, CUDFcoefficient upper);
 	// set variable type to real and its range to [lower, upper] and its name to name (must be used before end_objectives)
-	int set_realvar(int rank, char* name, CUDFcoefficient lower, CUDFcoefficient upper); //TODO
+	int set_realvar(int rank, char* name, CUDFcoefficient lower, CUDFcoefficient upper);
 	// set variable type to int and its range to [0, +inf[ and its name to name (must be used before end_objectives)
 	int set_intvar(int rank, char* name);
 	// set variable type to real and its range to [0, +inf[ and its name to name (must be used before end_objectives)
 	int set_realvar(int rank, char* name);
 	// set variable type to bool and its name to name (must be used before end_objectives)
-	int set_boolvar(int rank, char* name); //TODO
+	int set_boolvar(int rank, char* name);
 	// Write the lp on a file
 	int writelp(char *filename);
 
+	// Give a starting solution to the solver
+	int set_mip_start(const vector<double> &start);
+
 	// Solve the problem
 	int solve();
 	// Get the objective value (final one)
 	CUDFcoefficient objective_value();
 	// Init solutions (required before calling get_solution)
 	int init_solutions();
+	// Get the solution for a column
+	CUDFcoefficient get_solution(int k);
+	// get the real solution for a column
+	double get_real_solution(int k);
+	// get the number of solutions found at the end of solving
+	int solutionCount(){return _solutionCount;}
+	// get the number of objectives (or sub-problems).
+	int objectiveCount() {return objectives.size();}
+	// get the number of nodes at the end of solving
+	int nodeCount() {return _nodeCount;}
+	// get the solving time.
+	double timeCount() {return _timeCount;}
 
 
 	// Init the objective function definitions
@@ -75,17 +91,53 @@ public:
 	// End constraint definitions
 	int end_add_constraints(void);
 
+	// variables only for internal use (should be private)
 	glp_prob *lp; // internal solver representation
-	int nb_packages; // number of packages
+	PSLProblem *problem; // problem (used to generate the variable names on demand)
+
+	int first_objective;
+
+	double *lb, *ub;     // arrays of lower and upper bounds (ub = HUGE_VAL if none)
+	int *vartype;        // array of variable types (GLP_CV, GLP_IV or GLP_BV)
+	char **varname;      // array of variable names
+
+	// Store the solutions (indexed from 1, as the columns of glpk)
+	double *solution;
 
-	CUDFcoefficient *lb, *ub;          // arrays of lower and upper bounds
+	// Incumbent of the last solved level: starting point of the next one
+	double *incumbent;
+	bool has_incumbent;
+	bool incumbent_pending; // not yet submitted to the branch-and-cut
+
+	// Statistics of the level being solved (updated by the branch-and-cut callback)
+	int level_nodes;
+	int level_solutions;
+	double level_gap;
 
 	// solver creation
 	glpk_solver(bool use_exact) {
 		lp = (glp_prob *)NULL;
-		//all_versioned_packages = (CUDFVersionedPackageList *)NULL;
-		lb = ub = (CUDFcoefficient *)NULL;
+		lb = ub = (double *)NULL;
+		vartype = (int *)NULL;
+		varname = (char **)NULL;
+		solution = incumbent = (double *)NULL;
 	}
+
+	// solver destruction
+	~glpk_solver();
+
+private:
+	// set the bounds and the type of a column
+	void set_column(int rank, int type, double lower, double upper);
+	// record the statistics of the objective level which has just been solved
+	void report_level(level_record &level);
+	// value of an objective for the incumbent
+	double incumbent_value(int objective);
+
+	int current_objective;
+	int _solutionCount;
+	int _nodeCount;
+	double _timeCount;
 };
 
 #endif
@@ -5,6 +5,7 @@
 /*******************************************************/
 
 #include "graphviz.hpp"
+#include <constraint_generation.h>
 
 
 #define INST "cplexpb"
@@ -158,7 +159,8 @@ void flow2dotty(ostream & out, PSLProblem & problem, abstract_solver & solver, u
 
 void flow2dotty(PSLProblem & problem, abstract_solver & solver, char* title)
 {
-	for (int i = 0; i < problem.stageCount(); ++i) {
+	//the merged groups share the solution of their stage (see PSLProblem::aggregateGroups)
+	for (int i = 0; i < problem.originalStageCount(); ++i) {
 		ofstream myfile;
 		stringstream ss (stringstream::in | stringstream::out);
 		ss << FLOW << i << DOT;
@@ -166,7 +168,7 @@ void flow2dotty(PSLProblem & problem, abstract_solver & solver, char* title)
 		myfile.open(ss.str().c_str());
 		myfile << "digraph F" << i << "{" <<endl;
 		gtitle(myfile, title, i);
-		flow2dotty(myfile, problem, solver, i);
+		flow2dotty(myfile, problem, solver, problem.getAggregatedStage(i));
 		myfile << endl << "}" << endl;
 		myfile.close();
 	}
@@ -200,9 +202,9 @@ void path2dotty(ostream& out, PSLProblem & problem, abstract_solver & solver, un
 			NodeIterator j = i->nbegin();
 			j++;
 			while(j !=  i->nend()) {
-				CUDFcoefficient connections = solver.get_solution(problem.rankZ(*i,*j, stage));
+				CUDFcoefficient connections = problem.hasPath(*i, *j) ? path_connections(&problem, solver, *i, *j, stage) : 0;
 				if(connections > 0) {
-					double bandwidth = solver.get_real_solution(problem.rankB(*i,*j, stage));
+					double bandwidth = path_bandwidth(&problem, solver, *i, *j, stage);
 					//	cout << ">>>>>" << bandwidth << endl;
 					bandwidth/=connections;
 					out.precision(1);
@@ -221,7 +223,7 @@ void path2dotty(ostream& out, PSLProblem & problem, abstract_solver & solver, un
 	}
 	//Add invisible arcs of the tree if needed
 	for(LinkIterator l = problem.lbegin() ; l!=  problem.lend() ; l++) {
-		CUDFcoefficient connections = solver.get_solution(problem.rankZ(l->getOrigin(), l->getDestination(), stage));
+		CUDFcoefficient connections = problem.hasPath(l->getOrigin(), l->getDestination()) ? path_connections(&problem, solver, l->getOrigin(), l->getDestination(), stage) : 0;
 		if(connections == 0) {
 			out << l->getOrigin()->getID() << " -> " << l->getDestination()->getID();
 			out << "[style=\"invis\"];" <<endl;
@@ -233,14 +235,14 @@ void path2dotty(ostream& out, PSLProblem & problem, abstract_solver & solver, un
 
 void path2dotty(PSLProblem & problem, abstract_solver & solver, char* title)
 {
-	for (int i = 1; i < problem.stageCount(); ++i) {
+	for (int i = 1; i < problem.originalStageCount(); ++i) {
 		ofstream myfile;
 		stringstream ss (stringstream::in | stringstream::out);
 		ss << PATH << i << DOT;
 		myfile.open (ss.str().c_str());
 		myfile << "digraph P" << i << "{" <<endl;
 		gtitle(myfile, title, i);
-		path2dotty(myfile, problem, solver, i);
+		path2dotty(myfile, problem, solver, problem.getAggregatedStage(i));
 		myfile << endl << "}" << endl;
 		myfile.close();
 	}
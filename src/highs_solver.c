@@ -0,0 +1,366 @@
+/*******************************************************/
+/* oPoSSuM solver: highs_solver.c                      */
+/* Interface to the HiGHS solver                       */
+/* (c) Arnaud malapert I3S (UNS-CNRS) 2012             */
+/*******************************************************/
+
+#ifdef USEHIGHS
+
+#include <math.h>
+#include <highs_solver.h>
+
+// solver creation
+abstract_solver *new_highs_solver() { return new highs_solver(); }
+
+// solver initialisation
+int highs_solver::init_solver(PSLProblem *problem, int other_vars) {
+	_solutionCount = 0;
+	_nodeCount = 0;
+	_timeCount = 0;
+	first_objective = 0;
+	lazy_names = false;
+	this->problem = problem;
+
+	// Coefficient initialization
+	initialize_coeffs(problem->rankCount() + other_vars);
+
+	// Default columns are binary
+	model.num_col_ = nb_vars;
+	model.num_row_ = 0;
+	model.sense_ = ObjSense::kMinimize;
+	model.offset_ = 0;
+	model.col_cost_.assign(nb_vars, 0);
+	model.col_lower_.assign(nb_vars, 0);
+	model.col_upper_.assign(nb_vars, 1);
+	model.integrality_.assign(nb_vars, HighsVarType::kInteger);
+	if (variable_names) model.col_names_.resize(nb_vars);
+	model.a_matrix_.format_ = MatrixFormat::kRowwise;
+	model.a_matrix_.start_.assign(1, 0);
+
+	highs.setOptionValue("output_flag", verbosity >= DEFAULT);
+	highs.setOptionValue("threads", (HighsInt) solver_threads);
+	/* Enhance the gap to handle big values correctly */
+	highs.setOptionValue("mip_rel_gap", 0.0);
+
+	init_vars(problem, nb_vars);
+	return 0;
+}
+
+// solver destruction
+highs_solver::~highs_solver() {
+	if (solution != (double *)NULL) {
+		free(solution);
+		memory_free(MEM_SOLVER, nb_vars*sizeof(double));
+	}
+}
+
+// set integer variable range (must be used before end_objective)
+int highs_solver::set_intvar_range(int rank, CUDFcoefficient lower, CUDFcoefficient upper) {
+	model.col_lower_[rank] = lower;
+	model.col_upper_[rank] = upper;
+	model.integrality_[rank] = HighsVarType::kInteger;
+	return 0;
+}
+
+int highs_solver::set_realvar_range(int rank, CUDFcoefficient lower, CUDFcoefficient upper) {
+	model.col_lower_[rank] = lower;
+	model.col_upper_[rank] = upper;
+	model.integrality_[rank] = HighsVarType::kContinuous;
+	return 0;
+}
+
+// set variable type to int and its range to [lower, upper] and its name to name (must be used before end_objectives)
+int highs_solver::set_intvar(int rank, char* name, CUDFcoefficient lower, CUDFcoefficient upper) {
+	set_intvar(rank, name);
+	return set_intvar_range(rank, lower, upper);
+}
+
+// set variable type to real and its range to [lower, upper] and its name to name (must be used before end_objectives)
+int highs_solver::set_realvar(int rank, char* name, CUDFcoefficient lower, CUDFcoefficient upper) {
+	set_realvar(rank, name);
+	return set_realvar_range(rank, lower, upper);
+}
+
+// set variable type to int and its range to [0, +inf[ and its name to name (must be used before end_objectives)
+int highs_solver::set_intvar(int rank, char* name) {
+	set_boolvar(rank, name);
+	model.col_upper_[rank] = kHighsInf;
+	return 0;
+}
+
+// set variable type to real and its range to [0, +inf[ and its name to name (must be used before end_objectives)
+int highs_solver::set_realvar(int rank, char* name) {
+	set_boolvar(rank, name);
+	model.col_upper_[rank] = kHighsInf;
+	model.integrality_[rank] = HighsVarType::kContinuous;
+	return 0;
+}
+
+// set variable type to bool and its name to name (must be used before end_objectives)
+int highs_solver::set_boolvar(int rank, char* name) {
+	model.col_lower_[rank] = 0;
+	model.col_upper_[rank] = 1;
+	model.integrality_[rank] = HighsVarType::kInteger;
+	// the model keeps its own copy of the name
+	if (name != (char *)NULL) {
+		model.col_names_[rank] = name;
+		memory_free(MEM_NAMES, strlen(name) + 1);
+		free(name);
+	}
+	return 0;
+}
+
+// Just write the lp problem in a file
+int highs_solver::writelp(char *filename) {
+	trace_span span(filename, "writer");
+	// name the columns from their rank (if the variables were created without names)
+	if (! variable_names && ! lazy_names) {
+		lazy_names = true;
+		for (int k = 0; k < problem->rankCount() && k < nb_vars; k++)
+			highs.passColName(k, problem->rankName(k));
+	}
+	return highs.writeModel(filename) == HighsStatus::kOk ? 0 : -1;
+}
+
+// solve the current problem
+int highs_solver::solve() {
+	int nb_objectives = objectives.size();
+	phase_timer timer;
+
+	// Solve the objectives in a lexical order
+	for (int i = first_objective; i < nb_objectives; i++) {
+		level_record level(i);
+		the_report.begin_level(level);
+		// the run clock of HiGHS is not reset between two levels
+		highs.setOptionValue("time_limit", highs.getRunTime() + time_limit);
+		HighsModelStatus status = highs.run() == HighsStatus::kError ? HighsModelStatus::kSolveError : highs.getModelStatus();
+		const HighsInfo &info = highs.getInfo();
+		int solutions = info.primal_solution_status == kSolutionStatusFeasible ? 1 : 0;
+		_solutionCount += solutions;
+		_nodeCount += info.mip_node_count;
+		_timeCount = timer.wall();
+		report_level(level, status);
+
+		if (status == HighsModelStatus::kOptimal) {
+			if (i < nb_objectives - 1) {
+				// Get next non empty objective
+				int previ = i, nexti, nexti_nb_coeffs = 0;
+
+				for (; i < nb_objectives - 1; i++) {
+					nexti = i + 1;
+					nexti_nb_coeffs = objectives[nexti]->nb_coeffs;
+					if (nexti_nb_coeffs > 0) break;
+				}
+
+				if (nexti_nb_coeffs > 0) { // there is one more objective to solve
+					double objval = objective_value();
+					// The solution of the level is the starting point of the next one
+					HighsSolution incumbent = highs.getSolution();
+
+					if (verbosity >= DEFAULT)
+						printf(">>>> Objective value %d = %f\n", previ, objval);
+
+					// Add objective previ = objval constraint
+					int n = objectives[previ]->nb_coeffs;
+					vector<HighsInt> index(objectives[previ]->sindex, objectives[previ]->sindex + n);
+					if (highs.addRow(objval, objval, n, &index[0], objectives[previ]->coefficients) == HighsStatus::kError) {
+						fprintf(stderr, "highs_solver: solve: cannot add %d objective as constraint.\n", previ);
+						exit(-1);
+					}
+
+					// Set the next objective as the actual objective function
+					vector<double> cost(nb_vars, 0);
+					for (int k = 0; k < nexti_nb_coeffs; k++)
+						cost[objectives[nexti]->sindex[k]] = objectives[nexti]->coefficients[k];
+					if (highs.changeColsCost(0, nb_vars - 1, &cost[0]) == HighsStatus::kError) {
+						fprintf(stderr, "highs_solver: solve: cannot change objective value.\n");
+						exit(-1);
+					}
+					highs.setSolution(incumbent);
+
+					// Output model to file (when requested)
+					if (verbosity >= VERBOSE) {
+						char buffer[1024];
+						sprintf(buffer, "highspb-%d.lp", i);
+						writelp(buffer);
+					}
+				} else
+					return OPTIMUM;
+			} else
+				return OPTIMUM;
+		} else if (status == HighsModelStatus::kTimeLimit ||
+				status == HighsModelStatus::kInterrupt ||
+				status == HighsModelStatus::kIterationLimit ||
+				status == HighsModelStatus::kSolutionLimit) {
+			return solutions > 0 ? SAT : UNKNOWN;
+		} else if (status == HighsModelStatus::kInfeasible) {
+			return UNSAT;
+		} else {
+			if (verbosity >= DEFAULT)
+				fprintf(stderr, "HiGHS model status = %d\n", (int) status);
+			return ERROR;
+		}
+	}
+
+	return 0;
+}
+
+// record the statistics of the objective level which has just been solved
+void highs_solver::report_level(level_record &level, HighsModelStatus status) {
+	const HighsInfo &info = highs.getInfo();
+	level.nodes = info.mip_node_count;
+	level.solutions = info.primal_solution_status == kSolutionStatusFeasible ? 1 : 0;
+	switch (status) {
+	case HighsModelStatus::kOptimal: level.status = OPTIMUM; break;
+	case HighsModelStatus::kTimeLimit:
+	case HighsModelStatus::kInterrupt:
+	case HighsModelStatus::kIterationLimit:
+	case HighsModelStatus::kSolutionLimit: level.status = level.solutions > 0 ? SAT : UNKNOWN; break;
+	case HighsModelStatus::kInfeasible: level.status = UNSAT; break;
+	default: level.status = ERROR; break;
+	}
+	if (level.solutions > 0) {
+		level.gap = info.mip_gap;
+		level.has_value = true;
+		level.value = info.objective_function_value;
+	}
+	the_report.end_level(level);
+}
+
+// return the objective value
+CUDFcoefficient highs_solver::objective_value() {
+	return (CUDFcoefficient)nearbyint(highs.getInfo().objective_function_value);
+}
+
+// solution initialisation
+int highs_solver::init_solutions() {
+	const HighsSolution &values = highs.getSolution();
+	if (! values.value_valid || (int) values.col_value.size() < nb_vars) {
+		fprintf(stderr, "highs_solver: init_solutions: failed to get solutions.\n");
+		exit(-1);
+	}
+	if (solution == (double *)NULL) {
+		if ((solution = (double *)malloc(nb_vars*sizeof(double))) == (double *)NULL) {
+			fprintf(stderr, "highs_solver: init_solutions: cannot get enough memory to store solutions.\n");
+			exit(-1);
+		}
+		memory_alloc(MEM_SOLVER, nb_vars*sizeof(double));
+	}
+	for (int k = 0; k < nb_vars; k++) solution[k] = values.col_value[k];
+	return 0;
+}
+
+CUDFcoefficient highs_solver::get_solution(int k) { return (CUDFcoefficient)nearbyint(solution[k]); }
+double highs_solver::get_real_solution(int k) { return solution[k]; }
+
+// initialize the objective function
+int highs_solver::begin_objectives(void) {
+	// Set Problem as a minimization problem
+	model.sense_ = ObjSense::kMinimize;
+	return 0;
+}
+
+// return the objective function coefficient of a rank
+CUDFcoefficient highs_solver::get_obj_coeff(int rank) { return (CUDFcoefficient)get_coeff(rank); }
+
+// set the objective function coefficient of a ranked variable
+int highs_solver::set_obj_coeff(int rank, CUDFcoefficient value) { set_coeff(rank, value); return 0; };
+
+// initialize an additional objective function
+int highs_solver::new_objective(void) {
+	reset_coeffs();
+	return 0;
+}
+
+// add an additional objective function
+int highs_solver::add_objective(void) {
+	push_obj();
+	return 0;
+}
+
+// ends up objective function construction
+int highs_solver::end_objectives(void) {
+	if (objectives.size() > 0) {
+		// Set the first non empty objective as the actual objective
+		for (; first_objective < (int)objectives.size(); first_objective++)
+			if (objectives[first_objective]->nb_coeffs > 0) break;
+		if (first_objective == (int)objectives.size()) first_objective--; // So that we solve at least one pbs
+		for (int k = 0; k < objectives[first_objective]->nb_coeffs; k++)
+			model.col_cost_[objectives[first_objective]->sindex[k]] = objectives[first_objective]->coefficients[k];
+	}
+	return 0;
+}
+
+// initialize constraint declaration
+int highs_solver::begin_add_constraints(void) { return 0; }
+
+// begin the declaration of a new constraint
+int highs_solver::new_constraint(void) { reset_coeffs(); return 0; }
+
+// return the coefficient value of a package
+CUDFcoefficient highs_solver::get_constraint_coeff(int rank) { return (CUDFcoefficient)get_coeff(rank); }
+
+// set the coefficient value of a ranked variable
+int highs_solver::set_constraint_coeff(int rank, CUDFcoefficient value) { set_coeff(rank, value); return 0; }
+
+// append the constraint under construction to the model
+void highs_solver::add_row(double lower, double upper) {
+	if (nb_coeffs > 0) {
+		model.a_matrix_.index_.insert(model.a_matrix_.index_.end(), sindex, sindex + nb_coeffs);
+		model.a_matrix_.value_.insert(model.a_matrix_.value_.end(), coefficients, coefficients + nb_coeffs);
+		model.a_matrix_.start_.push_back(model.a_matrix_.index_.size());
+		model.row_lower_.push_back(lower);
+		model.row_upper_.push_back(upper);
+		model.num_row_++;
+	}
+}
+
+// add constraint under construction as a greater or equal constraint
+int highs_solver::add_constraint_geq(CUDFcoefficient bound) {
+	add_row(bound, kHighsInf);
+	return 0;
+}
+
+// add constraint under construction as a less or equal constraint
+int highs_solver::add_constraint_leq(CUDFcoefficient bound) {
+	add_row(-kHighsInf, bound);
+	return 0;
+}
+
+// add constraint under construction as an equal constraint
+int highs_solver::add_constraint_eq(CUDFcoefficient bound) {
+	add_row(bound, bound);
+	return 0;
+}
+
+// ends up constraint declaration: the whole model is passed to HiGHS
+int highs_solver::end_add_constraints(void) {
+	model.a_matrix_.num_col_ = model.num_col_;
+	model.a_matrix_.num_row_ = model.num_row_;
+	if (highs.passModel(model) == HighsStatus::kError) {
+		fprintf(stderr, "highs_solver: end_add_constraints: cannot pass the model.\n");
+		exit(-1);
+	}
+	// HiGHS keeps its own copy of the model
+	model = HighsLp();
+	if (verbosity >= VERBOSE) writelp(C_STR("highspb.lp"));
+	return 0;
+}
+
+// give a starting solution to the solver (HiGHS completes the values of the additional columns, or discards it if it is infeasible)
+int highs_solver::set_mip_start(const vector<double> &start) {
+	if (start.empty()) return 0;
+	if ((int) start.size() > nb_vars) {
+		fprintf(stderr, "highs_solver: set_mip_start: the starting solution has more columns than the model.\n");
+		return -1;
+	}
+	vector<HighsInt> index(start.size());
+	for (size_t k = 0; k < start.size(); k++) index[k] = k;
+	if (highs.setSolution(start.size(), &index[0], &start[0]) == HighsStatus::kError) {
+		fprintf(stderr, "highs_solver: set_mip_start: cannot set the starting solution.\n");
+		return -1;
+	}
+	return 0;
+}
+
+#endif
@@ -10,7 +10,7 @@
 #include <lexagregate_combiner.h>
 
 // Compute the number of columns required to handle the combiner
-int lexagregate_combiner::column_allocation(int first_rank) {
+Rank lexagregate_combiner::column_allocation(Rank first_rank) {
   for (CriteriaListIterator crit = criteria->begin(); crit != criteria->end(); crit++)
     first_rank = (*crit)->set_variable_range(first_rank);
   return first_rank;
@@ -42,7 +42,7 @@ void lexagregate_combiner::initialize(PSLProblem *problem, abstract_solver *solv
 
 
 // Compute the number of required columns when the combiner is used as a criteria
-int lexagregate_combiner::set_variable_range(int first_free_var) { 
+Rank lexagregate_combiner::set_variable_range(Rank first_free_var) { 
   for (CriteriaListIterator crit = criteria->begin(); crit != criteria->end(); crit++) 
     first_free_var = (*crit)->set_variable_range(first_free_var);
 
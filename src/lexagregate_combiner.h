@@ -22,7 +22,7 @@ class lexagregate_combiner: public abstract_combiner, public abstract_criteria {
   // ********************************************************
   // Seen as a combiner
 
-  int column_allocation(int first_rank);
+  Rank column_allocation(Rank first_rank);
 
   int objective_generation();
 
@@ -31,7 +31,7 @@ class lexagregate_combiner: public abstract_combiner, public abstract_criteria {
   // ********************************************************
   // Seen as a criteria
 
-  int set_variable_range(int first_free_var);
+  Rank set_variable_range(Rank first_free_var);
   int add_criteria_to_objective(CUDFcoefficient lambda);
   int add_criteria_to_constraint(CUDFcoefficient lambda);
   int add_constraints();
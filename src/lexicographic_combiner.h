@@ -17,7 +17,7 @@ class lexicographic_combiner: public abstract_combiner {
   CriteriaList *criteria;   // set of criteria
   abstract_solver *solver;  // used solver
 
-  int column_allocation(int first_rank);
+  Rank column_allocation(Rank first_rank);
 
   int objective_generation();
 
@@ -11,7 +11,7 @@
 #include <leximax_combiner.h>
 
 // Compute the number of columns required to handle the combiner
-int leximax_combiner::column_allocation(int first_rank) {
+Rank leximax_combiner::column_allocation(Rank first_rank) {
   // Number of criteria
   n = criteria->size();
 
@@ -110,7 +110,7 @@ void leximax_combiner::initialize(PSLProblem *problem, abstract_solver *solver)
 
 
 // Compute the number of required columns when the combiner is used as a criteria
-int leximax_combiner::set_variable_range(int first_free_var) { 
+Rank leximax_combiner::set_variable_range(Rank first_free_var) { 
   return column_allocation(first_free_var);
 }
 
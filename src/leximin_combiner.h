@@ -23,7 +23,7 @@ class leximin_combiner: public abstract_combiner, public abstract_criteria {
   // ********************************************************
   // Seen as a combiner
 
-  int column_allocation(int first_rank);
+  Rank column_allocation(Rank first_rank);
 
   int objective_generation();
 
@@ -32,7 +32,7 @@ class leximin_combiner: public abstract_combiner, public abstract_criteria {
   // ********************************************************
   // Seen as a criteria
 
-  int set_variable_range(int first_free_var);
+  Rank set_variable_range(Rank first_free_var);
   void initialize_intvars();
   int add_criteria_to_objective(CUDFcoefficient lambda);
   int add_criteria_to_constraint(CUDFcoefficient lambda);
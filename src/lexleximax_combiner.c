@@ -11,7 +11,7 @@
 #include <lexleximax_combiner.h>
 
 // Compute the number of columns required to handle the combiner
-int lexleximax_combiner::column_allocation(int first_rank) {
+Rank lexleximax_combiner::column_allocation(Rank first_rank) {
   // Number of leximax handled criteria
   n = criteria->size() - 1;
 
@@ -22,7 +22,7 @@ class lexleximax_combiner: public abstract_combiner {
   int n, ui_n, yi_n, lambdaij_nn;
   CUDFcoefficient max_lambda;
 
-  int column_allocation(int first_rank);
+  Rank column_allocation(Rank first_rank);
 
   // Generate combiner objective function
   int objective_generation();
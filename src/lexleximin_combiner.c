@@ -11,7 +11,7 @@
 #include <lexleximin_combiner.h>
 
 // Compute the number of columns required to handle the combiner
-int lexleximin_combiner::column_allocation(int first_rank) {
+Rank lexleximin_combiner::column_allocation(Rank first_rank) {
   // Number of leximin handled criteria
   n = criteria->size() - 1;
 
@@ -10,7 +10,7 @@
 #include <lexsemiagregate_combiner.h>
 
 // Compute the number of columns required to handle the combiner
-int lexsemiagregate_combiner::column_allocation(int first_rank) {
+Rank lexsemiagregate_combiner::column_allocation(Rank first_rank) {
   for (CriteriaListIterator crit = criteria->begin(); crit != criteria->end(); crit++)
     first_rank = (*crit)->set_variable_range(first_rank);
   return first_rank;
@@ -21,7 +21,7 @@ class lexsemiagregate_combiner: public abstract_combiner {
   CriteriaList *criteria;   // set of criteria
   abstract_solver *solver;  // used solver
 
-  int column_allocation(int first_rank);
+  Rank column_allocation(Rank first_rank);
 
   int objective_generation();
 
@@ -11,8 +11,9 @@
 // Criteria initialization
 void local_criteria::initialize(PSLProblem *problem, abstract_solver *solver) {
 	stage_range.set_min_limit(0);
-	stage_range.set_max_limit(problem->stageCount()-1);
+	stage_range.set_max_limit(problem->originalStageCount()-1);
 	level_range.set_min_limit(0);
+	stage_weights = stage_weights_of(problem, stage_range);
 	pslp_criteria::initialize(problem, solver);
 }
 
@@ -26,7 +27,7 @@ void local_criteria::initialize_upper_bound(PSLProblem *problem) {
 }
 
 // Computing the number of columns required to handle the criteria
-int local_criteria::set_variable_range(int first_free_var) {
+Rank local_criteria::set_variable_range(Rank first_free_var) {
 	return first_free_var;
 }
 
@@ -34,8 +35,8 @@ int local_criteria::set_variable_range(int first_free_var) {
 int local_criteria::add_criteria_to_objective(CUDFcoefficient lambda) {
 	for(NodeIterator i = problem->nbegin() ; i!=  problem->nend() ; i++) {
 		if(isRLSelected(*i)) {
-			for (int s = stage_range.min(); s <= stage_range.max(); ++s) {
-				set_obj_coeff(problem->rankZ(*i, s), lambda);
+			for (unsigned int s = 0; s < problem->stageCount(); ++s) {
+				if(stage_weights[s] > 0) set_obj_coeff(problem->rankZ(*i, s), lambda * stage_weights[s]);
 			}
 		}
 	}
@@ -46,8 +47,8 @@ int local_criteria::add_criteria_to_objective(CUDFcoefficient lambda) {
 int local_criteria::add_criteria_to_constraint(CUDFcoefficient lambda) {
 	for(NodeIterator i = problem->nbegin() ; i!=  problem->nend() ; i++) {
 		if(isRLSelected(*i)) {
-			for (int s = stage_range.min(); s <= stage_range.max(); ++s) {
-				set_constraint_coeff(problem->rankZ(*i, s), lambda);
+			for (unsigned int s = 0; s < problem->stageCount(); ++s) {
+				if(stage_weights[s] > 0) set_constraint_coeff(problem->rankZ(*i, s), lambda * stage_weights[s]);
 			}
 		}
 	}
@@ -7,272 +7,453 @@
 #include <lp_solver.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <math.h>
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <signal.h>
 #include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/mman.h>
+#include <sys/sendfile.h>
 #include <unistd.h>
 
-#define CLEAN_FILES 1
 #define TMP_FILES_PATH "/tmp/"
+#define MAX_TERMS_PER_LINE 20 // scip does not like too long lines
 
 // external function for solver creation
 abstract_solver *new_lp_solver(char *lpsolver) { return new lp_solver(lpsolver); }
 
 // solver initialisation
 int lp_solver::init_solver(PSLProblem *problem, int other_vars) {
-
-	nb_packages = 0;
-	//this->all_versioned_packages = all_versioned_packages;
+	_solutionCount = 0;
+	_timeCount = 0;
+	objval = 0;
 
 	// Coefficient initialization
-	initialize_coeffs(nb_packages + other_vars);
+	initialize_coeffs(problem->rankCount() + other_vars);
 
 	nb_constraints = 0;
-	mult = ' ';
 
-	solution = (CUDFcoefficient *)malloc(nb_vars*sizeof(CUDFcoefficient));
+	solution = (double *)malloc(nb_vars*sizeof(double));
 	lb = (CUDFcoefficient *)malloc(nb_vars*sizeof(CUDFcoefficient));
 	ub = (CUDFcoefficient *)malloc(nb_vars*sizeof(CUDFcoefficient));
+	vartype = (char *)malloc(nb_vars*sizeof(char));
 
-	for (int i = 0; i < nb_vars; i++) { lb[i] = 0; ub[i] = 1; }
-
-	sprintf(ctlpfilename, TMP_FILES_PATH "ctlp_%lu_%lu.lp", (long unsigned)getuid(), (long unsigned)getpid());
-	ctlpfile = fopen(ctlpfilename, "w");
-
-	if ((solution == (CUDFcoefficient *)NULL) ||
+	if ((solution == (double *)NULL) ||
 			(lb == (CUDFcoefficient *)NULL) ||
-			(ub == (CUDFcoefficient *)NULL)) {
+			(ub == (CUDFcoefficient *)NULL) ||
+			(vartype == (char *)NULL)) {
 		fprintf(stderr, "lp_solver: intialize: not enough memory.\n");
 		exit(-1);
-	} else if (ctlpfile == (FILE *)NULL) {
-		fprintf(stderr, "lp_solver: intialize: can not open %s.\n", ctlpfilename);
+	}
+	memory_alloc(MEM_SOLVER, nb_vars * (sizeof(double) + 2 * sizeof(CUDFcoefficient) + sizeof(char)));
+
+	for (int i = 0; i < nb_vars; i++) {
+		lb[i] = 0;
+		ub[i] = 1;
+		vartype[i] = 'B';
+		solution[i] = 0;
+	}
+
+	// The constraint block lives in memory: it is written once and copied into the fifo at each level
+#ifdef MFD_CLOEXEC
+	ctlpfd = memfd_create("opossum-constraints", MFD_CLOEXEC);
+#endif
+	if (ctlpfd == -1) {
+		FILE *tmp = tmpfile();
+		if (tmp != (FILE *)NULL) {
+			ctlpfd = dup(fileno(tmp));
+			fclose(tmp);
+		}
+	}
+	if (ctlpfd == -1) {
+		fprintf(stderr, "lp_solver: intialize: can not create the constraint block.\n");
 		exit(-1);
-	} else
-		return 0;
+	}
+	ctlp.open(ctlpfd);
+	init_vars(problem, nb_vars);
+	return 0;
+}
+
+// solver destruction
+lp_solver::~lp_solver() {
+	ctlp.close();
+	if (solution != (double *)NULL) {
+		free(solution);
+		free(lb);
+		free(ub);
+		free(vartype);
+		memory_free(MEM_SOLVER, nb_vars * (sizeof(double) + 2 * sizeof(CUDFcoefficient) + sizeof(char)));
+	}
+}
+
+// copy a part of a file into another one (within the kernel if possible)
+static int copy_file(int to, int from, off_t size) {
+	off_t offset = 0;
+	while (offset < size) {
+		ssize_t n = sendfile(to, from, &offset, size - offset);
+		if (n == -1 && (errno == EINVAL || errno == ENOSYS)) {
+			// sendfile does not support these files
+			char buffer[65536];
+			size_t len = size - offset < (off_t) sizeof(buffer) ? size - offset : sizeof(buffer);
+			if ((n = pread(from, buffer, len, offset)) > 0) {
+				if (write(to, buffer, n) != n) return -1;
+				offset += n;
+			}
+		}
+		if (n == -1 && errno == EINTR) continue;
+		if (n <= 0) return -1;
+	}
+	return 0;
+}
+
+// write the terms of a linear expression
+static void write_terms(model_sink &out, int nb_coeffs, CUDFcoefficient *coefficients, int *sindex) {
+	for (int i = 0; i < nb_coeffs; i++) {
+		if (i > 0 && i % MAX_TERMS_PER_LINE == 0) out.put("\n  ", 3);
+		out.put(' ');
+		out.put_int(coefficients[i], true);
+		out.put(" x", 2);
+		out.put_int(sindex[i]);
+	}
+}
+
+// write the complete problem of a level into a file descriptor (which is closed)
+// only the objective and the constraints on the previous objectives are formatted, the constraint block is copied
+int lp_solver::write_level(int fd, unsigned int iobj) {
+	model_sink out;
+	out.open(fd);
+
+	out.put("Minimize\n obj:");
+	if (iobj < objectives.size() && objectives[iobj]->nb_coeffs > 0)
+		write_terms(out, objectives[iobj]->nb_coeffs, objectives[iobj]->coefficients, objectives[iobj]->sindex);
+	else
+		out.put(" 0 x0");
+	out.put("\nSubject To\n");
+	for (unsigned int i = 0; i < iobj; i++) {
+		if (objectives[i]->nb_coeffs > 0) {
+			out.put(" lex", 4);
+			out.put_int(i);
+			out.put(':');
+			write_terms(out, objectives[i]->nb_coeffs, objectives[i]->coefficients, objectives[i]->sindex);
+			out.put(" = ", 3);
+			out.put_int(objvals[i]);
+			out.put('\n');
+		}
+	}
+	out.flush();
+
+	int status = out.good() ? copy_file(fd, ctlpfd, ctlpsize) : -1;
+	if (! out.close()) status = -1;
+	return status;
 }
 
 // write the problem into a file
-int lp_solver::writelp(char *filename) { return 0; }
+int lp_solver::writelp(char *filename) {
+	trace_span span(filename, "writer");
+	int fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd == -1) {
+		fprintf(stderr, "lp_solver: writelp: cannot open %s.\n", filename);
+		return -1;
+	}
+	unsigned int iobj = 0;
+	while (iobj + 1 < objectives.size() && objectives[iobj]->nb_coeffs == 0) iobj++;
+	return write_level(fd, iobj);
+}
 
-// solve the current problem
-int lp_solver::solve() {
-	int status = 0;
-	int rank, iobjval;
-	char command[1024];
-	FILE *fsol = (FILE *)NULL;
-	CUDFcoefficient objvals[20];
-	unsigned int nb_objectives = objectives.size();
+// start reading a solution whose objective value is written in s
+void lp_solver::begin_solution(const char *s) {
+	if (sscanf(s, "%lf", &level_value) == 1) {
+		has_solution = true;
+		reading_solution = true;
+		read_columns = false;
+		// the solvers only print the non zero columns
+		for (int k = 0; k < nb_vars; k++) solution[k] = 0;
+	}
+}
 
-	sprintf(lpfilename, TMP_FILES_PATH "lppbs_%lu_%lu.lp", (long unsigned)getuid(), (long unsigned)getpid());
-	sprintf(lpoutfilename, TMP_FILES_PATH "lppbs_%lu_%lu.out", (long unsigned)getuid(), (long unsigned)getpid());
+// parse the value of a column: "x<rank> <value> ..." (scip, cplex) or "<index> x<rank> <value> ..." (cbc)
+bool lp_solver::parse_column(const char *line) {
+	int rank, n = 0;
+	double value;
 
-	for (unsigned int iobj = 0; iobj < nb_objectives; iobj++) {
-		if (objectives[iobj]->nb_coeffs == 0) continue;
+	sscanf(line, "%*d %n", &n);
+	if (sscanf(line + n, "x%d %lf", &rank, &value) == 2 && rank >= 0 && rank < nb_vars) {
+		solution[rank] = value;
+		return true;
+	}
+	return false;
+}
 
-		if ((lpfile = fopen(lpfilename, "w")) == (FILE *)NULL) {
-			fprintf(stderr, "lp_solver: cannot open %s.\n", lpfilename);
-			exit(-1);
-		}
+// parse a line of the solver output (scip, cbc or cplex)
+void lp_solver::parse_line(char *line) {
+	char *s = line;
 
-		fprintf(lpfile, "Minimize\n obj:");
-		for (int i = 0, nbc = 0; i < objectives[iobj]->nb_coeffs; i++, nbc++) {
-			if (nbc == 20) { // scip does not like too long lines
-				nbc = 0;
-				fprintf(lpfile, "\n  ");
-			}
-			fprintf(lpfile, " "CUDFflagsplus"%cx%d", objectives[iobj]->coefficients[i], mult, objectives[iobj]->sindex[i]);
-		}
-		fprintf(lpfile, "\n");
-
-		fprintf(lpfile, "Subject To\n");
-		for (unsigned int i = 0; i < iobj; i++) {
-			if (objectives[i]->nb_coeffs > 0) {
-				for (int j = 0, nbc = 0; j < objectives[i]->nb_coeffs; j++, nbc++) {
-					if (nbc == 20) { // scip does not like too long lines
-						nbc = 0;
-						fprintf(lpfile, "\n  ");
-					}
-					fprintf(lpfile, " "CUDFflagsplus"%cx%d", objectives[i]->coefficients[j], mult, objectives[i]->sindex[j]);
-				}
-				fprintf(lpfile, " = "CUDFflags"\n", objvals[i]);
-			}
+	while (isspace(*s)) s++;
+	// prompt and prefix of the interactive solvers
+	if (strncmp(s, "CPLEX> ", 7) == 0) s += 7;
+	if (strncmp(s, "Coin:", 5) == 0) s += 5;
+
+	if (reading_solution) {
+		if (parse_column(s)) {
+			read_columns = true;
+			return;
 		}
+		// the solution ends at the first line which is not a column (cplex prints some lines before the columns)
+		if (read_columns) reading_solution = false;
+	}
 
-		fclose(lpfile);
+	if (strncmp(s, "objective value:", 16) == 0) { // scip
+		begin_solution(s + 16);
+	} else if (strncmp(s, "SCIP Status", 11) == 0) {
+		if (strstr(s, "interrupted") != NULL) interrupted = true;
+		else if (strstr(s, "[infeasible]") != NULL) infeasible = true;
+	} else if (strncmp(s, "Optimal - objective value", 25) == 0) { // cbc
+		begin_solution(s + 25);
+	} else if (strncmp(s, "Stopped on ", 11) == 0) {
+		interrupted = true;
+		char *v = strstr(s, "objective value");
+		if (v != NULL) begin_solution(v + 15);
+	} else if ((strncmp(s, "Infeasible - objective value", 28) == 0) ||
+			(strncmp(s, "MIP - Integer infeasible", 24) == 0)) { // cbc or cplex
+		infeasible = true;
+	} else if (strncmp(s, "MIP - ", 6) == 0) { // cplex
+		if (strncmp(s + 6, "Integer optimal", 15) != 0) interrupted = true;
+		char *v = strstr(s, "Objective =");
+		if (v != NULL) begin_solution(v + 11);
+	}
+}
 
-		if (verbosity < 2)
-			sprintf(command, "cat %s >> %s; %s %s > %s 2> /dev/null",
-					ctlpfilename, lpfilename, lpsolver, lpfilename, lpoutfilename);
-		else
-			sprintf(command, "cat %s >> %s; %s %s | tee %s",
-					ctlpfilename, lpfilename, lpsolver, lpfilename, lpoutfilename);
+// output of the solver parsed by a thread
+struct output_reader {
+	lp_solver *solver;
+	int fd;
+};
+
+// parse the solver output until its end
+void *lp_solver::read_output(void *reader) {
+	lp_solver *solver = ((output_reader *)reader)->solver;
+	FILE *fout = fdopen(((output_reader *)reader)->fd, "r");
+	char *line = (char *)NULL;
+	size_t size = 0;
+	while (getline(&line, &size, fout) != -1) {
+		if (verbosity >= VERBOSE) fputs(line, stdout);
+		solver->parse_line(line);
+	}
+	free(line);
+	fclose(fout);
+	return NULL;
+}
 
-		if (system(command) == -1) {
-			fprintf(stderr, "mccs: error while calling solver.\n");
-			exit(-1);
-		}
+// run the solver on a level and parse its output
+// The solver reads the problem from the fifo and prints its solution on the standard output.
+// It must read the file sequentially and only once.
+// The output is parsed by a thread while the problem is written: a solver which prints while reading
+// would otherwise block on a full pipe and never finish reading the fifo.
+void lp_solver::run_level(unsigned int iobj) {
+	int out[2];
 
-		if ((fsol = fopen(lpoutfilename, "r")) == (FILE *)NULL) {
-			fprintf(stderr, "Cannot open solution file \"%s\".\n", lpoutfilename);
-			exit(-1);
+	has_solution = infeasible = interrupted = reading_solution = read_columns = false;
+	level_value = 0;
+
+	if (pipe(out) == -1) {
+		fprintf(stderr, "lp_solver: solve: cannot create a pipe.\n");
+		exit(-1);
+	}
+	fflush(stdout);
+	fflush(stderr);
+	pid_t pid = fork();
+	if (pid == -1) {
+		fprintf(stderr, "lp_solver: solve: cannot start %s.\n", lpsolver);
+		exit(-1);
+	} else if (pid == 0) {
+		dup2(out[1], STDOUT_FILENO);
+		close(out[0]);
+		close(out[1]);
+		if (verbosity < VERBOSE) {
+			int null = open("/dev/null", O_WRONLY);
+			if (null != -1) dup2(null, STDERR_FILENO);
 		}
+		execl(lpsolver, lpsolver, lpfilename, (char *)NULL);
+		fprintf(stderr, "lp_solver: cannot execute %s.\n", lpsolver);
+		_exit(127);
+	}
+	close(out[1]);
 
-		status = -1;
-		while ((status == -1) && (! feof(fsol)) && (fgets(command, 1000, fsol) != NULL))
-			switch (command[0]) {
-			case 'p': // scip ?
-				if (strncmp(command, "primal solution:", 16) == 0) {
-					if (fgets(command, 1000, fsol) != NULL)  // read ===========
-						if (fgets(command, 1000, fsol) != NULL)  // read empty line
-							if (fgets(command, 1000, fsol) != NULL) { // read objective value or no solution
-								if (strncmp(command, "objective value:", 16) == 0) {
-									status = 1;
-									if (sscanf(command+16, "%d", &iobjval) > 0) objval = objvals[iobj] = iobjval;
-
-									// Reading scip solution
-									if (iobj + 1 == nb_objectives) { // read solutions
-
-										for (int i = 0; i < nb_packages; i++) solution[i] = 0; // Set solution values to 0
-
-										while ((! feof(fsol)) && (fgets(command, 1000, fsol) != NULL))
-											if (command[0] == 'x') {
-												if (sscanf(command+1, "%d", &rank) > 0)
-													solution[rank] = 1;
-											} else // end of solution reached
-												break;
-									}
-								} else if (strncmp(command, "no solution available", 21) == 0) {
-									status = 0;
-								}
-							} else {
-								fprintf(stderr, "mccs: error while reading solution file.\n");
-								exit(-1);
-							}
-						else {
-							fprintf(stderr, "mccs: error while reading solution file.\n");
-							exit(-1);
-						}
-					else {
-						fprintf(stderr, "mccs: error while reading solution file.\n");
-						exit(-1);
-					}
-				}
-				break;
-			case 'C':  // COIN or CPLEX ?
-				if ((strncmp(command, "Coin:Infeasible - objective value", 33) == 0) ||
-						(strncmp(command, "CPLEX> MIP - Integer infeasible.", 32) == 0))
-					status = 0;
-				else if (strncmp(command, "Coin:Optimal - objective value", 30) == 0) {
-					status = 1;
-					if (sscanf(command+30, "%d", &iobjval) > 0) objval = objvals[iobj] = iobjval;
-
-					// Reading COIN solution
-					if (iobj + 1 == nb_objectives) { // read solutions
-
-						for (int i = 0; i < nb_packages; i++) solution[i] = 0; // Set solution values to 0
-
-						while ((! feof(fsol)) && (fgets(command, 1000, fsol) != NULL))
-							if ((command[0] == ' ') && (command[8] == 'x')) {
-								if (sscanf(command+9, "%d", &rank) > 0)
-									if (((command[30] == ' ') && (command[31] == '1')) ||
-											((command[31] == ' ') && (command[32] == '1')) ||
-											((command[32] == ' ') && (command[33] == '1')) ||
-											((command[33] == ' ') && (command[34] == '1'))) solution[rank] = 1;
-							} else // end of solution reached
-								break;
-					}
-				} else if (strncmp(command, "CPLEX> MIP - Integer optimal solution:  Objective = ", 52) == 0) {
-					status = 1;
-					if (sscanf(command+52, "%d", &iobjval) > 0) objval = objvals[iobj] = iobjval;
-
-					// Reading CPLEX solution
-					if (iobj + 1 == nb_objectives) { // read solutions
-
-						for (int i = 0; i < nb_packages; i++) solution[i] = 0; // Set solution values to 0
-
-						if (fgets(command, 1000, fsol) != NULL) { //  Forget two next lines
-							if (fgets(command, 1000, fsol) != NULL) {
-								while ((! feof(fsol)) && (fgets(command, 1000, fsol) != NULL))
-									if (command[0] == 'x') {
-										if (sscanf(command+1, "%d", &rank) > 0) solution[rank] = 1;
-									} else // end of solution reached
-										break;
-							} else {
-								fprintf(stderr, "mccs: error while reading solution file.\n");
-								exit(-1);
-							}
-						} else {
-							fprintf(stderr, "mccs: error while reading solution file.\n");
-							exit(-1);
-						}
-					}
-				}
-				break;
-			}
+	output_reader reader = { this, out[0] };
+	pthread_t thread;
+	if (pthread_create(&thread, NULL, read_output, &reader) != 0) {
+		fprintf(stderr, "lp_solver: solve: cannot create the thread reading the output of %s.\n", lpsolver);
+		exit(-1);
+	}
 
-		// If we are here with a status = -1, then we were enable to read the solution (or the infeasability)
-		if (status == -1) {
-			fprintf(stderr, "ERROR: Cannot read solution from lp solver.\n");
-			exit(-1);
+	// Feed the fifo as soon as the solver opens it (or stop if it dies before)
+	int fd;
+	while ((fd = open(lpfilename, O_WRONLY | O_NONBLOCK)) == -1 && errno == ENXIO) {
+		if (waitpid(pid, NULL, WNOHANG) == pid) {
+			pid = -1;
+			break;
 		}
-	} // end for objectives
+		usleep(1000);
+	}
+	if (fd != -1) {
+		fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+		if (write_level(fd, iobj) == -1 && verbosity >= DEFAULT)
+			fprintf(stderr, "lp_solver: %s did not read the whole problem.\n", lpsolver);
+	}
+
+	// Wait for the end of the output
+	pthread_join(thread, NULL);
+	if (pid != -1) waitpid(pid, NULL, 0);
+}
+
+// solve the current problem
+int lp_solver::solve() {
+	int status = OPTIMUM;
+	unsigned int nb_objectives = objectives.size();
 
-	if (CLEAN_FILES) {
-		remove(ctlpfilename);
-		remove(lpfilename);
-		remove(lpoutfilename);
+	// Get the first non empty objective (a problem without objective is solved once for a feasible solution)
+	unsigned int first_objective = 0;
+	while (first_objective < nb_objectives && objectives[first_objective]->nb_coeffs == 0) first_objective++;
+	if (first_objective == nb_objectives) first_objective = 0;
+
+	objvals.assign(nb_objectives > 0 ? nb_objectives : 1, 0);
+	// several solvers may be created by a process (sweep or batch mode)
+	static unsigned int fifo_count = 0;
+	sprintf(lpfilename, TMP_FILES_PATH "lppbs_%lu_%lu_%u.lp", (long unsigned)getuid(), (long unsigned)getpid(), fifo_count++);
+	unlink(lpfilename);
+	if (mkfifo(lpfilename, 0600) == -1) {
+		fprintf(stderr, "lp_solver: solve: cannot create the fifo %s.\n", lpfilename);
+		exit(-1);
+	}
+	// the solver may stop reading the problem
+	void (*sigpipe)(int) = signal(SIGPIPE, SIG_IGN);
+
+	phase_timer timer;
+	for (unsigned int iobj = first_objective; iobj == first_objective || iobj < nb_objectives; iobj++) {
+		if (iobj > first_objective && objectives[iobj]->nb_coeffs == 0) continue;
+
+		level_record level(iobj);
+		the_report.begin_level(level);
+		run_level(iobj);
+
+		if (has_solution) {
+			_solutionCount++;
+			objval = objvals[iobj] = (CUDFcoefficient) nearbyint(level_value);
+			level.solutions = 1;
+			level.has_value = true;
+			level.value = level_value;
+			level.status = interrupted ? SAT : OPTIMUM;
+			if (! interrupted) level.gap = 0;
+		} else if (interrupted)
+			level.status = UNKNOWN;
+		else if (infeasible)
+			level.status = UNSAT;
+		else
+			level.status = ERROR;
+		_timeCount = timer.wall();
+		the_report.end_level(level);
+
+		if (level.status == OPTIMUM) {
+			if (verbosity >= DEFAULT && iobj + 1 < nb_objectives)
+				printf(">>>> Objective value %d = " CUDFflags "\n", iobj, objval);
+		} else {
+			if (level.status == ERROR)
+				fprintf(stderr, "ERROR: Cannot read solution from lp solver.\n");
+			// time limit: the solution of the previous level is still a solution
+			if (level.status == SAT || level.status == UNKNOWN)
+				status = _solutionCount > 0 ? SAT : UNKNOWN;
+			else
+				status = level.status;
+			break;
+		}
 	}
 
+	signal(SIGPIPE, sigpipe);
+	unlink(lpfilename);
 	return status;
 }
 
 // get objective function value
 CUDFcoefficient lp_solver::objective_value() { return objval; }
 
-// solution initialisation
+// solution initialisation (the solution is read with the solver output)
 int lp_solver::init_solutions() { return 0; }
 
-// set integer variable range (must be used before end_objective)
-int lp_solver::set_intvar_range(int rank, CUDFcoefficient lower, CUDFcoefficient upper) { 
+// return the solution of a column
+CUDFcoefficient lp_solver::get_solution(int k) { return (CUDFcoefficient) nearbyint(solution[k]); }
+double lp_solver::get_real_solution(int k) { return solution[k]; }
+
+// set the bounds and the type of a column
+void lp_solver::set_column(int rank, char type, CUDFcoefficient lower, CUDFcoefficient upper) {
 	lb[rank] = lower;
 	ub[rank] = upper;
+	vartype[rank] = type;
+}
+
+// free a variable name (columns are always named x<rank>)
+void lp_solver::drop_name(char *name) {
+	if (name != (char *)NULL) {
+		memory_free(MEM_NAMES, strlen(name) + 1);
+		free(name);
+	}
+}
+
+// set integer variable range (must be used before end_objective)
+int lp_solver::set_intvar_range(int rank, CUDFcoefficient lower, CUDFcoefficient upper) {
+	set_column(rank, 'I', lower, upper);
 	return 0;
 }
 
 int lp_solver::set_realvar_range(int rank, CUDFcoefficient lower, CUDFcoefficient upper) {
+	set_column(rank, 'C', lower, upper);
 	return 0;
 }
 
 // set variable type to int and its range to [lower, upper] and its name to name (must be used before end_objectives)
 int lp_solver::set_intvar(int rank, char* name, CUDFcoefficient lower, CUDFcoefficient upper) {
-	return 0;
+	drop_name(name);
+	return set_intvar_range(rank, lower, upper);
 }
 // set variable type to real and its range to [lower, upper] and its name to name (must be used before end_objectives)
 int lp_solver::set_realvar(int rank, char* name, CUDFcoefficient lower, CUDFcoefficient upper) {
-	return 0;
+	drop_name(name);
+	return set_realvar_range(rank, lower, upper);
 }
 
 // set variable type to int and its range to [0, +inf[ and its name to name (must be used before end_objectives)
 int lp_solver::set_intvar(int rank, char* name){
+	drop_name(name);
+	set_column(rank, 'I', 0, LLONG_MAX);
 	return 0;
 }
 // set variable type to real and its range to [0, +inf[ and its name to name (must be used before end_objectives)
 int lp_solver::set_realvar(int rank, char* name) {
+	drop_name(name);
+	set_column(rank, 'C', 0, LLONG_MAX);
 	return 0;
 }
 
 // set variable type to bool and its name to name (must be used before end_objectives)
 int lp_solver::set_boolvar(int rank, char* name) {
+	drop_name(name);
+	set_column(rank, 'B', 0, 1);
 	return 0;
 }
 // initialize objective function
 int lp_solver::begin_objectives(void) { return 0; }
 
 
-// return the package coefficient of the objective function 
+// return the package coefficient of the objective function
 CUDFcoefficient lp_solver::get_obj_coeff(int rank) { return get_coeff(rank); }
 
 
-// set the column coefficient of the objective function 
-int lp_solver::set_obj_coeff(int rank, CUDFcoefficient value) { 
+// set the column coefficient of the objective function
+int lp_solver::set_obj_coeff(int rank, CUDFcoefficient value) {
 	set_coeff(rank, value);
 	return 0;
 }
@@ -295,7 +476,7 @@ int lp_solver::end_objectives(void) { return 0; }
 int lp_solver::begin_add_constraints(void) { return 0; }
 
 // begin a new constraint
-int lp_solver::new_constraint(void) { 
+int lp_solver::new_constraint(void) {
 	reset_coeffs();
 	return 0;
 }
@@ -305,72 +486,85 @@ int lp_solver::new_constraint(void) {
 CUDFcoefficient lp_solver::get_constraint_coeff(int rank) { return get_coeff(rank); }
 
 // set column coefficient of the current constraint
-int lp_solver::set_constraint_coeff(int rank, CUDFcoefficient value) { 
+int lp_solver::set_constraint_coeff(int rank, CUDFcoefficient value) {
 	set_coeff(rank, value);
 	return 0;
 }
 
-// add current constraint as a greater equal constraint
-int lp_solver::add_constraint_geq(CUDFcoefficient bound) {
+// write a constraint of the current coefficients into the constraint block
+void lp_solver::write_constraint(const char *op, CUDFcoefficient bound) {
 	if (nb_coeffs > 0) {
-		for (int i = 0; i < nb_coeffs; i++)
-			fprintf(ctlpfile, " "CUDFflagsplus"%cx%d", coefficients[i], mult, sindex[i]);
-		if (bound == 0) fprintf(ctlpfile, " >= 0\n"); else fprintf(ctlpfile, " >= "CUDFflags"\n", bound);
+		write_terms(ctlp, nb_coeffs, coefficients, sindex);
+		ctlp.put(' ');
+		ctlp.put(op);
+		ctlp.put(' ');
+		ctlp.put_int(bound);
+		ctlp.put('\n');
 		nb_constraints++;
 	}
+}
+
+// add current constraint as a greater equal constraint
+int lp_solver::add_constraint_geq(CUDFcoefficient bound) {
+	write_constraint(">=", bound);
 	return 0;
 }
 
 // add current constraint as a less or equal constraint
 int lp_solver::add_constraint_leq(CUDFcoefficient bound) {
-	if (nb_coeffs > 0) {
-		for (int i = 0; i < nb_coeffs; i++)
-			fprintf(ctlpfile, " "CUDFflagsplus"%cx%d", coefficients[i], mult, sindex[i]);
-		if (bound == 0) fprintf(ctlpfile, " <= 0\n"); else fprintf(ctlpfile, " <= "CUDFflags"\n", bound);
-		nb_constraints++;
-	}
+	write_constraint("<=", bound);
 	return 0;
 }
 
 // add current constraint as an equality constraint
 int lp_solver::add_constraint_eq(CUDFcoefficient bound) {
-	if (nb_coeffs > 0) {
-		for (int i = 0; i < nb_coeffs; i++)
-			fprintf(ctlpfile, " "CUDFflagsplus"%cx%d", coefficients[i], mult, sindex[i]);
-		if (bound == 0) fprintf(ctlpfile, " = 0\n"); else fprintf(ctlpfile, " = "CUDFflags"\n", bound);
-		nb_constraints++;
-	}
+	write_constraint("=", bound);
 	return 0;
 }
 
 // finalize constraints
-int lp_solver::end_add_constraints(void) { 
-	int nbcols = 0, nbvars = 0;
-
-	fprintf(ctlpfile, "Bounds\n");
+int lp_solver::end_add_constraints(void) {
+	ctlp.put("Bounds\n");
 	for (int i = 0; i < nb_vars; i++) {
-		fprintf(ctlpfile, " "CUDFflags" <= x%d <= "CUDFflags"\n", lb[i], i, ub[i]);
+		if (vartype[i] == 'B') continue;
+		ctlp.put(' ');
+		if (ub[i] == LLONG_MAX) {
+			ctlp.put('x');
+			ctlp.put_int(i);
+			ctlp.put(" >= ", 4);
+			ctlp.put_int(lb[i]);
+		} else {
+			ctlp.put_int(lb[i]);
+			ctlp.put(" <= x", 5);
+			ctlp.put_int(i);
+			ctlp.put(" <= ", 4);
+			ctlp.put_int(ub[i]);
+		}
+		ctlp.put('\n');
 	}
 
-	fprintf(ctlpfile, "Binaries\n");
-	for (int i = 0; i < nb_vars; i++) {
-		if ((lb[i] == 0) && (ub[i] == 1)) {
+	const char *sections[2] = {"Binaries", "Generals"};
+	const char types[2] = {'B', 'I'};
+	for (int s = 0; s < 2; s++) {
+		int nbcols = 0;
+		for (int i = 0; i < nb_vars; i++) {
+			if (vartype[i] != types[s]) continue;
+			if (nbcols == 0) {
+				ctlp.put(sections[s]);
+				ctlp.put('\n');
+			} else if (nbcols % 10 == 0) ctlp.put('\n');
+			ctlp.put(" x", 2);
+			ctlp.put_int(i);
 			nbcols++;
-			if (nbcols == 10) { fprintf(ctlpfile, "\n"); nbcols = 0; }
-			fprintf(ctlpfile, " x%d", i);
 		}
+		if (nbcols > 0) ctlp.put('\n');
 	}
-	for (int i = 0; i < nb_vars; i++) {
-		if ((lb[i] != 0) || (ub[i] != 1)) {
-			if (nbvars == 0) fprintf(ctlpfile, "\nGenerals\n");
-			nbcols++;
-			nbvars++;
-			if (nbcols == 10) { fprintf(ctlpfile, "\n"); nbcols = 0; }
-			fprintf(ctlpfile, " x%d", i);
-		}
+	ctlp.put("End\n");
+
+	ctlp.flush();
+	if (! ctlp.good() || (ctlpsize = lseek(ctlpfd, 0, SEEK_CUR)) == -1) {
+		fprintf(stderr, "lp_solver: end_add_constraints: cannot write the constraint block.\n");
+		exit(-1);
 	}
-	fprintf(ctlpfile, "\nEnd\n");
-	fclose(ctlpfile);
 	return 0;
 }
-
@@ -5,6 +5,9 @@
 /*******************************************************/
 
 // concrete class which implements an interface to a lp (cplex format) compliant solver
+// The constraint block (constraints, bounds and types) is written once in memory.
+// For each objective level, the solver reads a fifo fed with the objective and the objective constraints of the
+// previous levels, followed by the constraint block; its output is parsed line by line from a pipe.
 
 
 #ifndef _LP_SOLVER_H
@@ -12,6 +15,8 @@
 
 #include <abstract_solver.h>
 #include <scoeff_solver.h>
+#include <run_report.h>
+#include <model_writer.h>
 
 class lp_solver: public abstract_solver, public scoeff_solver<CUDFcoefficient, 0, 0> {
 public:
@@ -26,22 +31,32 @@ public:
 	CUDFcoefficient objective_value();
 	// Init solutions (required before calling get_solution)
 	int init_solutions();
+	// Get the solution for a column
+	CUDFcoefficient get_solution(int k);
+	// get the real solution for a column
+	double get_real_solution(int k);
+	// get the number of solutions found at the end of solving
+	int solutionCount() {return _solutionCount;}
+	// get the number of objectives (or sub-problems).
+	int objectiveCount() {return objectives.size();}
+	// get the solving time.
+	double timeCount() {return _timeCount;}
 
 	// Allocate some columns for integer variables
 	int set_intvar_range(int rank, CUDFcoefficient lower, CUDFcoefficient upper);
 	//set variable type to int and its range to [lower, upper] (must be used before end_objectives)
-	int set_realvar_range(int rank, CUDFcoefficient lower, CUDFcoefficient upper); //TODO
+	int set_realvar_range(int rank, CUDFcoefficient lower, CUDFcoefficient upper);
 	// set variable type to int and its range to [lower, upper] and its name to name (must be used before end_objectives)
-	int set_intvar(int rank, char* name, CUDFcoefficient lower, CUDFcoefficient upper); //TODO
+	int set_intvar(int rank, char* name, CUDFcoefficient lower, CUDFcoefficient upper);
 	// set variable type to real and its range to [lower, upper] and its name to name (must be used before end_objectives)
-	int set_realvar(int rank, char* name, CUDFcoefficient lower, CUDFcoefficient upper); //TODO
+	int set_realvar(int rank, char* name, CUDFcoefficient lower, CUDFcoefficient upper);
 
 	// set variable type to int and its range to [0, +inf[ and its name to name (must be used before end_objectives)
 	int set_intvar(int rank, char* name);
 	// set variable type to real and its range to [0, +inf[ and its name to name (must be used before end_objectives)
 	int set_realvar(int rank, char* name);
 	// set variable type to bool and its name to name (must be used before end_objectives)
-	int set_boolvar(int rank, char* name); //TODO
+	int set_boolvar(int rank, char* name);
 
 	// Init the objective function definitions
 	int begin_objectives(void);
@@ -74,36 +89,67 @@ public:
 	// End constraint definitions
 	int end_add_constraints(void);
 
-	//CUDFVersionedPackageList *all_versioned_packages;  // list of all versioned packages
-	int nb_packages; // number of packages
-
+	// variables only for internal use (should be private)
 	CUDFcoefficient *lb;          // array of lower bounds
-	CUDFcoefficient *ub;          // array of upper bounds
+	CUDFcoefficient *ub;          // array of upper bounds (LLONG_MAX if none)
+	char *vartype;                // array of variable types ('B', 'I' or 'C')
 
 	int nb_constraints; // number of constraints
 
-	CUDFcoefficient *solution; // array of solution values
+	double *solution; // array of solution values
 	CUDFcoefficient objval;    // objective value
+	vector<CUDFcoefficient> objvals; // objective values of the solved levels
 
-	char ctlpfilename[256];
-	char lpfilename[256];
-	char lpoutfilename[256];
-	FILE *lpfile, *ctlpfile;
+	char lpfilename[256];     // fifo read by the solver
+	model_sink ctlp;          // constraint block (in memory)
+	int ctlpfd;
+	off_t ctlpsize;           // size of the constraint block
 
 	char *lpsolver; // name of the solver to call
 
-	char mult;
-
 	// solver creation
 	lp_solver(char *lpsolver) {
 		this->lpsolver = lpsolver;
-		nb_packages = 0;
-		//all_versioned_packages = (CUDFVersionedPackageList *)NULL;
 		nb_constraints = 0;
-		solution = (CUDFcoefficient *)NULL;
-		lpfile = stdout;
-		mult = ' ';
+		solution = (double *)NULL;
+		lb = ub = (CUDFcoefficient *)NULL;
+		vartype = (char *)NULL;
+		ctlpfd = -1;
 	}
+
+	// solver destruction
+	~lp_solver();
+
+private:
+	// set the bounds and the type of a column
+	void set_column(int rank, char type, CUDFcoefficient lower, CUDFcoefficient upper);
+	// free a variable name (columns are always named x<rank>)
+	void drop_name(char *name);
+	// write a constraint of the current coefficients
+	void write_constraint(const char *op, CUDFcoefficient bound);
+	// write the complete problem of a level (objective, previous objectives and constraint block) into a file descriptor
+	int write_level(int fd, unsigned int iobj);
+	// run the solver on a level and parse its output
+	void run_level(unsigned int iobj);
+	// parse the solver output until its end (run by a thread while the problem is written)
+	static void *read_output(void *reader);
+	// parse a line of the solver output
+	void parse_line(char *line);
+	// start reading a solution whose objective value is written in s
+	void begin_solution(const char *s);
+	// parse the value of a column (returns false if the line is not a column)
+	bool parse_column(const char *line);
+
+	// State of the level being solved (read from the solver output)
+	bool has_solution;
+	bool infeasible;
+	bool interrupted;
+	bool reading_solution;
+	bool read_columns;
+	double level_value;
+
+	int _solutionCount;
+	double _timeCount;
 };
 
 #endif
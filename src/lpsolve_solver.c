@@ -6,6 +6,7 @@
 
 #ifdef USELPSOLVE
 
+#include <math.h>
 #include <lpsolve_solver.h>
 
 #define OUTPUT_MODEL 0
@@ -15,114 +16,294 @@ abstract_solver *new_lpsolve_solver() { return new lpsolve_solver(); }
 
 // solver initialisation
 int lpsolve_solver::init_solver(PSLProblem *problem, int other_vars) {
-  nb_packages = 0;//all_versioned_packages->size();
+  _solutionCount = 0;
+  _nodeCount = 0;
+  _timeCount = 0;
+  first_objective = 0;
+  has_incumbent = false;
+  level_solved = false;
+  current_objective = 0;
+  this->problem = problem;
 
   // Coefficient initialization
-  initialize_coeffs(nb_packages + other_vars);
-
-  //this->all_versioned_packages = all_versioned_packages;
-  if (verbosity > 0) printf("nb vars = %d\n", nb_vars);
+  initialize_coeffs(problem->rankCount() + other_vars);
 
   if ((lp = make_lp(0, nb_vars)) == NULL) {
-    fprintf(stderr, "Cannot create the lpsolve solver.\n");
+    fprintf(stderr, "lpsolve_solver: init_solver: cannot create the lpsolve solver.\n");
     exit(-1);
   }
 
-  if (verbosity < 2) set_verbose(lp, -1);
-
-  if ((lb = (CUDFcoefficient *)malloc((nb_vars+1)*sizeof(CUDFcoefficient))) == (CUDFcoefficient *)NULL) {
-    fprintf(stderr, "glpk_solver: init_solver: not enough memory for lb.\n");
+  set_verbose(lp, verbosity >= VERBOSE ? NORMAL : (verbosity >= DEFAULT ? IMPORTANT : NEUTRAL));
+
+  // columns are indexed from 1
+  lb = (double *)malloc((nb_vars+1)*sizeof(double));
+  ub = (double *)malloc((nb_vars+1)*sizeof(double));
+  vartype = (char *)malloc((nb_vars+1)*sizeof(char));
+  varname = (char **)malloc((nb_vars+1)*sizeof(char *));
+  incumbent = (double *)malloc((nb_vars+1)*sizeof(double));
+
+  if ((lb  == (double *)NULL) ||
+      (ub  == (double *)NULL) ||
+      (vartype  == (char *)NULL) ||
+      (varname  == (char **)NULL) ||
+      (incumbent  == (double *)NULL)) {
+    fprintf(stderr, "lpsolve_solver: init_solver: not enough memory.\n");
     exit(-1);
   }
+  memory_alloc(MEM_SOLVER, (nb_vars+1) * (3 * sizeof(double) + sizeof(char) + sizeof(char *)));
 
-  if ((ub = (CUDFcoefficient *)malloc((nb_vars+1)*sizeof(CUDFcoefficient))) == (CUDFcoefficient *)NULL) {
-    fprintf(stderr, "glpk_solver: init_solver: not enough memory for ub.\n");
-    exit(-1);
+  for (int i = 0; i <= nb_vars; i++) {
+    lb[i] = 0;
+    ub[i] = 1;
+    vartype[i] = 'B';
+    varname[i] = (char *)NULL;
   }
 
-  for (int i = 0; i <= nb_vars; i++) { lb[i] = 0; ub[i] = 1; }
-
+  init_vars(problem, nb_vars);
   return 0;
 }
 
-// Set the range of an integer variable
-int lpsolve_solver::set_intvar_range(int rank, CUDFcoefficient lower, CUDFcoefficient upper) { 
+// solver destruction
+lpsolve_solver::~lpsolve_solver() {
+  if (lp != (lprec *)NULL) {
+    delete_lp(lp);
+    free(lb);
+    free(ub);
+    free(vartype);
+    free(varname);
+    free(incumbent);
+    memory_free(MEM_SOLVER, (nb_vars+1) * (3 * sizeof(double) + sizeof(char) + sizeof(char *)));
+  }
+  if (solution != (double *)NULL) {
+    free(solution);
+    memory_free(MEM_SOLVER, nb_vars*sizeof(double));
+  }
+}
+
+// set the bounds and the type of a column
+void lpsolve_solver::set_column(int rank, char type, double lower, double upper) {
   lb[rank+1] = lower;
   ub[rank+1] = upper;
-  return 0; 
+  vartype[rank+1] = type;
+}
+
+// Set the range of an integer variable
+int lpsolve_solver::set_intvar_range(int rank, CUDFcoefficient lower, CUDFcoefficient upper) {
+  set_column(rank, 'I', lower, upper);
+  return 0;
+}
+
+// Set the range of a real variable
+int lpsolve_solver::set_realvar_range(int rank, CUDFcoefficient lower, CUDFcoefficient upper) {
+  set_column(rank, 'C', lower, upper);
+  return 0;
+}
+
+// set variable type to int and its range to [lower, upper] and its name to name (must be used before end_objectives)
+int lpsolve_solver::set_intvar(int rank, char* name, CUDFcoefficient lower, CUDFcoefficient upper) {
+  varname[rank+1] = name;
+  return set_intvar_range(rank, lower, upper);
+}
+
+// set variable type to real and its range to [lower, upper] and its name to name (must be used before end_objectives)
+int lpsolve_solver::set_realvar(int rank, char* name, CUDFcoefficient lower, CUDFcoefficient upper) {
+  varname[rank+1] = name;
+  return set_realvar_range(rank, lower, upper);
+}
+
+// set variable type to int and its range to [0, +inf[ and its name to name (must be used before end_objectives)
+int lpsolve_solver::set_intvar(int rank, char* name) {
+  varname[rank+1] = name;
+  set_column(rank, 'I', 0, get_infinite(lp));
+  return 0;
+}
+
+// set variable type to real and its range to [0, +inf[ and its name to name (must be used before end_objectives)
+int lpsolve_solver::set_realvar(int rank, char* name) {
+  varname[rank+1] = name;
+  set_column(rank, 'C', 0, get_infinite(lp));
+  return 0;
+}
+
+// set variable type to bool and its name to name (must be used before end_objectives)
+int lpsolve_solver::set_boolvar(int rank, char* name) {
+  varname[rank+1] = name;
+  set_column(rank, 'B', 0, 1);
+  return 0;
 }
 
 // write the lp to a file
-int lpsolve_solver::writelp(char *filename) { write_lp(lp, filename); return 0; }
+int lpsolve_solver::writelp(char *filename) {
+  trace_span span(filename, "writer");
+  // name the columns from their rank (if the variables were created without names)
+  if (! variable_names) {
+    for (int k = 0; k < problem->rankCount() && k < nb_vars; k++)
+      set_col_name(lp, k+1, C_STR(problem->rankName(k)));
+  }
+  return write_lp(lp, filename) ? 0 : -1;
+}
 
 // call to the lpsolve solver (bypassing name issues)
 int lpsolve(lprec *lp) { return solve(lp); }
 
+// start the next level from the solution of the previous one
+// (lp_solve has no mip start: the solution is turned into a starting basis of the relaxation)
+void lpsolve_solver::guess_start() {
+  int *basis = (int *)malloc((1 + get_Nrows(lp) + get_Ncolumns(lp))*sizeof(int));
+  if (basis == (int *)NULL) {
+    fprintf(stderr, "lpsolve_solver: guess_start: not enough memory.\n");
+    exit(-1);
+  }
+  if (guess_basis(lp, incumbent, basis)) set_basis(lp, basis, TRUE);
+  free(basis);
+}
+
 // solve the lp
 int lpsolve_solver::solve() {
   int status = 0, nb_objectives = objectives.size();
 
-  if (nb_objectives == 1) {
+  // Get the last non empty objective
+  int last_objective = nb_objectives - 1;
+  while (last_objective > first_objective && objectives[last_objective]->nb_coeffs == 0) last_objective--;
 
+  // The presolve removes rows and columns from the model: it is only used if there is a single level to solve
+  if (first_objective == last_objective)
     set_presolve(lp, PRESOLVE_ROWS | PRESOLVE_COLS | PRESOLVE_LINDEP |
 		 PRESOLVE_REDUCEMIP | PRESOLVE_REDUCEGCD | PRESOLVE_PROBEFIX | PRESOLVE_PROBEREDUCE, get_presolveloops(lp));
+  else
+    set_presolve(lp, PRESOLVE_NONE, get_presolveloops(lp));
+  set_mip_gap(lp, FALSE, 0.0);
+
+  phase_timer timer;
+  // Solve the objectives in a lexical order
+  for (int i = first_objective; i < nb_objectives; i++) {
+    level_record level(i);
+    the_report.begin_level(level);
+    set_timeout(lp, (long) time_limit);
     status = lpsolve(lp);
-    if ((status == OPTIMAL) || (status == SUBOPTIMAL) || (status == PRESOLVED)) return 1; else return 0;
-
-  } else {
-
-    lprec *lps = copy_lp(lp); // Using a copy seems to be the only way to make it work
-
-    for (int k = 0; k < nb_objectives; k++) {
-
-      set_presolve(lp, PRESOLVE_ROWS | PRESOLVE_COLS | PRESOLVE_LINDEP | 
-		   PRESOLVE_REDUCEMIP | PRESOLVE_REDUCEGCD | PRESOLVE_PROBEFIX | PRESOLVE_PROBEREDUCE, get_presolveloops(lp));
-      status = lpsolve(lp);
-
-      if (k + 1 < nb_objectives) {
-	CUDFcoefficient objval = objective_value();
-	
-	if (verbosity > 0) printf(">>> Objective %d value : "CUDFflags"\n", k, objval);
-	
-	// Build the objective function
-	if (! set_obj_fnex(lps, objectives[k+1]->nb_coeffs, objectives[k+1]->coefficients, objectives[k+1]->sindex)) {
-	  fprintf(stderr, "generate_milp: cannot create objective function.\n");
-	  exit(-1);
-	}
-
-	set_add_rowmode(lps, TRUE);
-	add_constraintex(lps, objectives[k]->nb_coeffs, objectives[k]->coefficients, objectives[k]->sindex, EQ, objval);
-	set_add_rowmode(lps, FALSE);
-	/*
-	      set_constr_type(lps, k+1, EQ);
-	      set_rh(lps, k+1, objval);
-	*/
-	lp = copy_lp(lps);
-	if (OUTPUT_MODEL) write_lp(lp, (char *)"lpsolvepbs1.lp"); 
-      }
+    long long nodes = get_total_nodes(lp);
+    int solutions = get_solutioncount(lp);
+    current_objective = i;
+    level_solved = (status == OPTIMAL) || (status == PRESOLVED) || solutions > 0;
+    _solutionCount += solutions;
+    _nodeCount += nodes;
+    _timeCount = timer.wall();
+    report_level(level, status, nodes, solutions);
+
+    if ((status == OPTIMAL) || (status == PRESOLVED)) {
+      if (i < last_objective) {
+        // Get next non empty objective
+        int previ = i, nexti = i + 1;
+        while (objectives[nexti]->nb_coeffs == 0) nexti++;
+        i = nexti - 1;
+
+        CUDFcoefficient objval = objective_value();
+
+        if (verbosity >= DEFAULT) printf(">>>> Objective value %d = " CUDFflags "\n", previ, objval);
+
+        // Save the solution (starting point of the next level)
+        incumbent[0] = 0;
+        for (int k = 1; k <= nb_vars; k++) incumbent[k] = get_var_primalresult(lp, get_Norig_rows(lp) + k);
+        has_incumbent = true;
+
+        // Add objective previ = objval constraint
+        if (! add_constraintex(lp, objectives[previ]->nb_coeffs, objectives[previ]->coefficients, objectives[previ]->sindex, EQ, objval)) {
+          fprintf(stderr, "lpsolve_solver: solve: cannot add %d objective as constraint.\n", previ);
+          exit(-1);
+        }
+
+        // Set objective nexti as the actual objective function
+        if (! set_obj_fnex(lp, objectives[nexti]->nb_coeffs, objectives[nexti]->coefficients, objectives[nexti]->sindex)) {
+          fprintf(stderr, "lpsolve_solver: solve: cannot set objective %d.\n", nexti);
+          exit(-1);
+        }
+        guess_start();
+
+        // Output model to file (when requested)
+        if (verbosity >= VERBOSE) {
+          char buffer[1024];
+          sprintf(buffer, "lpsolvepb-%d.lp", nexti);
+          writelp(buffer);
+        }
+      } else
+        return OPTIMUM;
+    } else if (status == SUBOPTIMAL || status == TIMEOUT) {
+      // time limit: the incumbent of the previous level is still a solution
+      return _solutionCount > 0 ? SAT : UNKNOWN;
+    } else if (status == INFEASIBLE) {
+      return UNSAT;
+    } else {
+      if (verbosity >= DEFAULT)
+        fprintf(stderr, "lp_solve solution status = %d\n", status);
+      return ERROR;
     }
   }
 
-  if ((status == OPTIMAL) || (status == SUBOPTIMAL) || (status == PRESOLVED)) return 1; else return 0;
+  return 0;
+}
+
+// record the statistics of the objective level which has just been solved
+void lpsolve_solver::report_level(level_record &level, int status, long long nodes, int solutions) {
+  level.nodes = nodes;
+  level.solutions = solutions;
+  switch (status) {
+  case OPTIMAL:
+  case PRESOLVED: level.status = OPTIMUM; level.gap = 0; break;
+  case SUBOPTIMAL: level.status = SAT; break;
+  case TIMEOUT: level.status = solutions > 0 ? SAT : UNKNOWN; break;
+  case INFEASIBLE: level.status = UNSAT; break;
+  default: level.status = ERROR; break;
+  }
+  if (level.status == OPTIMUM || level.status == SAT) {
+    level.has_value = true;
+    level.value = get_objective(lp);
+  }
+  the_report.end_level(level);
+}
+
+// value of an objective for the incumbent
+double lpsolve_solver::incumbent_value(int objective) {
+  double value = 0;
+  for (int k = 0; k < objectives[objective]->nb_coeffs; k++)
+    value += objectives[objective]->coefficients[k] * incumbent[objectives[objective]->sindex[k]];
+  return value;
 }
 
 // return the objective value
-CUDFcoefficient lpsolve_solver::objective_value() { return (CUDFcoefficient)nearbyint(get_objective(lp)); }
+CUDFcoefficient lpsolve_solver::objective_value() {
+  // the branch-and-bound may have stopped before finding a solution of the current level
+  if (! level_solved && has_incumbent) return (CUDFcoefficient)nearbyint(incumbent_value(current_objective));
+  return (CUDFcoefficient)nearbyint(get_objective(lp));
+}
 
 // initialize the solutions
-int lpsolve_solver::init_solutions() { return 0; }
+int lpsolve_solver::init_solutions() {
+  if (solution == (double *)NULL) {
+    if ((solution = (double *)malloc(nb_vars*sizeof(double))) == (double *)NULL) {
+      fprintf(stderr, "lpsolve_solver: init_solutions: cannot get enough memory to store solutions.\n");
+      exit(-1);
+    }
+    memory_alloc(MEM_SOLVER, nb_vars*sizeof(double));
+  }
+  if (! level_solved && has_incumbent) {
+    // the solution of the previous level
+    for (int k = 0; k < nb_vars; k++) solution[k] = incumbent[k + 1];
+    return 0;
+  }
+  // get_ptr_variables gives a solution array that only takes into account columns left by the presolve.
+  // Thus, the only way to get all solutions is the following one ... no comment ...
+  for (int k = 0; k < nb_vars; k++) solution[k] = get_var_primalresult(lp, get_Norig_rows(lp) + k + 1);
+  return 0;
+}
 
-// return the package status within final configuration
-//CUDFcoefficient lpsolve_solver::get_solution(CUDFVersionedPackage *package) {
-//  // get_ptr_variables gives a solution array that only takes into account columns left by the presolve.
-//  // Thus, the only way to get all solutions is the following one ... no comment ...
-//  return (CUDFcoefficient)nearbyint(get_var_primalresult(lp, get_Norig_rows(lp) + package->rank + 1));
-//}
+// return the status of a column within final configuration
+CUDFcoefficient lpsolve_solver::get_solution(int k) { return (CUDFcoefficient)nearbyint(solution[k]); }
+double lpsolve_solver::get_real_solution(int k) { return solution[k]; }
 
 // initialize the objective function
-int lpsolve_solver::begin_objectives(void) { 
+int lpsolve_solver::begin_objectives(void) {
   set_minim(lp);  // Problem is minimization
-  return 0; 
+  return 0;
 }
 
 // return the package coefficient of the objective value
@@ -136,78 +317,61 @@ CUDFcoefficient lpsolve_solver::get_obj_coeff(int rank) { return (CUDFcoefficien
 // set column coefficient of the objective value
 int lpsolve_solver::set_obj_coeff(int rank, CUDFcoefficient value) { set_coeff(rank, value); return 0; }
 
-// initialize an additional objective function 
+// initialize an additional objective function
 int lpsolve_solver::new_objective(void) {
   reset_coeffs();
   return 0;
 }
 
 // add an additional objective function
-int lpsolve_solver::add_objective(void) { 
-  push_obj(); 
+int lpsolve_solver::add_objective(void) {
+  push_obj();
   return 0;
 }
 
 // finalize the objective function
 int lpsolve_solver::end_objectives(void) {
 
-  // Build the objective function
-  if (! set_obj_fnex(lp, objectives[0]->nb_coeffs, objectives[0]->coefficients, objectives[0]->sindex)) {
-    fprintf(stderr, "generate_milp: cannot create objective function.\n");
-    exit(-1);
-  }
-
   // Use names for colunms
   set_use_names(lp, FALSE, TRUE);
-//  for (CUDFVersionedPackageListIterator ipkg = all_versioned_packages->begin(); ipkg != all_versioned_packages->end(); ipkg++) {
-//    int i = (*ipkg)->rank + 1;
-//    if ((! set_bounds(lp, i, 0, 1)) ||
-//	(! set_binary(lp, i, TRUE)) ||
-//	(! set_col_name(lp, i, (*ipkg)->versioned_name))) {
-//      fprintf(stderr, "generate_milp: cannot set type, bounds or name for objective function a.\n");
-//      exit(-1);
-//    }
-//  }
-  for (int i = nb_packages + 1; i <= nb_vars; i++) {
-    char *name;
-    char buffer[20];
-
-    sprintf(buffer, "x%d", i);
-    if ((name = (char *)malloc(strlen(buffer)+1)) == (char *)NULL) {
-      fprintf(stderr, "CUDF error: can not alloc memory for variable name in glpk_solver::end_objective.\n");
+  for (int i = 1; i <= nb_vars; i++) {
+    if ((! set_bounds(lp, i, lb[i], ub[i])) ||
+        (vartype[i] == 'B' && ! set_binary(lp, i, TRUE)) ||
+        (vartype[i] == 'I' && ! set_int(lp, i, TRUE))) {
+      fprintf(stderr, "lpsolve_solver: end_objectives: cannot set type or bounds of column %d.\n", i);
       exit(-1);
     }
-    strcpy(name, buffer);
-
-    if ((lb[i] == 0) && (ub[i] == 1)) {
-      if ((! set_bounds(lp, i, 0, 1)) ||
-	  (! set_binary(lp, i, TRUE)) ||
-	  (! set_col_name(lp, i, name))) {
-	fprintf(stderr, "generate_milp: cannot set type, bounds or name for objective function b.\n");
-	exit(-1);
-      }
-    } else {
-      if ((! set_bounds(lp, i, lb[i], ub[i])) ||
-	  (! set_int(lp, i, TRUE)) ||
-	  (! set_col_name(lp, i, name))) {
-	fprintf(stderr, "generate_milp: cannot set type, bounds or name for objective function c.\n");
-	exit(-1);
+    // lp_solve keeps its own copy of the names
+    if (varname[i] != (char *)NULL) {
+      if (! set_col_name(lp, i, varname[i])) {
+        fprintf(stderr, "lpsolve_solver: end_objectives: cannot set name of column %d.\n", i);
+        exit(-1);
       }
+      memory_free(MEM_NAMES, strlen(varname[i]) + 1);
+      free(varname[i]);
+      varname[i] = (char *)NULL;
     }
   }
-  /*
-  for (unsigned int k = 0; k < objectives.size(); k++) {
-    add_constraintex(lp, objectives[k]->nb_coeffs, objectives[k]->coefficients, objectives[k]->sindex, EQ, 0);
-    set_constr_type(lp, k+1, FR);
+
+  if (objectives.size() > 0) {
+    // Set the first non empty objective as the actual objective function
+    for (; first_objective < (int)objectives.size(); first_objective++)
+      if (objectives[first_objective]->nb_coeffs > 0) break;
+    if (first_objective == (int)objectives.size()) first_objective--; // So that we solve at least one pbs
+    if (! set_obj_fnex(lp, objectives[first_objective]->nb_coeffs, objectives[first_objective]->coefficients, objectives[first_objective]->sindex)) {
+      fprintf(stderr, "lpsolve_solver: end_objectives: cannot create objective function.\n");
+      exit(-1);
+    }
   }
-  */
   return 0;
 }
 
 // initialize constraints
-int lpsolve_solver::begin_add_constraints(void) { 
+// the rows are loaded in bulk: in row mode, lp_solve appends them to a row-wise matrix
+// which is converted once at the end of the loading
+int lpsolve_solver::begin_add_constraints(void) {
   set_add_rowmode(lp, TRUE);
-  return 0; 
+  return 0;
 }
 
 // begin a new constraint
@@ -226,34 +390,43 @@ CUDFcoefficient lpsolve_solver::get_constraint_coeff(int rank) { return (CUDFcoe
 //}
 
 // set package coefficient of the constraint under construction
-int lpsolve_solver::set_constraint_coeff(int rank, CUDFcoefficient value) { 
+int lpsolve_solver::set_constraint_coeff(int rank, CUDFcoefficient value) {
   set_coeff(rank, value);
   return 0;
 }
 
 // add constraint under construction as a greater or equal constraint
 int lpsolve_solver::add_constraint_geq(CUDFcoefficient bound) {
-  if (nb_coeffs > 0) add_constraintex(lp, nb_coeffs, coefficients, sindex, GE, bound);
+  if (nb_coeffs > 0 && ! add_constraintex(lp, nb_coeffs, coefficients, sindex, GE, bound)) {
+    fprintf(stderr, "lpsolve_solver: add_constraint_geq: cannot create geq constraint.\n");
+    exit(-1);
+  }
   return 0;
 }
 
 // add constraint under construction as a less or equal constraint
 int lpsolve_solver::add_constraint_leq(CUDFcoefficient bound) {
-  if (nb_coeffs > 0) add_constraintex(lp, nb_coeffs, coefficients, sindex, LE, bound);
+  if (nb_coeffs > 0 && ! add_constraintex(lp, nb_coeffs, coefficients, sindex, LE, bound)) {
+    fprintf(stderr, "lpsolve_solver: add_constraint_leq: cannot create leq constraint.\n");
+    exit(-1);
+  }
   return 0;
 }
 
 // add constraint under construction as an equality constraint
 int lpsolve_solver::add_constraint_eq(CUDFcoefficient bound) {
-  if (nb_coeffs > 0) add_constraintex(lp, nb_coeffs, coefficients, sindex, EQ, bound);
+  if (nb_coeffs > 0 && ! add_constraintex(lp, nb_coeffs, coefficients, sindex, EQ, bound)) {
+    fprintf(stderr, "lpsolve_solver: add_constraint_eq: cannot create eq constraint.\n");
+    exit(-1);
+  }
   return 0;
 }
 
 // finalize constraints
-int lpsolve_solver::end_add_constraints(void) { 
+int lpsolve_solver::end_add_constraints(void) {
   set_add_rowmode(lp, FALSE);
-  if (OUTPUT_MODEL) write_lp(lp, (char *)"lpsolvepbs.lp"); 
-  return 0; 
+  if (OUTPUT_MODEL || verbosity >= VERBOSE) writelp(C_STR("lpsolvepb.lp"));
+  return 0;
 }
 
 #endif
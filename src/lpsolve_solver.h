@@ -11,6 +11,7 @@
 
 #include <abstract_solver.h>
 #include <scoeff_solver.h>
+#include <run_report.h>
 #include <lpsolve/lp_lib.h>
 
 class lpsolve_solver: public abstract_solver, public scoeff_solver<double, 1, 0> {
@@ -20,6 +21,18 @@ class lpsolve_solver: public abstract_solver, public scoeff_solver<double, 1, 0>
 
   // Allocate some columns for integer variables
   int set_intvar_range(int rank, CUDFcoefficient lower, CUDFcoefficient upper);
+  //set variable type to real and its range to [lower, upper] (must be used before end_objectives)
+  int set_realvar_range(int rank, CUDFcoefficient lower, CUDFcoefficient upper);
+  // set variable type to int and its range to [lower, upper] and its name to name (must be used before end_objectives)
+  int set_intvar(int rank, char* name, CUDFcoefficient lower, CUDFcoefficient upper);
+  // set variable type to real and its range to [lower, upper] and its name to name (must be used before end_objectives)
+  int set_realvar(int rank, char* name, CUDFcoefficient lower, CUDFcoefficient upper);
+  // set variable type to int and its range to [0, +inf[ and its name to name (must be used before end_objectives)
+  int set_intvar(int rank, char* name);
+  // set variable type to real and its range to [0, +inf[ and its name to name (must be used before end_objectives)
+  int set_realvar(int rank, char* name);
+  // set variable type to bool and its name to name (must be used before end_objectives)
+  int set_boolvar(int rank, char* name);
 
   // Write the lp on a file
   int writelp(char *filename);
@@ -30,16 +43,26 @@ class lpsolve_solver: public abstract_solver, public scoeff_solver<double, 1, 0>
   CUDFcoefficient objective_value();
   // Init solutions (required before calling get_solution)
   int init_solutions();
-  // Get the solution for a package
-  //CUDFcoefficient get_solution(CUDFVersionedPackage *package);
+  // Get the solution for a column
+  CUDFcoefficient get_solution(int k);
+  // get the real solution for a column
+  double get_real_solution(int k);
+  // get the number of solutions found at the end of solving
+  int solutionCount() { return _solutionCount; }
+  // get the number of objectives (or sub-problems).
+  int objectiveCount() { return objectives.size(); }
+  // get the number of nodes at the end of solving
+  int nodeCount() { return _nodeCount; }
+  // get the solving time.
+  double timeCount() { return _timeCount; }
 
   // Init the objective function definitions
   int begin_objectives(void);
-  // Get current objective coefficient of package 
+  // Get current objective coefficient of package
   //CUDFcoefficient get_obj_coeff(CUDFVersionedPackage *package);
   // Get current objective coefficient of a column
   CUDFcoefficient get_obj_coeff(int rank);
-  // Set current objective coefficient of package 
+  // Set current objective coefficient of package
   //int set_obj_coeff(CUDFVersionedPackage *package, CUDFcoefficient value);
   // Set current objective coefficient of column
   int set_obj_coeff(int rank, CUDFcoefficient value);
@@ -72,20 +95,48 @@ class lpsolve_solver: public abstract_solver, public scoeff_solver<double, 1, 0>
   int end_add_constraints(void);
 
   lprec *lp; // internal solver representation
-  //CUDFVersionedPackageList *all_versioned_packages;  // list of all versioned packages
-  int nb_packages; // number of packages
+  PSLProblem *problem; // problem (used to generate the variable names on demand)
+
+  int first_objective;
 
   double *solution; // array of solution values
 
-  CUDFcoefficient *lb, *ub;          // arrays of lower and upper bounds
+  double *lb, *ub;   // arrays of lower and upper bounds (ub = +inf if none)
+  char *vartype;     // array of variable types ('B', 'I' or 'C')
+  char **varname;    // array of variable names
+
+  // Solution of the last solved level: starting point of the next one (indexed from 1)
+  double *incumbent;
+  bool has_incumbent;
+  // The lp holds a solution of the level which is solved (otherwise the incumbent is the solution)
+  bool level_solved;
+  int current_objective;
 
   // solver creation
   lpsolve_solver(void) {
     lp = (lprec *)NULL;
-    //all_versioned_packages = (CUDFVersionedPackageList *)NULL;
-    solution = (double *)NULL;
-    lb = ub = (CUDFcoefficient *)NULL;
+    solution = incumbent = (double *)NULL;
+    lb = ub = (double *)NULL;
+    vartype = (char *)NULL;
+    varname = (char **)NULL;
   }
+
+  // solver destruction
+  ~lpsolve_solver();
+
+ private:
+  // set the bounds and the type of a column
+  void set_column(int rank, char type, double lower, double upper);
+  // start the next level from the solution of the previous one
+  void guess_start();
+  // record the statistics of the objective level which has just been solved
+  void report_level(level_record &level, int status, long long nodes, int solutions);
+  // value of an objective for the incumbent
+  double incumbent_value(int objective);
+
+  int _solutionCount;
+  int _nodeCount;
+  double _timeCount;
 };
 
 #endif
@@ -0,0 +1,82 @@
+/*******************************************************/
+/* oPoSSuM solver: memory_usage.h                      */
+/* Memory accounting per subsystem                     */
+/* (c) Arnaud Malapert I3S (UNS-CNRS) 2012             */
+/*******************************************************/
+
+// Allocations of the main data structures are tracked by subsystem.
+// The resident set size of the process is sampled at the end of each phase (see run_report).
+
+#ifndef _MEMORY_USAGE_H
+#define _MEMORY_USAGE_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+// Subsystems
+#define MEM_TREE 0        // nodes and links of the network
+#define MEM_COEFFS 1      // scoeff_solver arrays (sized by the number of columns)
+#define MEM_OBJECTIVES 2  // saved objective coefficients
+#define MEM_NAMES 3       // variable names
+#define MEM_SOLVER 4      // solver interface arrays (bounds, types, solutions ...)
+#define MEM_MODEL 5       // in-memory copy of the model (see milp_model)
+#define MEM_SUBSYSTEMS 6
+
+class memory_counter {
+public:
+	long long current;      // bytes currently allocated
+	long long peak;         // peak of current
+	long long allocations;  // number of allocations
+
+	memory_counter() : current(0), peak(0), allocations(0) {}
+};
+
+// counters of each subsystem (header only, so that it can be used by the network alone)
+inline memory_counter *memory_counters() {
+	static memory_counter counters[MEM_SUBSYSTEMS];
+	return counters;
+}
+
+inline const char *memory_subsystem_name(int subsystem) {
+	static const char *names[MEM_SUBSYSTEMS] = {"tree", "coefficients", "objectives", "names", "solver", "model"};
+	return names[subsystem];
+}
+
+// record an allocation (thread safe)
+inline void memory_alloc(int subsystem, size_t bytes) {
+	memory_counter &c = memory_counters()[subsystem];
+	long long current = __sync_add_and_fetch(&c.current, (long long) bytes);
+	__sync_add_and_fetch(&c.allocations, 1LL);
+	long long peak = c.peak;
+	while(current > peak && ! __sync_bool_compare_and_swap(&c.peak, peak, current)) {
+		peak = c.peak;
+	}
+}
+
+// record a deallocation (thread safe)
+inline void memory_free(int subsystem, size_t bytes) {
+	__sync_sub_and_fetch(&memory_counters()[subsystem].current, (long long) bytes);
+}
+
+// current resident set size in bytes (0 if unknown)
+inline long long memory_rss() {
+	long long size, resident = 0;
+	FILE *statm = fopen("/proc/self/statm", "r");
+	if(statm) {
+		if(fscanf(statm, "%lld %lld", &size, &resident) != 2) resident = 0;
+		fclose(statm);
+	}
+	return resident * sysconf(_SC_PAGESIZE);
+}
+
+// peak resident set size in bytes (ru_maxrss may lag behind the current size)
+inline long long memory_peak_rss() {
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	long long rss = memory_rss();
+	return usage.ru_maxrss * 1024LL > rss ? usage.ru_maxrss * 1024LL : rss;
+}
+
+#endif
@@ -0,0 +1,191 @@
+/*******************************************************/
+/* oPoSSuM solver: milp_model.c                        */
+/* In-memory copy of the generated MILP model          */
+/* (c) Arnaud Malapert I3S (UNS-CNRS) 2012             */
+/*******************************************************/
+
+#include <milp_model.h>
+#include <sstream>
+
+//----------------------------------------------------------------------------------------------------
+// Model
+//----------------------------------------------------------------------------------------------------
+
+void milp_model::init(PSLProblem *problem, int nb_vars) {
+	clear();
+	this->problem = problem;
+	this->nb_vars = nb_vars;
+	vartype.assign(nb_vars, 'B');
+	lb.assign(nb_vars, 0);
+	ub.assign(nb_vars, 1);
+}
+
+void milp_model::set_column(int rank, char type, CUDFcoefficient lower, CUDFcoefficient upper) {
+	vartype[rank] = type;
+	lb[rank] = lower;
+	ub[rank] = upper;
+}
+
+void milp_model::add_objective(int nb_coeffs, const int *sindex, const CUDFcoefficient *coefficients) {
+	obj_index.insert(obj_index.end(), sindex, sindex + nb_coeffs);
+	obj_coeff.insert(obj_coeff.end(), coefficients, coefficients + nb_coeffs);
+	obj_start.push_back(obj_index.size());
+}
+
+void milp_model::add_row(int nb_coeffs, const int *sindex, const CUDFcoefficient *coefficients, char sense, CUDFcoefficient bound) {
+	row_index.insert(row_index.end(), sindex, sindex + nb_coeffs);
+	row_coeff.insert(row_coeff.end(), coefficients, coefficients + nb_coeffs);
+	row_start.push_back(row_index.size());
+	row_sense.push_back(sense);
+	rhs.push_back(bound);
+}
+
+void milp_model::replay_rows(abstract_solver &solver) const {
+	for (int i = 0; i < rowCount(); i++) {
+		solver.new_constraint();
+		for (long long k = row_start[i]; k < row_start[i + 1]; k++) solver.set_constraint_coeff(row_index[k], row_coeff[k]);
+		switch (row_sense[i]) {
+		case 'G': solver.add_constraint_geq(rhs[i]); break;
+		case 'L': solver.add_constraint_leq(rhs[i]); break;
+		default: solver.add_constraint_eq(rhs[i]); break;
+		}
+	}
+}
+
+string milp_model::column_name(int rank) const {
+	if(problem) return problem->rankName(rank);
+	ostringstream name;
+	name << "x" << rank;
+	return name.str();
+}
+
+size_t milp_model::footprint() const {
+	return vartype.capacity() * sizeof(char)
+			+ (lb.capacity() + ub.capacity() + obj_coeff.capacity() + row_coeff.capacity() + rhs.capacity()) * sizeof(CUDFcoefficient)
+			+ (obj_start.capacity() + row_start.capacity()) * sizeof(long long)
+			+ (obj_index.capacity() + row_index.capacity()) * sizeof(int)
+			+ row_sense.capacity() * sizeof(char);
+}
+
+void milp_model::account() {
+	size_t bytes = footprint();
+	if(bytes > accounted) memory_alloc(MEM_MODEL, bytes - accounted);
+	else memory_free(MEM_MODEL, accounted - bytes);
+	accounted = bytes;
+}
+
+void milp_model::clear() {
+	vector<char>().swap(vartype);
+	vector<CUDFcoefficient>().swap(lb);
+	vector<CUDFcoefficient>().swap(ub);
+	vector<long long>(1, 0).swap(obj_start);
+	vector<int>().swap(obj_index);
+	vector<CUDFcoefficient>().swap(obj_coeff);
+	vector<long long>(1, 0).swap(row_start);
+	vector<int>().swap(row_index);
+	vector<CUDFcoefficient>().swap(row_coeff);
+	vector<char>().swap(row_sense);
+	vector<CUDFcoefficient>().swap(rhs);
+	nb_vars = 0;
+	memory_free(MEM_MODEL, accounted);
+	accounted = 0;
+}
+
+//----------------------------------------------------------------------------------------------------
+// Solver proxy
+//----------------------------------------------------------------------------------------------------
+
+int model_recorder::init_solver(PSLProblem *problem, int other_vars) {
+	initialize_coeffs(problem->rankCount() + other_vars);
+	model->init(problem, nb_vars);
+	int status = solver->init_solver(problem, other_vars);
+	// the solver sets the default column types by itself: they are replayed here without names
+	bool names = variable_names;
+	variable_names = false;
+	forward = false;
+	init_vars(problem, nb_vars);
+	forward = true;
+	variable_names = names;
+	return status;
+}
+
+int model_recorder::set_intvar_range(int rank, CUDFcoefficient lower, CUDFcoefficient upper) {
+	model->set_column(rank, 'I', lower, upper);
+	return forward ? solver->set_intvar_range(rank, lower, upper) : 0;
+}
+
+int model_recorder::set_realvar_range(int rank, CUDFcoefficient lower, CUDFcoefficient upper) {
+	model->set_column(rank, 'C', lower, upper);
+	return forward ? solver->set_realvar_range(rank, lower, upper) : 0;
+}
+
+int model_recorder::set_intvar(int rank, char* name, CUDFcoefficient lower, CUDFcoefficient upper) {
+	model->set_column(rank, 'I', lower, upper);
+	return forward ? solver->set_intvar(rank, name, lower, upper) : 0;
+}
+
+int model_recorder::set_realvar(int rank, char* name, CUDFcoefficient lower, CUDFcoefficient upper) {
+	model->set_column(rank, 'C', lower, upper);
+	return forward ? solver->set_realvar(rank, name, lower, upper) : 0;
+}
+
+int model_recorder::set_intvar(int rank, char* name) {
+	model->set_column(rank, 'I', 0, MODEL_INFINITY);
+	return forward ? solver->set_intvar(rank, name) : 0;
+}
+
+int model_recorder::set_realvar(int rank, char* name) {
+	model->set_column(rank, 'C', 0, MODEL_INFINITY);
+	return forward ? solver->set_realvar(rank, name) : 0;
+}
+
+int model_recorder::set_boolvar(int rank, char* name) {
+	model->set_column(rank, 'B', 0, 1);
+	return forward ? solver->set_boolvar(rank, name) : 0;
+}
+
+int model_recorder::set_obj_coeff(int rank, CUDFcoefficient value) {
+	set_coeff(rank, value);
+	return solver->set_obj_coeff(rank, value);
+}
+
+int model_recorder::new_objective(void) {
+	reset_coeffs();
+	return solver->new_objective();
+}
+
+int model_recorder::add_objective(void) {
+	model->add_objective(nb_coeffs, sindex, coefficients);
+	return solver->add_objective();
+}
+
+int model_recorder::new_constraint(void) {
+	reset_coeffs();
+	return solver->new_constraint();
+}
+
+int model_recorder::set_constraint_coeff(int rank, CUDFcoefficient value) {
+	set_coeff(rank, value);
+	return solver->set_constraint_coeff(rank, value);
+}
+
+// the solvers ignore the rows without coefficient
+int model_recorder::add_constraint_geq(CUDFcoefficient bound) {
+	if (nb_coeffs > 0) model->add_row(nb_coeffs, sindex, coefficients, 'G', bound);
+	return solver->add_constraint_geq(bound);
+}
+
+int model_recorder::add_constraint_leq(CUDFcoefficient bound) {
+	if (nb_coeffs > 0) model->add_row(nb_coeffs, sindex, coefficients, 'L', bound);
+	return solver->add_constraint_leq(bound);
+}
+
+int model_recorder::add_constraint_eq(CUDFcoefficient bound) {
+	if (nb_coeffs > 0) model->add_row(nb_coeffs, sindex, coefficients, 'E', bound);
+	return solver->add_constraint_eq(bound);
+}
+
+int model_recorder::end_add_constraints(void) {
+	model->account();
+	return solver->end_add_constraints();
+}
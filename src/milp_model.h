@@ -0,0 +1,104 @@
+/*******************************************************/
+/* oPoSSuM solver: milp_model.h                        */
+/* In-memory copy of the generated MILP model          */
+/* (c) Arnaud Malapert I3S (UNS-CNRS) 2012             */
+/*******************************************************/
+
+// The model is recorded by a solver proxy while it is generated.
+// Rows and objectives are stored in compressed sparse row arrays, so that the model can be
+// written (see model_writer) without going through the internals of the solvers.
+
+#ifndef _MILP_MODEL_H
+#define _MILP_MODEL_H
+
+#include <proxy_solver.h>
+#include <scoeff_solver.h>
+#include <limits.h>
+
+#define MODEL_INFINITY LLONG_MAX  // upper bound of the unbounded columns
+
+class milp_model {
+public:
+	PSLProblem *problem;             // problem (used to name the columns)
+
+	// Columns
+	int nb_vars;
+	vector<char> vartype;            // 'B', 'I' or 'C'
+	vector<CUDFcoefficient> lb, ub;  // bounds (ub = MODEL_INFINITY if none)
+
+	// Objectives in lexicographic order (possibly empty)
+	vector<long long> obj_start;     // obj_start[i] is the first term of objective i (size objectiveCount() + 1)
+	vector<int> obj_index;
+	vector<CUDFcoefficient> obj_coeff;
+
+	// Rows
+	vector<long long> row_start;     // row_start[i] is the first term of row i (size rowCount() + 1)
+	vector<int> row_index;
+	vector<CUDFcoefficient> row_coeff;
+	vector<char> row_sense;          // 'G', 'L' or 'E'
+	vector<CUDFcoefficient> rhs;
+
+	int objectiveCount() const { return obj_start.size() - 1; }
+	int rowCount() const { return row_start.size() - 1; }
+	long long nonzeroCount() const { return row_index.size(); }
+
+	// reset the model with nb_vars boolean columns
+	void init(PSLProblem *problem, int nb_vars);
+	void set_column(int rank, char type, CUDFcoefficient lower, CUDFcoefficient upper);
+	// append an objective or a row made of nb_coeffs terms
+	void add_objective(int nb_coeffs, const int *sindex, const CUDFcoefficient *coefficients);
+	void add_row(int nb_coeffs, const int *sindex, const CUDFcoefficient *coefficients, char sense, CUDFcoefficient bound);
+
+	// add the rows into a solver (between begin_add_constraints and end_add_constraints)
+	void replay_rows(abstract_solver &solver) const;
+
+	// name of a column (same names as the solvers)
+	string column_name(int rank) const;
+
+	// release the arrays
+	void clear();
+	// update the memory accounted for the model (MEM_MODEL)
+	void account();
+
+	milp_model() : problem(NULL), nb_vars(0), accounted(0) { clear(); }
+	~milp_model() { clear(); }
+
+private:
+	// bytes accounted for the model
+	size_t footprint() const;
+	size_t accounted;
+};
+
+// Solver proxy which records the generated model
+class model_recorder: public proxy_solver, public scoeff_solver<CUDFcoefficient, 0, 0> {
+public:
+	milp_model *model;  // recorded model
+
+	int init_solver(PSLProblem *problem, int other_vars);
+
+	int set_intvar_range(int rank, CUDFcoefficient lower, CUDFcoefficient upper);
+	int set_realvar_range(int rank, CUDFcoefficient lower, CUDFcoefficient upper);
+	int set_intvar(int rank, char* name, CUDFcoefficient lower, CUDFcoefficient upper);
+	int set_realvar(int rank, char* name, CUDFcoefficient lower, CUDFcoefficient upper);
+	int set_intvar(int rank, char* name);
+	int set_realvar(int rank, char* name);
+	int set_boolvar(int rank, char* name);
+
+	int set_obj_coeff(int rank, CUDFcoefficient value);
+	int new_objective(void);
+	int add_objective(void);
+
+	int new_constraint(void);
+	int set_constraint_coeff(int rank, CUDFcoefficient value);
+	int add_constraint_geq(CUDFcoefficient bound);
+	int add_constraint_leq(CUDFcoefficient bound);
+	int add_constraint_eq(CUDFcoefficient bound);
+	int end_add_constraints(void);
+
+	model_recorder(abstract_solver *solver, milp_model *model) : proxy_solver(solver), model(model), forward(true) {}
+
+private:
+	bool forward;  // are the column definitions forwarded to the solver ?
+};
+
+#endif
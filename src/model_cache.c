@@ -0,0 +1,203 @@
+/*******************************************************/
+/* oPoSSuM solver: model_cache.c                       */
+/* Binary cache of the generated models                */
+/* (c) Arnaud Malapert I3S (UNS-CNRS) 2012             */
+/*******************************************************/
+
+#include <model_cache.h>
+#include <model_writer.h>
+#include <run_report.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define MODEL_CACHE_MAGIC "OPOSSUM"
+#define MODEL_CACHE_ENDIANNESS 0x01020304
+
+//----------------------------------------------------------------------------------------------------
+// Key
+//----------------------------------------------------------------------------------------------------
+
+model_key::model_key() : value(14695981039346656037ULL) {
+	add((long long) MODEL_CACHE_VERSION);
+}
+
+void model_key::add(const void *data, size_t length) {
+	const unsigned char *bytes = (const unsigned char *) data;
+	for (size_t i = 0; i < length; i++) {
+		value ^= bytes[i];
+		value *= 1099511628211ULL;
+	}
+}
+
+bool model_key::add_file(const char *filename) {
+	FILE *in = fopen(filename, "rb");
+	if (in == NULL) return false;
+	char buffer[65536];
+	size_t n;
+	while ((n = fread(buffer, 1, sizeof(buffer), in)) > 0) add(buffer, n);
+	bool ok = ! ferror(in);
+	fclose(in);
+	return ok;
+}
+
+string model_key::filename(const char *directory) const {
+	char name[32];
+	snprintf(name, sizeof(name), "/%016llx.model", value);
+	return string(directory) + name;
+}
+
+//----------------------------------------------------------------------------------------------------
+// Save
+//----------------------------------------------------------------------------------------------------
+
+template <typename T>
+static inline void put_array(model_sink &out, const vector<T> &v) {
+	if (! v.empty()) out.put((const char *) &v[0], v.size() * sizeof(T));
+}
+
+int save_cached_model(const milp_model &model, const model_key &key, const char *filename) {
+	trace_span span(filename, "writer");
+	model_cache_header header;
+	memset(&header, 0, sizeof(header));
+	strncpy(header.magic, MODEL_CACHE_MAGIC, sizeof(header.magic));
+	header.version = MODEL_CACHE_VERSION;
+	header.endianness = MODEL_CACHE_ENDIANNESS;
+	header.key = key.value;
+	header.nb_vars = model.nb_vars;
+	header.nb_objectives = model.objectiveCount();
+	header.obj_nonzeros = model.obj_index.size();
+	header.nb_rows = model.rowCount();
+	header.nonzeros = model.nonzeroCount();
+
+	// concurrent runs may save the same model: the file appears at once
+	char tmpname[4096];
+	snprintf(tmpname, sizeof(tmpname), "%s.%lu.tmp", filename, (long unsigned) getpid());
+	model_sink out;
+	if (! out.open(tmpname)) {
+		fprintf(stderr, "save_cached_model: cannot open %s.\n", tmpname);
+		return -1;
+	}
+	out.put((const char *) &header, sizeof(header));
+	put_array(out, model.lb);
+	put_array(out, model.ub);
+	put_array(out, model.obj_start);
+	put_array(out, model.obj_coeff);
+	put_array(out, model.row_start);
+	put_array(out, model.row_coeff);
+	put_array(out, model.rhs);
+	put_array(out, model.obj_index);
+	put_array(out, model.row_index);
+	put_array(out, model.vartype);
+	put_array(out, model.row_sense);
+	if (! out.close() || rename(tmpname, filename) != 0) {
+		fprintf(stderr, "save_cached_model: error while writing %s.\n", filename);
+		unlink(tmpname);
+		return -1;
+	}
+	return 0;
+}
+
+//----------------------------------------------------------------------------------------------------
+// Load
+//----------------------------------------------------------------------------------------------------
+
+cached_model::~cached_model() {
+	if (data != NULL) munmap(data, size);
+}
+
+// next array of a mapped file
+template <typename T>
+static inline const T *next_array(const char *&p, long long count) {
+	const T *array = (const T *) p;
+	p += count * sizeof(T);
+	return array;
+}
+
+bool cached_model::load(const char *filename, const model_key &key, PSLProblem *problem) {
+	trace_span span(filename, "reader");
+	int fd = open(filename, O_RDONLY);
+	if (fd == -1) return false;
+	struct stat st;
+	if (fstat(fd, &st) == -1 || st.st_size < (off_t) sizeof(header)) {
+		close(fd);
+		return false;
+	}
+	size = st.st_size;
+	data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED) {
+		data = NULL;
+		return false;
+	}
+	madvise(data, size, MADV_SEQUENTIAL);
+
+	memcpy(&header, data, sizeof(header));
+	long long n = header.nb_vars, nobj = header.nb_objectives, nrows = header.nb_rows;
+	if (strncmp(header.magic, MODEL_CACHE_MAGIC, sizeof(header.magic)) != 0 ||
+			header.version != MODEL_CACHE_VERSION ||
+			header.endianness != MODEL_CACHE_ENDIANNESS ||
+			header.key != key.value ||
+			n < problem->rankCount() || n > INT_MAX ||
+			(long long) size != (long long) sizeof(header)
+			+ (2 * n + (nobj + 1) + header.obj_nonzeros + (nrows + 1) + header.nonzeros + nrows) * 8
+			+ (header.obj_nonzeros + header.nonzeros) * 4 + n + nrows) {
+		munmap(data, size);
+		data = NULL;
+		return false;
+	}
+
+	const char *p = (const char *) data + sizeof(header);
+	lb = next_array<CUDFcoefficient>(p, n);
+	ub = next_array<CUDFcoefficient>(p, n);
+	obj_start = next_array<long long>(p, nobj + 1);
+	obj_coeff = next_array<CUDFcoefficient>(p, header.obj_nonzeros);
+	row_start = next_array<long long>(p, nrows + 1);
+	row_coeff = next_array<CUDFcoefficient>(p, header.nonzeros);
+	rhs = next_array<CUDFcoefficient>(p, nrows);
+	obj_index = next_array<int>(p, header.obj_nonzeros);
+	row_index = next_array<int>(p, header.nonzeros);
+	vartype = next_array<char>(p, n);
+	row_sense = next_array<char>(p, nrows);
+	return true;
+}
+
+//----------------------------------------------------------------------------------------------------
+// Replay
+//----------------------------------------------------------------------------------------------------
+
+int cached_model::replay(PSLProblem *problem, abstract_solver &solver) {
+	report_phase phase("load_model");
+	int nb_vars = header.nb_vars;
+
+	// the solver defines the default columns by itself (see init_vars),
+	// the bounded integer and real columns are the ones restricted by the criteria
+	solver.init_solver(problem, nb_vars - problem->rankCount());
+	for (int k = 0; k < nb_vars; k++) {
+		if (ub[k] == MODEL_INFINITY) continue;
+		if (vartype[k] == 'I') solver.set_intvar_range(k, lb[k], ub[k]);
+		else if (vartype[k] == 'C') solver.set_realvar_range(k, lb[k], ub[k]);
+	}
+
+	solver.begin_objectives();
+	for (long long i = 0; i < header.nb_objectives; i++) {
+		solver.new_objective();
+		for (long long k = obj_start[i]; k < obj_start[i + 1]; k++) solver.set_obj_coeff(obj_index[k], obj_coeff[k]);
+		solver.add_objective();
+	}
+	solver.end_objectives();
+
+	solver.begin_add_constraints();
+	for (long long i = 0; i < header.nb_rows; i++) {
+		solver.new_constraint();
+		for (long long k = row_start[i]; k < row_start[i + 1]; k++) solver.set_constraint_coeff(row_index[k], row_coeff[k]);
+		switch (row_sense[i]) {
+		case 'G': solver.add_constraint_geq(rhs[i]); break;
+		case 'L': solver.add_constraint_leq(rhs[i]); break;
+		default: solver.add_constraint_eq(rhs[i]); break;
+		}
+	}
+	solver.end_add_constraints();
+	return 0;
+}
@@ -0,0 +1,76 @@
+/*******************************************************/
+/* oPoSSuM solver: model_cache.h                       */
+/* Binary cache of the generated models                */
+/* (c) Arnaud Malapert I3S (UNS-CNRS) 2012             */
+/*******************************************************/
+
+// A generated model is saved into a binary file named after a hash of everything it depends on
+// (generator file, seed, network generation flags, criteria).
+// On a cache hit, the file is mapped into memory and replayed into the solver instead of generating the constraints.
+
+#ifndef _MODEL_CACHE_H
+#define _MODEL_CACHE_H
+
+#include <milp_model.h>
+
+#define MODEL_CACHE_VERSION 1
+
+// 64 bits FNV-1a hash of the inputs of the model generation
+class model_key {
+public:
+	unsigned long long value;
+
+	void add(const void *data, size_t length);
+	void add(const char *s) { add(s, strlen(s) + 1); }
+	void add(long long n) { add(&n, sizeof(n)); }
+	// add the content of a file, return false if it can not be read
+	bool add_file(const char *filename);
+
+	// name of the cache file in a directory
+	string filename(const char *directory) const;
+
+	model_key();
+};
+
+// Header of a cache file, followed by the arrays of the model:
+// lb, ub, obj_start, obj_coeff, row_start, row_coeff, rhs (64 bits),
+// obj_index, row_index (32 bits), vartype, row_sense (8 bits).
+struct model_cache_header {
+	char magic[8];
+	unsigned int version;
+	unsigned int endianness;
+	unsigned long long key;
+	long long nb_vars;
+	long long nb_objectives;
+	long long obj_nonzeros;
+	long long nb_rows;
+	long long nonzeros;
+};
+
+// Save a model into a cache file (written aside and renamed), return 0 on success
+int save_cached_model(const milp_model &model, const model_key &key, const char *filename);
+
+// A model mapped from a cache file
+class cached_model {
+public:
+	model_cache_header header;
+	const CUDFcoefficient *lb, *ub;
+	const long long *obj_start, *row_start;
+	const CUDFcoefficient *obj_coeff, *row_coeff, *rhs;
+	const int *obj_index, *row_index;
+	const char *vartype, *row_sense;
+
+	// map a cache file, return false if it does not exist or does not match the key and the problem
+	bool load(const char *filename, const model_key &key, PSLProblem *problem);
+	// define the model in a solver (instead of generate_constraints), return 0 on success
+	int replay(PSLProblem *problem, abstract_solver &solver);
+
+	cached_model() : data(NULL), size(0) {}
+	~cached_model();
+
+private:
+	void *data;
+	size_t size;
+};
+
+#endif
@@ -0,0 +1,305 @@
+/*******************************************************/
+/* oPoSSuM solver: model_stats.c                       */
+/* Statistics of the generated MILP model              */
+/* (c) Arnaud Malapert I3S (UNS-CNRS) 2012             */
+/*******************************************************/
+
+#include <model_stats.h>
+#include <run_report.h>
+#include <float.h>
+#include <iomanip>
+#include <sstream>
+
+model_stats *model_statistics = NULL;
+
+static inline void merge_range(double &min, double &max, double value) {
+	if(value < min) min = value;
+	if(value > max) max = value;
+}
+
+//----------------------------------------------------------------------------------------------------
+// Section
+//----------------------------------------------------------------------------------------------------
+
+stats_section::stats_section(string name, int parent) : name(name), parent(parent),
+		rows(0), columns(0), nonzeros(0), objectives(0), obj_nonzeros(0),
+		min_coeff(DBL_MAX), max_coeff(0), min_rhs(DBL_MAX), max_rhs(0), time(0) {
+}
+
+void stats_section::merge(const stats_section &other) {
+	rows += other.rows;
+	columns += other.columns;
+	nonzeros += other.nonzeros;
+	objectives += other.objectives;
+	obj_nonzeros += other.obj_nonzeros;
+	if(other.min_coeff < min_coeff) min_coeff = other.min_coeff;
+	if(other.max_coeff > max_coeff) max_coeff = other.max_coeff;
+	if(other.min_rhs < min_rhs) min_rhs = other.min_rhs;
+	if(other.max_rhs > max_rhs) max_rhs = other.max_rhs;
+	time += other.time;
+}
+
+//----------------------------------------------------------------------------------------------------
+// Model statistics
+//----------------------------------------------------------------------------------------------------
+
+model_stats::model_stats() : allocated(0), row_nonzeros(0), row_min(DBL_MAX), row_max(0) {
+	sections.push_back(stats_section("model", -1));
+	stack.push_back(0);
+	start = wall_clock();
+}
+
+int model_stats::child(int parent, const char *name) {
+	vector<int> &children = sections[parent].children;
+	for (size_t i = 0; i < children.size(); ++i) {
+		if(sections[children[i]].name == name) return children[i];
+	}
+	int idx = sections.size();
+	sections.push_back(stats_section(name, parent));
+	sections[parent].children.push_back(idx);
+	return idx;
+}
+
+void model_stats::elapse() {
+	double now = wall_clock();
+	sections[stack.back()].time += now - start;
+	start = now;
+}
+
+void model_stats::push(const char *name) {
+	elapse();
+	stack.push_back(child(stack.back(), name));
+}
+
+void model_stats::pop() {
+	elapse();
+	if(stack.size() > 1) stack.pop_back();
+}
+
+void model_stats::add_columns(const char *name, long long count) {
+	sections[child(stack.back(), name)].columns += count;
+}
+
+void model_stats::add_columns(long long allocated_before, long long first, long long last) {
+	long long count = (last - first) - (allocated - allocated_before);
+	sections[stack.back()].columns += count;
+	allocated += count;
+}
+
+void model_stats::new_row() {
+	row_nonzeros = 0;
+	row_min = DBL_MAX;
+	row_max = 0;
+}
+
+void model_stats::set_row_coeff(CUDFcoefficient previous, CUDFcoefficient value) {
+	if(value != 0) {
+		if(previous == 0) row_nonzeros++;
+		merge_range(row_min, row_max, CUDFabs(value));
+	} else if(previous != 0) row_nonzeros--;
+}
+
+void model_stats::add_row(CUDFcoefficient rhs) {
+	if(row_nonzeros > 0) {
+		stats_section &section = sections[stack.back()];
+		section.rows++;
+		section.nonzeros += row_nonzeros;
+		merge_range(section.min_coeff, section.max_coeff, row_min);
+		merge_range(section.min_coeff, section.max_coeff, row_max);
+		if(rhs != 0) merge_range(section.min_rhs, section.max_rhs, CUDFabs(rhs));
+	}
+	new_row();
+}
+
+void model_stats::set_obj_coeff(CUDFcoefficient previous, CUDFcoefficient value) {
+	stats_section &section = sections[stack.back()];
+	if(value != 0) {
+		if(previous == 0) section.obj_nonzeros++;
+		merge_range(section.min_coeff, section.max_coeff, CUDFabs(value));
+	} else if(previous != 0) section.obj_nonzeros--;
+}
+
+void model_stats::add_objective() {
+	sections[stack.back()].objectives++;
+}
+
+// statistics of a section and its sub-sections
+stats_section model_stats::total(int idx) {
+	stats_section sum = sections[idx];
+	for (size_t i = 0; i < sections[idx].children.size(); ++i) {
+		sum.merge(total(sections[idx].children[i]));
+	}
+	return sum;
+}
+
+void model_stats::print(ostream &out) {
+	trace_span span("model statistics", "writer");
+	elapse();
+	out << "c MODEL STATISTICS" << endl;
+	out << "c " << setw(32) << left << "SECTION" << right
+			<< setw(10) << "ROWS" << setw(10) << "COLUMNS" << setw(12) << "NONZEROS"
+			<< setw(6) << "OBJS" << setw(10) << "OBJNZ"
+			<< setw(20) << "|COEFF|" << setw(20) << "|RHS|" << setw(10) << "TIME" << endl;
+	print(out, 0, 0);
+}
+
+void model_stats::print(ostream &out, int idx, int depth) {
+	stats_section s = total(idx);
+	ostringstream coeff, rhs;
+	if(s.max_coeff > 0) coeff << "[" << s.min_coeff << "," << s.max_coeff << "]";
+	else coeff << "-";
+	if(s.max_rhs > 0) rhs << "[" << s.min_rhs << "," << s.max_rhs << "]";
+	else rhs << "-";
+	out << "c " << setw(32) << left << (string(2 * depth, ' ') + s.name) << right
+			<< setw(10) << s.rows << setw(10) << s.columns << setw(12) << s.nonzeros
+			<< setw(6) << s.objectives << setw(10) << s.obj_nonzeros
+			<< setw(20) << coeff.str() << setw(20) << rhs.str()
+			<< setw(10) << fixed << setprecision(3) << s.time << endl;
+	out.unsetf(ios_base::floatfield);
+	out << setprecision(6);
+	for (size_t i = 0; i < sections[idx].children.size(); ++i) {
+		print(out, sections[idx].children[i], depth + 1);
+	}
+}
+
+void model_stats::print_json(ostream &out) {
+	trace_span span("model statistics (json)", "writer");
+	elapse();
+	print_json(out, 0, 0);
+	out << endl;
+}
+
+void model_stats::print_json(ostream &out, int idx, int depth) {
+	stats_section s = total(idx);
+	string indent(2 * depth, ' ');
+	out << indent << "{\"name\": " << json_string(s.name)
+			<< ", \"rows\": " << s.rows
+			<< ", \"columns\": " << s.columns
+			<< ", \"nonzeros\": " << s.nonzeros
+			<< ", \"objectives\": " << s.objectives
+			<< ", \"obj_nonzeros\": " << s.obj_nonzeros;
+	if(s.max_coeff > 0) out << ", \"coeff_range\": [" << s.min_coeff << ", " << s.max_coeff << "]";
+	if(s.max_rhs > 0) out << ", \"rhs_range\": [" << s.min_rhs << ", " << s.max_rhs << "]";
+	out << ", \"time\": " << s.time;
+	const vector<int> &children = sections[idx].children;
+	if(! children.empty()) {
+		out << ",\n" << indent << " \"sections\": [\n";
+		for (size_t i = 0; i < children.size(); ++i) {
+			if(i > 0) out << ",\n";
+			print_json(out, children[i], depth + 1);
+		}
+		out << "]";
+	}
+	out << "}";
+}
+
+//----------------------------------------------------------------------------------------------------
+// Solver proxy
+//----------------------------------------------------------------------------------------------------
+
+int stats_solver::init_solver(PSLProblem *problem, int other_vars) {
+	if(model_statistics) {
+		// each block of variables is assigned to the family which defines it
+		long long nodes = problem->nodeCount(), stages = problem->stageCount();
+		model_statistics->add_columns(FAMILY_SERVER_COUNT, nodes * (1 + problem->serverTypeCount()));
+		model_statistics->add_columns(FAMILY_CAPACITY, nodes * stages);
+		model_statistics->add_columns(FAMILY_LOCAL, nodes * stages);
+		model_statistics->add_columns(FAMILY_FLOW, (long long) problem->linkCount() * stages);
+		// the connections of the paths are counted by the links, their bandwidths are bounded by the links and the paths
+		model_statistics->add_columns(FAMILY_LINK_BANDWIDTH, 0);
+		model_statistics->add_columns(FAMILY_LINK_CONNECTIONS, (long long) problem->pathCount() * stages);
+		model_statistics->add_columns(FAMILY_PATH_BANDWIDTH, (long long) problem->pathCount() * stages);
+		model_statistics->add_columns(FAMILY_SYMMETRY, 0);
+	}
+	return solver->init_solver(problem, other_vars);
+}
+
+int stats_solver::set_obj_coeff(int rank, CUDFcoefficient value) {
+	if(model_statistics) model_statistics->set_obj_coeff(solver->get_obj_coeff(rank), value);
+	return solver->set_obj_coeff(rank, value);
+}
+
+int stats_solver::add_objective(void) {
+	if(model_statistics) model_statistics->add_objective();
+	return solver->add_objective();
+}
+
+int stats_solver::new_constraint(void) {
+	if(model_statistics) model_statistics->new_row();
+	return solver->new_constraint();
+}
+
+int stats_solver::set_constraint_coeff(int rank, CUDFcoefficient value) {
+	if(model_statistics) model_statistics->set_row_coeff(solver->get_constraint_coeff(rank), value);
+	return solver->set_constraint_coeff(rank, value);
+}
+
+int stats_solver::add_constraint_geq(CUDFcoefficient bound) {
+	if(model_statistics) model_statistics->add_row(bound);
+	return solver->add_constraint_geq(bound);
+}
+
+int stats_solver::add_constraint_leq(CUDFcoefficient bound) {
+	if(model_statistics) model_statistics->add_row(bound);
+	return solver->add_constraint_leq(bound);
+}
+
+int stats_solver::add_constraint_eq(CUDFcoefficient bound) {
+	if(model_statistics) model_statistics->add_row(bound);
+	return solver->add_constraint_eq(bound);
+}
+
+//----------------------------------------------------------------------------------------------------
+// Criteria and combiner probes
+//----------------------------------------------------------------------------------------------------
+
+Rank criteria_probe::set_variable_range(Rank first_free_var) {
+	stats_scope scope(name.c_str());
+	long long before = model_statistics ? model_statistics->allocated : 0;
+	Rank last = criteria->set_variable_range(first_free_var);
+	if(model_statistics) model_statistics->add_columns(before, first_free_var, last);
+	return last;
+}
+
+int criteria_probe::add_criteria_to_objective(CUDFcoefficient lambda) {
+	stats_scope scope(name.c_str());
+	trace_span span(name + " add_criteria_to_objective", "criteria");
+	return criteria->add_criteria_to_objective(lambda);
+}
+
+int criteria_probe::add_criteria_to_constraint(CUDFcoefficient lambda) {
+	stats_scope scope(name.c_str());
+	trace_span span(name + " add_criteria_to_constraint", "criteria");
+	return criteria->add_criteria_to_constraint(lambda);
+}
+
+int criteria_probe::add_constraints() {
+	stats_scope scope(name.c_str());
+	trace_span span(name + " add_constraints", "criteria");
+	return criteria->add_constraints();
+}
+
+void criteria_probe::initialize_intvars() {
+	stats_scope scope(name.c_str());
+	criteria->initialize_intvars();
+}
+
+Rank combiner_probe::column_allocation(Rank first_rank) {
+	stats_scope scope(name.c_str());
+	long long before = model_statistics ? model_statistics->allocated : 0;
+	Rank last = combiner->column_allocation(first_rank);
+	if(model_statistics) model_statistics->add_columns(before, first_rank, last);
+	return last;
+}
+
+int combiner_probe::objective_generation() {
+	stats_scope scope(name.c_str());
+	trace_span span(name + " objective_generation", "combiner");
+	return combiner->objective_generation();
+}
+
+int combiner_probe::constraint_generation() {
+	stats_scope scope(name.c_str());
+	trace_span span(name + " constraint_generation", "combiner");
+	return combiner->constraint_generation();
+}
@@ -0,0 +1,170 @@
+/*******************************************************/
+/* oPoSSuM solver: model_stats.h                       */
+/* Statistics of the generated MILP model              */
+/* (c) Arnaud Malapert I3S (UNS-CNRS) 2012             */
+/*******************************************************/
+
+// The model is divided into sections: the constraint families of generate_constraints
+// and the criteria and combiners of the objective tree.
+// Rows, columns, nonzeros, coefficient ranges and emission time are gathered by section.
+
+#ifndef _MODEL_STATS_H
+#define _MODEL_STATS_H
+
+#include <proxy_solver.h>
+#include <abstract_combiner.h>
+
+// Constraint families (see generate_constraints)
+#define FAMILY_SERVER_COUNT "server count"
+#define FAMILY_CAPACITY "capacity"
+#define FAMILY_LOCAL "local connections"
+#define FAMILY_FLOW "flow conservation"
+#define FAMILY_LINK_BANDWIDTH "link bandwidth"
+#define FAMILY_LINK_CONNECTIONS "link connections"
+#define FAMILY_PATH_BANDWIDTH "path bandwidth"
+#define FAMILY_SYMMETRY "symmetry breaking"
+
+// Statistics of a section (own values, i.e. sub-sections excluded)
+class stats_section {
+public:
+	string name;
+	int parent;                  // index of the parent section (-1 for the whole model)
+	vector<int> children;        // indices of the sub-sections in creation order
+	long long rows;              // number of (non empty) rows
+	long long columns;           // number of columns
+	long long nonzeros;          // number of nonzero constraint coefficients
+	long long objectives;        // number of objective functions
+	long long obj_nonzeros;      // number of nonzero objective coefficients
+	double min_coeff, max_coeff; // range of the absolute values of nonzero coefficients
+	double min_rhs, max_rhs;     // range of the absolute values of nonzero right hand sides
+	double time;                 // emission time in seconds
+
+	stats_section(string name, int parent);
+	// add the values of another section (coefficient ranges are merged)
+	void merge(const stats_section &other);
+};
+
+class model_stats {
+public:
+	vector<stats_section> sections;   // sections[0] is the whole model
+
+	// enter a sub-section of the current section (created if needed)
+	void push(const char *name);
+	// leave the current section
+	void pop();
+
+	// add columns to a sub-section of the current section
+	void add_columns(const char *name, long long count);
+	// columns allocated by the current section in [first, last[
+	// (columns allocated by its sub-sections since 'allocated_before' are not counted twice)
+	void add_columns(long long allocated_before, long long first, long long last);
+	// number of columns allocated by sections so far
+	long long allocated;
+
+	// row under construction
+	void new_row();
+	void set_row_coeff(CUDFcoefficient previous, CUDFcoefficient value);
+	void add_row(CUDFcoefficient rhs);
+
+	// objective under construction
+	void set_obj_coeff(CUDFcoefficient previous, CUDFcoefficient value);
+	void add_objective();
+
+	// Print out the statistics (comment lines)
+	void print(ostream &out);
+	// Print out the statistics as a JSON object
+	void print_json(ostream &out);
+
+	model_stats();
+
+private:
+	vector<int> stack;          // current section is stack.back()
+	double start;               // start time of the current section
+	long long row_nonzeros;     // row under construction
+	double row_min, row_max;
+
+	int child(int parent, const char *name);
+	void elapse();
+	stats_section total(int idx);
+	void print(ostream &out, int idx, int depth);
+	void print_json(ostream &out, int idx, int depth);
+};
+
+// statistics of the current model (NULL if not requested)
+extern model_stats *model_statistics;
+
+// Open a section for the lifetime of the object (if statistics are requested)
+class stats_scope {
+public:
+	// leave the current section of the scope (if any) and enter another one
+	void enter(const char *name) {
+		if (model_statistics) {
+			if(opened) model_statistics->pop();
+			model_statistics->push(name);
+			opened = true;
+		}
+	}
+	stats_scope() : opened(false) {}
+	stats_scope(const char *name) : opened(false) { enter(name); }
+	~stats_scope() { if (model_statistics && opened) model_statistics->pop(); }
+private:
+	bool opened;
+};
+
+// Solver proxy which records the rows and objectives of the model
+class stats_solver: public proxy_solver {
+public:
+	int init_solver(PSLProblem *problem, int other_vars);
+
+	int set_obj_coeff(int rank, CUDFcoefficient value);
+	int add_objective(void);
+
+	int new_constraint(void);
+	int set_constraint_coeff(int rank, CUDFcoefficient value);
+	int add_constraint_geq(CUDFcoefficient bound);
+	int add_constraint_leq(CUDFcoefficient bound);
+	int add_constraint_eq(CUDFcoefficient bound);
+
+	stats_solver(abstract_solver *solver) : proxy_solver(solver) {}
+};
+
+// Criteria proxy which opens a section for each call
+class criteria_probe: public abstract_criteria {
+public:
+	abstract_criteria *criteria;   // observed criteria
+	string name;
+
+	Rank set_variable_range(Rank first_free_var);
+	int add_criteria_to_objective(CUDFcoefficient lambda);
+	int add_criteria_to_constraint(CUDFcoefficient lambda);
+	int add_constraints();
+
+	CUDFcoefficient bound_range() { return criteria->bound_range(); }
+	CUDFcoefficient upper_bound() { return criteria->upper_bound(); }
+	CUDFcoefficient lower_bound() { return criteria->lower_bound(); }
+
+	void initialize(PSLProblem *problem, abstract_solver *solver) { criteria->initialize(problem, solver); }
+	void initialize_intvars();
+	void check_property(PSLProblem *problem) { criteria->check_property(problem); }
+
+	criteria_probe(abstract_criteria *criteria, string name) : criteria(criteria), name(name) {}
+	virtual ~criteria_probe() { delete criteria; }
+};
+
+// Combiner proxy which opens a section for each call
+class combiner_probe: public abstract_combiner {
+public:
+	abstract_combiner *combiner;   // observed combiner
+	string name;
+
+	Rank column_allocation(Rank first_rank);
+	int objective_generation();
+	int constraint_generation();
+
+	void initialize(PSLProblem *problem, abstract_solver *solver) { combiner->initialize(problem, solver); }
+
+	combiner_probe(abstract_combiner *combiner, string name) : combiner(combiner), name(name) {}
+	virtual ~combiner_probe() { delete combiner; }
+};
+
+#endif
@@ -0,0 +1,408 @@
+/*******************************************************/
+/* oPoSSuM solver: model_writer.c                      */
+/* Output of the model in the LP and MPS formats       */
+/* (c) Arnaud Malapert I3S (UNS-CNRS) 2012             */
+/*******************************************************/
+
+#include <model_writer.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#ifdef USEZLIB
+#include <zlib.h>
+#endif
+
+#define TERMS_PER_LINE 10 // some readers do not like too long lines
+
+static bool has_suffix(const char *name, size_t length, const char *suffix) {
+	size_t n = strlen(suffix);
+	return length >= n && strncmp(name + length - n, suffix, n) == 0;
+}
+
+//----------------------------------------------------------------------------------------------------
+// Sink
+//----------------------------------------------------------------------------------------------------
+
+model_sink::model_sink() : pos(0), fd(-1), gz(NULL), failed(false) {
+	if ((buffer = (char *)malloc(SINK_BUFFER_SIZE)) == (char *)NULL) {
+		fprintf(stderr, "model_sink: not enough memory.\n");
+		exit(-1);
+	}
+}
+
+model_sink::~model_sink() {
+	close();
+	free(buffer);
+}
+
+bool model_sink::open(const char *filename) {
+	close();
+	failed = false;
+	if (has_suffix(filename, strlen(filename), ".gz")) {
+#ifdef USEZLIB
+		// fast compression: the output is dominated by the formatting otherwise
+		gz = gzopen(filename, "wb1");
+		if (gz != NULL) gzbuffer((gzFile) gz, SINK_BUFFER_SIZE);
+		return gz != NULL;
+#else
+		fprintf(stderr, "model_sink: %s: compiled without zlib.\n", filename);
+		return false;
+#endif
+	}
+	fd = ::open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	return fd != -1;
+}
+
+void model_sink::open(int fd) {
+	close();
+	failed = false;
+	this->fd = fd;
+}
+
+void model_sink::put(const char *s, size_t length) {
+	while (length > 0) {
+		if (pos == SINK_BUFFER_SIZE) flush();
+		size_t n = SINK_BUFFER_SIZE - pos < length ? SINK_BUFFER_SIZE - pos : length;
+		memcpy(buffer + pos, s, n);
+		pos += n;
+		s += n;
+		length -= n;
+	}
+}
+
+void model_sink::put_int(long long value, bool plus) {
+	// 20 digits and a sign at most
+	if (pos + 21 > SINK_BUFFER_SIZE) flush();
+	unsigned long long u = value < 0 ? - (unsigned long long) value : value;
+	if (value < 0) buffer[pos++] = '-';
+	else if (plus) buffer[pos++] = '+';
+	char digits[20];
+	int n = 0;
+	do {
+		digits[n++] = '0' + u % 10;
+		u /= 10;
+	} while (u > 0);
+	while (n > 0) buffer[pos++] = digits[--n];
+}
+
+void model_sink::flush() {
+	size_t done = 0;
+#ifdef USEZLIB
+	if (gz != NULL) {
+		if (pos > 0 && gzwrite((gzFile) gz, buffer, pos) != (int) pos) failed = true;
+		pos = 0;
+		return;
+	}
+#endif
+	while (fd != -1 && done < pos) {
+		ssize_t n = write(fd, buffer + done, pos - done);
+		if (n == -1 && errno == EINTR) continue;
+		if (n <= 0) {
+			failed = true;
+			break;
+		}
+		done += n;
+	}
+	pos = 0;
+}
+
+bool model_sink::close() {
+	flush();
+#ifdef USEZLIB
+	if (gz != NULL && gzclose((gzFile) gz) != Z_OK) failed = true;
+#endif
+	if (fd != -1 && ::close(fd) == -1) failed = true;
+	gz = NULL;
+	fd = -1;
+	return ! failed;
+}
+
+//----------------------------------------------------------------------------------------------------
+// Column names
+//----------------------------------------------------------------------------------------------------
+
+// The names are generated once and stored in a single pool
+class name_pool {
+public:
+	vector<char> pool;
+	vector<size_t> start;
+
+	inline void put(model_sink &out, int rank) const { out.put(&pool[start[rank]], start[rank + 1] - start[rank]); }
+
+	name_pool(const milp_model &model) {
+		start.reserve(model.nb_vars + 1);
+		for (int k = 0; k < model.nb_vars; k++) {
+			start.push_back(pool.size());
+			string name = model.column_name(k);
+			pool.insert(pool.end(), name.begin(), name.end());
+		}
+		start.push_back(pool.size());
+	}
+};
+
+// the non empty objectives in the lexicographic order (the given one if it is not negative)
+static vector<int> written_objectives(const milp_model &model, int objective) {
+	vector<int> objectives;
+	if (objective >= 0) objectives.push_back(objective);
+	for (int i = 0; objective < 0 && i < model.objectiveCount(); i++) {
+		if (model.obj_start[i + 1] > model.obj_start[i]) objectives.push_back(i);
+	}
+	return objectives;
+}
+
+static void put_row_name(model_sink &out, int row) {
+	out.put('c');
+	out.put_int(row);
+}
+
+//----------------------------------------------------------------------------------------------------
+// LP format
+//----------------------------------------------------------------------------------------------------
+
+static void put_terms(model_sink &out, const name_pool &names, long long first, long long last,
+		const vector<int> &index, const vector<CUDFcoefficient> &coeff) {
+	for (long long k = first; k < last; k++) {
+		if (k > first && (k - first) % TERMS_PER_LINE == 0) out.put("\n  ", 3);
+		out.put(' ');
+		out.put_int(coeff[k], true);
+		out.put(' ');
+		names.put(out, index[k]);
+	}
+}
+
+void write_lp(const milp_model &model, model_sink &out, int objective) {
+	name_pool names(model);
+	vector<int> objectives = written_objectives(model, objective);
+
+	out.put("\\ oPoSSuM model: ");
+	out.put_int(model.rowCount());
+	out.put(" rows, ");
+	out.put_int(model.nb_vars);
+	out.put(" columns, ");
+	out.put_int(model.nonzeroCount());
+	out.put(" nonzeros\n");
+	if (objectives.size() > 1) {
+		// the levels are optimized in turn without any degradation (CPLEX multi-objective section)
+		out.put("Minimize multi-objectives\n");
+		for (size_t i = 0; i < objectives.size(); i++) {
+			out.put(" obj");
+			out.put_int(objectives[i]);
+			out.put(": Priority=");
+			out.put_int(objectives.size() - i);
+			out.put(" Weight=1 AbsTol=0 RelTol=0\n ");
+			put_terms(out, names, model.obj_start[objectives[i]], model.obj_start[objectives[i] + 1], model.obj_index, model.obj_coeff);
+			out.put('\n');
+		}
+	} else {
+		out.put("Minimize\n obj:");
+		if (! objectives.empty() && model.obj_start[objectives[0] + 1] > model.obj_start[objectives[0]])
+			put_terms(out, names, model.obj_start[objectives[0]], model.obj_start[objectives[0] + 1], model.obj_index, model.obj_coeff);
+		else if (model.nb_vars > 0) {
+			out.put(" 0 ");
+			names.put(out, 0);
+		}
+	}
+
+	out.put(objectives.size() > 1 ? "Subject To\n" : "\nSubject To\n");
+	for (int i = 0; i < model.rowCount(); i++) {
+		out.put(' ');
+		put_row_name(out, i);
+		out.put(':');
+		put_terms(out, names, model.row_start[i], model.row_start[i + 1], model.row_index, model.row_coeff);
+		switch (model.row_sense[i]) {
+		case 'G': out.put(" >= ", 4); break;
+		case 'L': out.put(" <= ", 4); break;
+		default: out.put(" = ", 3); break;
+		}
+		out.put_int(model.rhs[i]);
+		out.put('\n');
+	}
+
+	out.put("Bounds\n");
+	for (int k = 0; k < model.nb_vars; k++) {
+		if (model.vartype[k] == 'B') continue;
+		if (model.ub[k] == MODEL_INFINITY) {
+			if (model.lb[k] == 0) continue;
+			out.put(' ');
+			names.put(out, k);
+			out.put(" >= ", 4);
+			out.put_int(model.lb[k]);
+		} else {
+			out.put(' ');
+			out.put_int(model.lb[k]);
+			out.put(" <= ", 4);
+			names.put(out, k);
+			out.put(" <= ", 4);
+			out.put_int(model.ub[k]);
+		}
+		out.put('\n');
+	}
+
+	const char *sections[2] = {"Binaries", "Generals"};
+	const char types[2] = {'B', 'I'};
+	for (int s = 0; s < 2; s++) {
+		int nbcols = 0;
+		for (int k = 0; k < model.nb_vars; k++) {
+			if (model.vartype[k] != types[s]) continue;
+			if (nbcols == 0) {
+				out.put(sections[s]);
+				out.put('\n');
+			} else if (nbcols % TERMS_PER_LINE == 0) out.put('\n');
+			out.put(' ');
+			names.put(out, k);
+			nbcols++;
+		}
+		if (nbcols > 0) out.put('\n');
+	}
+	out.put("End\n");
+}
+
+//----------------------------------------------------------------------------------------------------
+// Free MPS format
+//----------------------------------------------------------------------------------------------------
+
+void write_mps(const milp_model &model, model_sink &out, int objective) {
+	name_pool names(model);
+	vector<int> objectives = written_objectives(model, objective);
+
+	// Transpose the rows (the objective of the level i is the row -1 - i)
+	vector<long long> col_start(model.nb_vars + 1, 0);
+	for (long long k = 0; k < model.nonzeroCount(); k++) col_start[model.row_index[k] + 1]++;
+	for (size_t i = 0; i < objectives.size(); i++) {
+		for (long long k = model.obj_start[objectives[i]]; k < model.obj_start[objectives[i] + 1]; k++) col_start[model.obj_index[k] + 1]++;
+	}
+	for (int k = 0; k < model.nb_vars; k++) col_start[k + 1] += col_start[k];
+	vector<long long> next(col_start.begin(), col_start.end() - 1);
+	vector<int> col_row(col_start.back());
+	vector<CUDFcoefficient> col_coeff(col_start.back());
+	for (size_t i = 0; i < objectives.size(); i++) {
+		for (long long k = model.obj_start[objectives[i]]; k < model.obj_start[objectives[i] + 1]; k++) {
+			long long p = next[model.obj_index[k]]++;
+			col_row[p] = -1 - (int) i;
+			col_coeff[p] = model.obj_coeff[k];
+		}
+	}
+	for (int i = 0; i < model.rowCount(); i++) {
+		for (long long k = model.row_start[i]; k < model.row_start[i + 1]; k++) {
+			long long p = next[model.row_index[k]]++;
+			col_row[p] = i;
+			col_coeff[p] = model.row_coeff[k];
+		}
+	}
+
+	// the first free row is the objective, the next ones are the following levels
+	out.put("NAME opossum\nROWS\n N obj\n");
+	for (size_t i = 1; i < objectives.size(); i++) {
+		out.put(" N obj");
+		out.put_int(objectives[i]);
+		out.put('\n');
+	}
+	for (int i = 0; i < model.rowCount(); i++) {
+		out.put(' ');
+		out.put(model.row_sense[i]);
+		out.put(' ');
+		put_row_name(out, i);
+		out.put('\n');
+	}
+
+	out.put("COLUMNS\n");
+	bool integer = false;
+	for (int k = 0; k < model.nb_vars; k++) {
+		if ((model.vartype[k] != 'C') != integer) {
+			integer = ! integer;
+			out.put(integer ? " MARKER 'MARKER' 'INTORG'\n" : " MARKER 'MARKER' 'INTEND'\n");
+		}
+		if (col_start[k] == col_start[k + 1]) {
+			// a column must appear to be defined
+			out.put(' ');
+			names.put(out, k);
+			out.put(" obj 0\n");
+		}
+		for (long long p = col_start[k]; p < col_start[k + 1]; p++) {
+			out.put(' ');
+			names.put(out, k);
+			out.put(' ');
+			if (col_row[p] == -1) out.put("obj", 3);
+			else if (col_row[p] < 0) {
+				out.put("obj", 3);
+				out.put_int(objectives[-1 - col_row[p]]);
+			} else put_row_name(out, col_row[p]);
+			out.put(' ');
+			out.put_int(col_coeff[p]);
+			out.put('\n');
+		}
+	}
+	if (integer) out.put(" MARKER 'MARKER' 'INTEND'\n");
+
+	out.put("RHS\n");
+	for (int i = 0; i < model.rowCount(); i++) {
+		if (model.rhs[i] == 0) continue;
+		out.put(" RHS ", 5);
+		put_row_name(out, i);
+		out.put(' ');
+		out.put_int(model.rhs[i]);
+		out.put('\n');
+	}
+
+	// the integer columns without upper bound must be explicit (binary by default for some readers)
+	out.put("BOUNDS\n");
+	for (int k = 0; k < model.nb_vars; k++) {
+		if (model.vartype[k] == 'B') {
+			out.put(" BV BND ", 8);
+			names.put(out, k);
+			out.put('\n');
+			continue;
+		}
+		if (model.lb[k] != 0) {
+			out.put(" LO BND ", 8);
+			names.put(out, k);
+			out.put(' ');
+			out.put_int(model.lb[k]);
+			out.put('\n');
+		}
+		if (model.ub[k] == MODEL_INFINITY) {
+			if (model.vartype[k] == 'C') continue;
+			out.put(" PL BND ", 8);
+			names.put(out, k);
+		} else {
+			out.put(" UP BND ", 8);
+			names.put(out, k);
+			out.put(' ');
+			out.put_int(model.ub[k]);
+		}
+		out.put('\n');
+	}
+	out.put("ENDATA\n");
+}
+
+//----------------------------------------------------------------------------------------------------
+// Files
+//----------------------------------------------------------------------------------------------------
+
+int write_model(const milp_model &model, const char *filename) {
+	trace_span span(filename, "writer");
+	size_t length = strlen(filename);
+	if (has_suffix(filename, length, ".gz")) length -= 3;
+	bool mps = has_suffix(filename, length, ".mps");
+	if (! mps && ! has_suffix(filename, length, ".lp")) {
+		fprintf(stderr, "write_model: unknown format for %s (.lp or .mps expected).\n", filename);
+		return -1;
+	}
+
+	model_sink out;
+	if (! out.open(filename)) {
+		fprintf(stderr, "write_model: cannot open %s.\n", filename);
+		return -1;
+	}
+	if (mps) {
+		write_mps(model, out);
+		if (written_objectives(model, -1).size() > 1) {
+			fprintf(stderr, "WARNING: the MPS format only optimizes the first objective level of %s (the next levels are free rows, use the LP format).\n", filename);
+		}
+	} else write_lp(model, out);
+	if (! out.close()) {
+		fprintf(stderr, "write_model: error while writing %s.\n", filename);
+		return -1;
+	}
+	return 0;
+}
@@ -0,0 +1,65 @@
+/*******************************************************/
+/* oPoSSuM solver: model_writer.h                      */
+/* Output of the model in the LP and MPS formats       */
+/* (c) Arnaud Malapert I3S (UNS-CNRS) 2012             */
+/*******************************************************/
+
+// The model is read from its in-memory copy (see milp_model) and formatted by hand into a large buffer.
+// Files whose name ends with .gz are compressed on the fly (requires zlib, see USEZLIB).
+
+#ifndef _MODEL_WRITER_H
+#define _MODEL_WRITER_H
+
+#include <milp_model.h>
+#include <run_report.h>
+
+#define SINK_BUFFER_SIZE (1 << 20)
+
+// Buffered output into a file descriptor or a gzip stream
+class model_sink {
+public:
+	// open a file (compressed if its name ends with .gz), return false on failure
+	bool open(const char *filename);
+	// write into an open file descriptor (which is closed by close)
+	void open(int fd);
+	// flush and close the output, return false if an error occurred
+	bool close();
+
+	inline void put(char c) {
+		if (pos == SINK_BUFFER_SIZE) flush();
+		buffer[pos++] = c;
+	}
+	void put(const char *s, size_t length);
+	inline void put(const char *s) { put(s, strlen(s)); }
+	inline void put(const string &s) { put(s.data(), s.size()); }
+	// write an integer (with its sign if plus is true)
+	void put_int(long long value, bool plus = false);
+
+	// write the buffer
+	void flush();
+	// has no error occurred so far ?
+	bool good() const { return ! failed; }
+
+	model_sink();
+	~model_sink();
+
+private:
+	char *buffer;
+	size_t pos;
+	int fd;
+	void *gz;     // gzip stream (gzFile)
+	bool failed;
+};
+
+// Write the model in the CPLEX LP format with an objective
+// (if negative, all the non empty levels: a multi-objective section if there are several ones)
+void write_lp(const milp_model &model, model_sink &out, int objective = -1);
+// Write the model in the free MPS format with an objective
+// (if negative, all the non empty levels: the first one is the objective, the next ones are free rows)
+void write_mps(const milp_model &model, model_sink &out, int objective = -1);
+
+// Write the model into a file whose format is given by its extension: .lp or .mps, optionally followed by .gz
+// return 0 on success
+int write_model(const milp_model &model, const char *filename);
+
+#endif
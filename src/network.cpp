@@ -5,6 +5,8 @@
 /*******************************************************/
 
 #include "network.hpp"
+#include <map>
+#include <sstream>
 
 
 bool showID = false;
@@ -152,6 +154,18 @@ uniform_01<mt19937&, double> FacilityType::randd(default_random_generator);
 variate_generator<mt19937&, binomial_distribution<> > FacilityType::fake_binornd(default_random_generator, binomial_distribution<>(1,1));
 
 
+FacilityType::FacilityType(const FacilityType& type, unsigned int multiplicity) :
+		level(type.level), groupWeights(type.groupWeights), bandwidthProbabilities(type.bandwidthProbabilities),
+		reliabilityProbability(type.reliabilityProbability), binornd(NULL) {
+	binornd = new variate_generator<mt19937&, binomial_distribution<> >(fake_binornd);
+	for (size_t i = 0; i < type.demands.size(); ++i) {
+		demands.push_back(type.demands[i] * multiplicity);
+	}
+	for (size_t i = 0; i < type.serverCapacities.size(); ++i) {
+		serverCapacities.push_back(type.serverCapacities[i] * multiplicity);
+	}
+}
+
 //Set a new seed for random generators
 void FacilityType::setStaticSeed(const unsigned int seed) {
 	default_random_generator.seed(seed);
@@ -246,6 +260,7 @@ FacilityNode* PSLProblem::generateNetwork(bool hierarchic) {
 	levelNodeCounts.push_back(1);
 	queue<FacilityNode*> queue;
 	root = new FacilityNode(_nodeCount++, facilities[0]);
+	nodes.push_back(root);
 	queue.push(root);
 	unsigned int ftype = 1, clevel = 0, idx = 0;
 	FacilityNode* current = queue.front();
@@ -262,6 +277,7 @@ FacilityNode* PSLProblem::generateNetwork(bool hierarchic) {
 						facilities[idx]);
 				new NetworkLink(_nodeCount - 1, current, child, *this,
 						hierarchic);
+				nodes.push_back(child);
 				queue.push(child);
 				_nodeCount++;
 			}
@@ -284,17 +300,281 @@ FacilityNode* PSLProblem::generateNetwork(bool hierarchic) {
 	while (!queue.empty()) {
 		queue.pop();
 	}
+	initRanks();
+	assert(checkNetwork() && ( !hierarchic || checkNetworkHierarchy() ));
+	return root;
+}
+
+void PSLProblem::initRanks() {
 	//Initialize Rank Mapper Arrays
+	levelCumulNodeCounts.clear();
+	lengthCumulPathCounts.clear();
 	levelCumulNodeCounts.push_back(0);
 	lengthCumulPathCounts.push_back(0);
 	for (unsigned int l = 0; l < levelNodeCounts.size(); ++l) {
 		levelCumulNodeCounts.push_back( levelCumulNodeCounts.back() + levelNodeCounts[l]);
 		lengthCumulPathCounts.push_back( lengthCumulPathCounts.back() + _nodeCount - levelCumulNodeCounts.back());
 	}
-	assert(checkNetwork() && ( !hierarchic || checkNetworkHierarchy() ));
-	return root;
+	if(! checkRanks()) {
+		cerr << "ERROR: the network is too large: " << _nodeCount << " nodes, " << levelCount() << " levels, " << stageCount() << " stages." << endl;
+		exit(1);
+	}
+}
+
+unsigned int PSLProblem::aggregateLeaves() {
+	vector<IntList> represented(_nodeCount);
+	for (unsigned int i = 0; i < _nodeCount; ++i) {
+		represented[i].push_back(i);
+	}
+	//merge the leaves into their first identical sibling
+	for (unsigned int i = 0; i < _nodeCount; ++i) {
+		if(nodes[i] == NULL) continue;
+		LinkList kept;
+		for (LinkListIterator l = nodes[i]->cbegin(); l != nodes[i]->cend(); ++l) {
+			FacilityNode *child = (*l)->getDestination();
+			LinkListIterator twin = kept.begin();
+			while (child->isLeaf() && twin != kept.end() && ! (
+					(*twin)->getDestination()->isLeaf() &&
+					(*twin)->getDestination()->getType() == child->getType() &&
+					(*twin)->getBandwidth() == (*l)->getBandwidth() &&
+					(*twin)->isReliable() == (*l)->isReliable())) {
+				twin++;
+			}
+			if(child->isLeaf() && twin != kept.end()) {
+				represented[(*twin)->getDestination()->getID()].push_back(child->getID());
+				nodes[child->getID()] = NULL;
+				delete child;
+				delete *l;
+			} else {
+				kept.push_back(*l);
+			}
+		}
+		nodes[i]->children = kept;
+	}
+	//the demands, capacities and bandwidth of a group are the ones of its facilities
+	for (unsigned int i = 0; i < _nodeCount; ++i) {
+		unsigned int multiplicity = represented[i].size();
+		if(nodes[i] != NULL && multiplicity > 1) {
+			FacilityType *type = new FacilityType(*nodes[i]->getType(), multiplicity);
+			aggregatedTypes.push_back(type);
+			nodes[i]->type = type;
+			nodes[i]->toFather()->bandwidth *= multiplicity;
+		}
+	}
+	const unsigned int generated = _nodeCount;
+	renumber(represented);
+	//the bandwidth of a group may exceed the bandwidth of its father
+	assert(checkNetwork());
+	return generated - _nodeCount;
+}
+
+unsigned int PSLProblem::mergedLeafCount() const {
+	unsigned int merged = 0;
+	for (unsigned int i = 0; i < _nodeCount; ++i) {
+		merged += getMultiplicity(nodes[i]) - 1;
+	}
+	return merged;
+}
+
+unsigned int PSLProblem::aggregateGroups() {
+	//the stage 0 (initial broadcast) is never merged
+	IntList stages(1, 0), kept, weights;
+	for (unsigned int g = 0; g < _groupCount; ++g) {
+		unsigned int k = 0;
+		bool same = false;
+		while (k < kept.size() && ! same) {
+			same = true;
+			for (FacilityTypeListIterator f = facilities.begin(); same && f != facilities.end(); ++f) {
+				same = (*f)->getDemand(kept[k]) == (*f)->getDemand(g);
+			}
+			if(! same) k++;
+		}
+		if(k == kept.size()) {
+			kept.push_back(g);
+			weights.push_back(0);
+		}
+		weights[k]++;
+		stages.push_back(k + 1);
+	}
+	for (FacilityTypeListIterator f = facilities.begin(); f != facilities.end(); ++f) {
+		CUDFcoefficientList demands;
+		for (unsigned int k = 0; k < kept.size(); ++k) {
+			demands.push_back((*f)->getDemand(kept[k]));
+		}
+		(*f)->demands = demands;
+		(*f)->groupWeights = weights;
+	}
+	const unsigned int generated = _groupCount;
+	_groupCount = kept.size();
+	aggregatedStages = stages;
+	return generated - _groupCount;
+}
+
+IntList PSLProblem::getStageWeights(unsigned int min, unsigned int max) const {
+	IntList weights(stageCount(), 0);
+	for (unsigned int s = min; s <= max && s < originalStageCount(); ++s) {
+		weights[getAggregatedStage(s)]++;
+	}
+	return weights;
+}
+
+unsigned int PSLProblem::contractChains() {
+	vector<IntList> represented(_nodeCount);
+	for (unsigned int i = 0; i < _nodeCount; ++i) {
+		represented[i].push_back(i);
+	}
+	//the nodes of a chain are contracted from top to bottom into the link from the top of the chain
+	for (unsigned int i = 1; i < _nodeCount; ++i) {
+		FacilityNode *node = nodes[i];
+		if(node->getChildrenCount() != 1 || ! node->getType()->isTransit()) continue;
+		NetworkLink *link = node->toFather();
+		NetworkLink *next = node->toChild(0);
+		link->destination = next->getDestination();
+		link->bandwidth = min(link->bandwidth, next->bandwidth);
+		link->reliable = link->reliable && next->reliable;
+		link->destination->father = link;
+		nodes[i] = NULL;
+		node->children.clear();
+		delete node;
+		delete next;
+	}
+	const unsigned int generated = _nodeCount;
+	renumber(represented);
+	assert(checkNetwork());
+	return generated - _nodeCount;
+}
+
+void PSLProblem::renumber(const vector<IntList> &represented) {
+	//the remaining nodes keep their breadth-first order, so that their levels are still increasing
+	vector<IntList> generatedIDs;
+	FacilityList remaining;
+	levelNodeCounts.assign(levelNodeCounts.size(), 0);
+	for (unsigned int i = 0; i < _nodeCount; ++i) {
+		FacilityNode *node = nodes[i];
+		if(node == NULL) continue;
+		node->id = remaining.size();
+		if(! node->isRoot()) node->toFather()->id = node->id - 1;
+		levelNodeCounts[node->getType()->getLevel()]++;
+		IntList ids;
+		for (IntList::const_iterator k = represented[i].begin(); k != represented[i].end(); ++k) {
+			if(originalIDs.empty()) ids.push_back(*k);
+			else ids.insert(ids.end(), originalIDs[*k].begin(), originalIDs[*k].end());
+		}
+		generatedIDs.push_back(ids);
+		remaining.push_back(node);
+	}
+	nodes = remaining;
+	originalIDs = generatedIDs;
+	_nodeCount = nodes.size();
+	initRanks();
+}
+
+vector<FacilityList> PSLProblem::isomorphicSiblings() const {
+	//the code of a subtree identifies it up to a permutation of the children (the children have greater IDs)
+	vector<unsigned int> codes(_nodeCount);
+	map<string, unsigned int> subtrees;
+	for (int i = _nodeCount - 1; i >= 0; --i) {
+		FacilityNode *node = nodes[i];
+		IntList children;
+		for (LinkListIterator l = node->cbegin(); l != node->cend(); ++l) {
+			children.push_back(codes[(*l)->getDestination()->getID()]);
+		}
+		sort(children.begin(), children.end());
+		ostringstream key;
+		key << node->getType();
+		if(! node->isRoot()) {
+			key << " " << node->toFather()->getBandwidth() << " " << node->toFather()->isReliable();
+		}
+		for (IntListIterator c = children.begin(); c != children.end(); ++c) {
+			key << " " << *c;
+		}
+		map<string, unsigned int>::iterator it = subtrees.insert(make_pair(key.str(), subtrees.size())).first;
+		codes[i] = it->second;
+	}
+	vector<FacilityList> groups;
+	for (unsigned int i = 0; i < _nodeCount; ++i) {
+		map<unsigned int, FacilityList> siblings;
+		for (LinkListIterator l = nodes[i]->cbegin(); l != nodes[i]->cend(); ++l) {
+			FacilityNode *child = (*l)->getDestination();
+			siblings[codes[child->getID()]].push_back(child);
+		}
+		for (map<unsigned int, FacilityList>::iterator s = siblings.begin(); s != siblings.end(); ++s) {
+			if(s->second.size() > 1) groups.push_back(s->second);
+		}
+	}
+	return groups;
 }
 
+void PSLProblem::unrank(Rank rank, FacilityNode* &source, FacilityNode* &destination) const {
+	//paths are ranked by length and the index of their destination
+	unsigned int length = 1;
+	while(lengthCumulPathCounts[length] <= rank) {
+		length++;
+	}
+	destination = nodes[rank - lengthCumulPathCounts[length-1] + levelCumulNodeCounts[length]];
+	source = destination;
+	//the levels of the contracted facilities are skipped (see contractChains)
+	while (! source->isRoot() && destination->getType()->getLevel() - source->getType()->getLevel() < length) {
+		source = source->getFather();
+	}
+	//the rank of a path from a contracted facility is unused
+	if(destination->getType()->getLevel() - source->getType()->getLevel() != length) {
+		source = NULL;
+	}
+}
+
+string PSLProblem::rankName(Rank rank) const {
+	ostringstream name;
+	if(rank < endX()) {
+		name << "x" << rank;
+	} else if(rank < endXk()) {
+		rank -= endX();
+		name << "x" << rank / serverTypeCount() << "_" << rank % serverTypeCount();
+	} else if(rank < endYi()) {
+		rank -= endXk();
+		name << "y" << rank / stageCount() << "'" << rank % stageCount();
+	} else if(rank < endZi()) {
+		rank -= endYi();
+		name << "z" << rank / stageCount() << "'" << rank % stageCount();
+	} else if(rank < endYij()) {
+		rank -= endZi();
+		//the destination of the link i is the node i+1
+		FacilityNode* destination = nodes[rank / stageCount() + 1];
+		name << "y" << destination->getFather()->getID() << "_" << destination->getID() << "'" << rank % stageCount();
+	} else if(rank < endBij()) {
+		bool varB = rank >= endZij();
+		rank -= varB ? endZij() : endYij();
+		FacilityNode *source, *destination;
+		unrank(rank / stageCount(), source, destination);
+		if(source == NULL) {
+			name << (varB ? "B" : "Z") << rank / stageCount() << "'" << rank % stageCount();
+		} else {
+			name << (varB ? "b" : "z") << source->getID() << "_" << destination->getID() << "'" << rank % stageCount();
+		}
+	} else {
+		//additional variables
+		name << "X" << rank - endBij();
+	}
+	return name.str();
+}
+
+//a * b + c overflows the 64 bits ranks
+static inline bool rankOverflow(Rank a, Rank b, Rank c) {
+	return b > 0 && (a > (LLONG_MAX - c) / b);
+}
+
+bool PSLProblem::checkRanks() const
+{
+	//node IDs are 32 bits unsigned integers
+	if( _nodeCount != nodes.size()) return false;
+	//the number of paths is lower than nodeCount * levelCount
+	if( rankOverflow(_nodeCount, levelCount(), 0)) return false;
+	//the last rank is lower than nodeCount * (1 + serverTypeCount + 3 * stageCount) + 2 * pathCount * stageCount
+	const Rank nodeRanks = 1 + serverTypeCount() + 3 * (Rank) stageCount();
+	if( rankOverflow(_nodeCount, nodeRanks, 0)) return false;
+	if( rankOverflow(pathCount(), 2 * (Rank) stageCount(), (Rank) _nodeCount * nodeRanks)) return false;
+	return true;
+}
 
 bool PSLProblem::checkNetwork()
 {
@@ -373,6 +653,7 @@ ostream& PSLProblem::toRanks(ostream & out) {
 NetworkLink::NetworkLink(unsigned int id, FacilityNode* father,
 		FacilityNode* child, PSLProblem& problem, bool hierarchic) :
 		id(id), origin(father), destination(child), bandwidth(0), reliable(0) {
+	memory_alloc(MEM_TREE, sizeof(NetworkLink) + sizeof(NetworkLink*)); //the link and its entry in the children list
 	father->children.push_back(this);
 	child->father = this;
 	if (father->isRoot() || !hierarchic) {
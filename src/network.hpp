@@ -8,6 +8,7 @@
 #define NETWORK_HPP_
 
 #include <stdlib.h>
+#include <limits.h>
 #include <iostream>
 #include <fstream>
 #include <iterator>
@@ -24,6 +25,7 @@
 #include <boost/random/binomial_distribution.hpp>
 
 #include "cudf_types.h"
+#include "memory_usage.h"
 
 //Define the seed of random
 #define SEED 1000
@@ -47,6 +49,10 @@ class PSLProblem;
 typedef vector<unsigned int> IntList;
 typedef vector<unsigned int>::iterator IntListIterator;
 
+//Ranks and path counts are computed with 64 bits integers (see PSLProblem::hasCompactRanks)
+typedef long long Rank;
+typedef vector<Rank> RankList;
+
 typedef vector<CUDFcoefficient> CUDFcoefficientList;
 typedef vector<CUDFcoefficient>::iterator CUDFcoefficientListIterator;
 
@@ -110,6 +116,9 @@ public:
 		binornd = new variate_generator<mt19937&, binomial_distribution<> >(fake_binornd);
 	}
 
+	//Type of a group of identical facilities (the demands and capacities are multiplied)
+	FacilityType(const FacilityType& type, unsigned int multiplicity);
+
 	//Destructor of FacilityType
 	//Delete the generator of binomial distribution
 	//	
@@ -136,10 +145,11 @@ public:
 	inline CUDFcoefficient getDemand(unsigned int stage) const {
 		return demands[stage];
 	}
+	//the demand of a merged group counts for each of its groups (see PSLProblem::aggregateGroups)
 	inline CUDFcoefficient getTotalDemand() {
 		CUDFcoefficient sum = 0;
-		for (CUDFcoefficientListIterator j = demands.begin(); j != demands.end(); ++j)
-			sum += *j;
+		for (unsigned int g = 0; g < demands.size(); ++g)
+			sum += demands[g] * (groupWeights.empty() ? 1 : groupWeights[g]);
 		return sum;
 	}
 	inline CUDFcoefficient getServerCapacity(const unsigned int stype) const {
@@ -153,6 +163,11 @@ public:
 		return sum;
 	}
 
+	//the facilities have neither clients nor servers
+	inline bool isTransit() {
+		return getTotalDemand() == 0 && getTotalCapacity() == 0;
+	}
+
 
 	unsigned int genRandomFacilities();
 	unsigned int genRandomBandwidthIndex();
@@ -163,6 +178,8 @@ public:
 	istream& read(istream& in, const PSLProblem& problem);
 	friend ostream& operator<<(ostream& out, const FacilityType& f);
 
+	friend class PSLProblem;
+
 private:
 	static mt19937 default_random_generator;
 	static uniform_01< mt19937&, double > randd;
@@ -170,6 +187,8 @@ private:
 
 	unsigned int level;
 	CUDFcoefficientList demands;
+	//number of merged groups of each demand (empty if the groups are not aggregated)
+	IntList groupWeights;
 	CUDFcoefficientList serverCapacities;
 	vector<double> bandwidthProbabilities;
 	double reliabilityProbability;
@@ -183,9 +202,11 @@ private:
 
 class FacilityNode {
 	friend class NetworkLink;
+	friend class PSLProblem;
 
 public:
 	FacilityNode(unsigned int id, FacilityType* type) : id(id), type(type), father(NULL) {
+		memory_alloc(MEM_TREE, sizeof(FacilityNode));
 	}
 
 	//Destructor of FacilityNode
@@ -194,6 +215,7 @@ public:
 	//	
 	~FacilityNode() {
 		for_each(children.begin(), children.end(), FonctorDeletePtr());
+		memory_free(MEM_TREE, sizeof(FacilityNode));
 	}
 
 	//the keyword inline is used only on header file
@@ -270,6 +292,7 @@ private:
 //----------------------------------------
 
 class NetworkLink {
+	friend class PSLProblem;
 public:
 
 	NetworkLink(unsigned int id, FacilityNode* father, FacilityNode* child,
@@ -279,7 +302,9 @@ public:
 	//Do not delete origin and destination
 	//because these nodes are deleted in the destructor of PSLProblem
 	//
-	~NetworkLink() {}
+	~NetworkLink() {
+		memory_free(MEM_TREE, sizeof(NetworkLink) + sizeof(NetworkLink*));
+	}
 
 	inline unsigned int getID() const {
 		return id;
@@ -537,7 +562,7 @@ private:
 
 class PSLProblem {
 public:
-	PSLProblem() : _groupCount(0), root(NULL), _nodeCount(0) {}
+	PSLProblem() : _groupCount(0), root(NULL), _nodeCount(0), maxPathLength(UINT_MAX) {}
 
 	//Destructor of PSLProblem
 	//Delete all nodes of the tree
@@ -587,12 +612,58 @@ public:
 	//generate Breadth-First Numbered Tree
 	FacilityNode* generateNetwork(bool hierarchic);
 
+	//contract the transit facilities with a single child into the link from their father,
+	//which takes the minimal bandwidth and the reliability of the chain,
+	//return the number of removed facilities (the tree is numbered again, the levels are kept)
+	unsigned int contractChains();
+
+	//merge the sibling leaves with the same type, bandwidth and reliability into a single facility,
+	//return the number of removed facilities (the tree is numbered again)
+	unsigned int aggregateLeaves();
+
+	//groups of isomorphic sibling subtrees (same types, bandwidths and reliability all the way down), ordered by ID
+	vector<FacilityList> isomorphicSiblings() const;
+
+	//merge the groups of clients with the same demand at every facility type into a single stage,
+	//return the number of removed groups
+	unsigned int aggregateGroups();
+
+	//number of stages of the generated problem
+	inline unsigned int originalStageCount() const {
+		return aggregatedStages.empty() ? stageCount() : aggregatedStages.size();
+	}
+
+	//stage representing a stage of the generated problem (see aggregateGroups)
+	inline unsigned int getAggregatedStage(unsigned int stage) const {
+		return aggregatedStages.empty() ? stage : aggregatedStages[stage];
+	}
+
+	//number of stages of the generated problem within a range represented by each stage
+	IntList getStageWeights(unsigned int min, unsigned int max) const;
+
+	//number of facilities represented by a node (see aggregateLeaves)
+	inline unsigned int getMultiplicity(FacilityNode *node) const {
+		return originalIDs.empty() ? 1 : originalIDs[node->getID()].size();
+	}
+
+	//IDs of the generated facilities represented by a node
+	inline IntList getOriginalIDs(FacilityNode *node) const {
+		return originalIDs.empty() ? IntList(1, node->getID()) : originalIDs[node->getID()];
+	}
+
+	//number of generated facilities merged into an identical sibling leaf (see aggregateLeaves)
+	unsigned int mergedLeafCount() const;
+
 	bool checkNetwork();
 	bool checkNetworkHierarchy();
 	inline FacilityNode* getRoot() const {
 		return root;
 	}
 
+	inline FacilityNode* getNode(unsigned int id) const {
+		return nodes[id];
+	}
+
 	inline unsigned int nodeCount() const {
 		return _nodeCount;
 	}
@@ -601,18 +672,43 @@ public:
 		return _nodeCount - 1;
 	}
 
-	inline unsigned int pathCount() const {
+	//number of paths with variables (see setMaxPathLength)
+	inline Rank pathCount() const {
+		return lengthCumulPathCounts[min(maxPathLength, levelCount())];
+	}
+
+	inline Rank totalPathCount() const {
 		return lengthCumulPathCounts.back();
 	}
 
+	inline unsigned int getMaxPathLength() const {
+		return maxPathLength;
+	}
+
+	//only the paths of length lower or equal than length have variables
+	//(the paths are ranked by length, so that the ranks of the longer paths are dropped)
+	inline void setMaxPathLength(unsigned int length) {
+		maxPathLength = length;
+	}
+
+	//the path from an ancestor to a node has variables
+	inline bool hasPath(const FacilityNode *source, const FacilityNode *destination) const {
+		return destination->getType()->getLevel() - source->getType()->getLevel() <= maxPathLength;
+	}
+
 	inline unsigned int stageCount() const {
 		return _groupCount + 1;
 	}
 
-	inline unsigned int rankCount() const {
+	inline Rank rankCount() const {
 		return endBij();
 	}
 
+	//the ranks fit into the 32 bits column indices of the solvers
+	inline bool hasCompactRanks() const {
+		return rankCount() <= INT_MAX;
+	}
+
 	inline IntList getLevelNodeCounts() {
 		return levelNodeCounts;
 	}
@@ -633,90 +729,113 @@ public:
 	//----------------------------------------
 	//	Rank Mapper (associates each variable to an unique index)
 	//----------------------------------------
-	int rankX(FacilityNode *node) const {
+	Rank rankX(FacilityNode *node) const {
 		return node->getID();
 	}
-	int rankX(FacilityNode *node, unsigned int stype) const {
+	Rank rankX(FacilityNode *node, unsigned int stype) const {
 		assert(stype >= 0 && stype < serverTypeCount());
-		return endX() + node->getID() * serverTypeCount() + stype;
+		return endX() + (Rank) node->getID() * serverTypeCount() + stype;
 	}
 
-	int rankY(FacilityNode *node, unsigned int stage) const {
+	Rank rankY(FacilityNode *node, unsigned int stage) const {
 		assert(stage >= 0 && stage < stageCount());
-		return endXk() + node->getID() * stageCount() + stage;
+		return endXk() + (Rank) node->getID() * stageCount() + stage;
 	}
 
-	int rankZ(FacilityNode *node, unsigned int stage) const {
+	Rank rankZ(FacilityNode *node, unsigned int stage) const {
 		assert(stage >= 0 && stage < stageCount());
-		return endYi() + node->getID() * stageCount() + stage;
+		return endYi() + (Rank) node->getID() * stageCount() + stage;
 	}
 
-	int rankY(NetworkLink *link, unsigned int stage) const {
+	Rank rankY(NetworkLink *link, unsigned int stage) const {
 		assert(stage >= 0 && stage < stageCount());
-		return endZi() + link->getID() * stageCount() + stage;
+		return endZi() + (Rank) link->getID() * stageCount() + stage;
 	}
 
-	int rankZ(FacilityNode *source, FacilityNode *destination, unsigned int stage) const {
+	Rank rankZ(FacilityNode *source, FacilityNode *destination, unsigned int stage) const {
 		return endYij() + rank(source, destination, stage);
 	}
 
-	int rankB(FacilityNode *source, FacilityNode *destination, unsigned int stage) const {
+	Rank rankB(FacilityNode *source, FacilityNode *destination, unsigned int stage) const {
 		return endZij() + rank(source, destination, stage);
 	}
 
-	int rankZ(pair<FacilityNode*, FacilityNode* > const &path, unsigned int stage) const {
+	Rank rankZ(pair<FacilityNode*, FacilityNode* > const &path, unsigned int stage) const {
 		return rankZ(path.first, path.second, stage);
 	}
 
-	int rankB(pair<FacilityNode*, FacilityNode* > const &path, unsigned int stage) const {
+	Rank rankB(pair<FacilityNode*, FacilityNode* > const &path, unsigned int stage) const {
 		return rankB(path.first, path.second, stage);
 	}
+
+	//----------------------------------------
+	//	Reverse Rank Mapper (gives the name of the variable associated to a rank)
+	//----------------------------------------
+	string rankName(Rank rank) const;
+
 private:
 
-	inline int endX() const {
+	inline Rank endX() const {
 		return _nodeCount;
 	}
 
-	inline int endXk() const {
-		return endX() + _nodeCount * serverTypeCount();
+	inline Rank endXk() const {
+		return endX() + (Rank) _nodeCount * serverTypeCount();
 	}
 
-	inline int endYi() const {
-		return endXk() + _nodeCount * stageCount();
+	inline Rank endYi() const {
+		return endXk() + (Rank) _nodeCount * stageCount();
 	}
 
-	inline int endZi() const {
-		return endYi() + _nodeCount * stageCount();
+	inline Rank endZi() const {
+		return endYi() + (Rank) _nodeCount * stageCount();
 	}
 
-	inline int endYij() const {
-		return endZi() +  linkCount() * stageCount();
+	inline Rank endYij() const {
+		return endZi() + (Rank) linkCount() * stageCount();
 	}
 
-	inline int endZij() const {
+	inline Rank endZij() const {
 		return endYij() + pathCount() * stageCount();
 	}
 
-	inline int endBij() const {
+	inline Rank endBij() const {
 		return endZij() + pathCount() * stageCount();
 	}
 
-	inline int rank(FacilityNode* source, FacilityNode* destination) const {
+	inline Rank rank(FacilityNode* source, FacilityNode* destination) const {
 		int length = destination->getType()->getLevel() - source->getType()->getLevel();
 		//path are ranked by length and their index using the bread-first numbered tree.
 		return lengthCumulPathCounts[length-1] + (destination->getID() - levelCumulNodeCounts[length]);
 	}
 
-	inline int rank(FacilityNode* source, FacilityNode* destination, unsigned int stage) const {
+	inline Rank rank(FacilityNode* source, FacilityNode* destination, unsigned int stage) const {
 		assert(stage >= 0 && stage < stageCount());
 		return rank(source, destination) * stageCount() + stage;
 	}
 
+	//source and destination of the path of a given rank (without stage)
+	void unrank(Rank rank, FacilityNode* &source, FacilityNode* &destination) const;
+
+	//check that the node IDs and the ranks do not overflow
+	bool checkRanks() const;
+
+	//initialize the arrays of the rank mapper from the node counts of each level
+	void initRanks();
+
+	//number the remaining nodes in breadth-first order after a reduction of the tree
+	//(represented gives the current nodes represented by each remaining node)
+	void renumber(const vector<IntList> &represented);
+
 	//Delete tree from root node
 	void deleteTree(FacilityNode* node) {
+		nodes.clear();
 		levelNodeCounts.clear();
 		levelCumulNodeCounts.clear();
 		lengthCumulPathCounts.clear();
+		originalIDs.clear();
+		for_each(aggregatedTypes.begin(), aggregatedTypes.end(), FonctorDeletePtr());
+		aggregatedTypes.clear();
 		_nodeCount = 0;
 		if(node != NULL) {
 			for ( size_t i = 0; i < node->getChildrenCount(); ++i ) {
@@ -734,11 +853,20 @@ private:
 	unsigned int _groupCount;
 	FacilityNode* root;
 	unsigned int _nodeCount;
+	//nodes indexed by their ID
+	FacilityList nodes;
 	IntList levelNodeCounts;
 	//number of nodes of level lower or equal than l;
 	IntList levelCumulNodeCounts;
 	//number of path of length lower or equal than l
-	IntList lengthCumulPathCounts;
+	RankList lengthCumulPathCounts;
+	unsigned int maxPathLength;
+	//IDs of the generated facilities represented by each node (empty if the leaves are not aggregated)
+	vector<IntList> originalIDs;
+	//types of the aggregated leaves
+	FacilityTypeList aggregatedTypes;
+	//stage representing each stage of the generated problem (empty if the groups are not aggregated)
+	IntList aggregatedStages;
 
 
 };
@@ -8,19 +8,35 @@
 #include <constraint_generation.h>
 #include <criteria.h>
 #include <combiner.h>
+#include <model_stats.h>
+#include <model_writer.h>
+#include <model_cache.h>
+#include <batch.h>
+#include <presolve.h>
+#include <run_report.h>
+#include <evaluator.h>
 #include <sys/stat.h>
 #include <errno.h>
 #include <limits.h>
 #include "graphviz.hpp"
 
 
-#define HIERARCHIC true
-
 PSLProblem* current_problem = NULL;
 PSLProblem* the_problem = NULL;
 
 int verbosity = DEFAULT;
 double time_limit = 600; // 10 mn per subproblem
+int solver_threads = 1;
+bool variable_names = true;
+bool column_bounds = true;
+bool presolve_model = false;
+bool flow_formulation = false;
+unsigned int max_path_length = UINT_MAX;
+bool merge_leaves = false;
+bool contract_chains = false;
+bool merge_groups = false;
+bool symmetry_breaking = false;
+bool warm_start = true;
 
 template <typename T>
 T* makeCombiner(CriteriaList* criteria, char* name) {
@@ -38,6 +54,7 @@ T* makeCombiner(CriteriaList* criteria, char* name) {
 extern abstract_solver *new_lp_solver(char *lpsolver);
 #ifdef USECPLEX 
 extern abstract_solver *new_cplex_solver();
+extern void open_cplex_environment();
 #endif
 #ifdef USELPSOLVE 
 extern abstract_solver *new_lpsolve_solver();
@@ -45,6 +62,66 @@ extern abstract_solver *new_lpsolve_solver();
 #ifdef USEGLPK
 extern abstract_solver *new_glpk_solver(bool use_exact);
 #endif
+#ifdef USEHIGHS
+extern abstract_solver *new_highs_solver();
+#endif
+
+// create the solver selected by a command line option (the default solver if none)
+abstract_solver *create_solver(const char *option, char *lpsolver) {
+	if (option == NULL) {
+#ifdef USECPLEX
+		return new_cplex_solver();
+#else
+#ifdef USEHIGHS
+		return new_highs_solver();
+#else
+#ifdef USEGLPK
+		return new_glpk_solver(false);
+#else
+#ifdef USELPSOLVE
+		return new_lpsolve_solver();
+#endif
+#endif
+#endif
+#endif
+	} else if (strcmp(option, "-lp") == 0) {
+		return new_lp_solver(lpsolver);
+#ifdef USECPLEX
+	} else if (strcmp(option, "-cplex") == 0) {
+		return new_cplex_solver();
+#endif
+#ifdef USELPSOLVE
+	} else if (strcmp(option, "-lpsolve") == 0) {
+		return new_lpsolve_solver();
+#endif
+#ifdef USEGLPK
+	} else if (strcmp(option, "-glpk") == 0) {
+		return new_glpk_solver(false);
+#endif
+#ifdef USEHIGHS
+	} else if (strcmp(option, "-highs") == 0) {
+		return new_highs_solver();
+#endif
+	}
+	fprintf(stderr, "ERROR: no solver defined\n");
+	exit(-1);
+}
+
+// open the environment of the solver selected by a command line option once by process (see batch.h);
+// only CPLEX has one, the other solvers allocate their state with each model
+void open_solver_environment(const char *option) {
+#ifdef USECPLEX
+	if (option == NULL || strcmp(option, "-cplex") == 0) open_cplex_environment();
+#endif
+}
+
+// a criteria combination of the command line
+struct criteria_plan {
+	abstract_combiner *combiner;
+	char *descr;
+
+	criteria_plan(abstract_combiner *combiner, char *descr) : combiner(combiner), descr(descr) {}
+};
 
 // print cudf help
 void print_help() {
@@ -57,6 +134,9 @@ void print_help() {
 	fprintf(
 			stderr,
 			"Usual call: opossum -i <input_file> -o <outputfile> <criteria combiner>[<criteria>{, <criteria>}*] <solver option> <other options>?\n");
+	fprintf(
+			stderr,
+			"Several criteria combinations are solved one after the other: the structural constraints are generated only once.\n");
 	fprintf(stderr, "file options:\n");
 	fprintf(
 			stderr,
@@ -72,11 +152,39 @@ void print_help() {
 #ifdef USEGLPK
 	fprintf(stderr, "\t-glpk: use glpk solver\n");
 #endif
+#ifdef USEHIGHS
+	fprintf(stderr, "\t-highs: use HiGHS solver\n");
+#endif
+	fprintf(stderr, "\t-threads <n>: number of threads of the solver (cplex and HiGHS, 1 by default)\n");
 	fprintf(
 			stderr,
 			"\t-lp <lpsolver>: use lp (cplex format) solver <lpsolver> (tested with scip and cbc)\n");
 	fprintf(stderr,
 			"\t-nosolve: do not solve the problem (for debug purpose)\n");
+	fprintf(stderr,
+			"\t-nonames: do not name the variables while building the model (names are generated when a lp file is written)\n");
+	fprintf(stderr,
+			"\t-nowarmstart: do not give the greedy placement of the servers as a starting solution to the solver\n");
+	fprintf(stderr,
+			"\t-presolve: remove the fixed variables, the redundant constraints and substitute the variables defined by equalities before the solver\n");
+	fprintf(stderr,
+			"\t-flow: use the flow formulation (the links sum up the flows entering subtrees instead of all the paths passing through them,\n"
+			"\t\tsame optimum, fewer nonzeros only on the deep networks: about 10%% more on the generated instances)\n");
+	fprintf(stderr,
+			"\t-maxlength <n>: only the paths of length lower or equal than <n> carry connections (smaller model, possibly worse solutions or none)\n");
+	fprintf(stderr,
+			"\t-mergegroups: merge the groups of clients with the same demands into a single stage (exact when the objectives sum up the stages)\n");
+	fprintf(stderr,
+			"\t-contract: contract the transit facilities (no clients and no servers) with a single child into the link from their father\n");
+	fprintf(stderr,
+			"\t-mergeleaves: merge the identical sibling leaves into a single facility (smaller model whose objective is a bound,\n"
+			"\t\tthe servers are then spread over the leaves and the placement is evaluated: SAT if feasible, UNKNOWN otherwise)\n");
+	fprintf(stderr,
+			"\t-symmetry: order the servers of the isomorphic sibling subtrees (same optimum, smaller search tree)\n");
+	fprintf(stderr,
+			"\t-eval <file>: evaluate the placement of the servers of a solution file instead of solving the problem\n");
+	fprintf(stderr,
+			"\t-nobounds: do not derive the upper bounds of the variables from the network (capacities are constraints)\n");
 	fprintf(stderr, "combining criteria:\n");
 	fprintf(stderr, " -lexicographic[<lccriteria>{,<lccriteria>}*]\n");
 	fprintf(stderr,
@@ -153,6 +261,16 @@ void print_help() {
 	fprintf(stderr, "\t-v<n>: set verbosity level to n\n");
 	fprintf(stderr, "\t-s<n>: set the seed for the problem generator to n\n");
 	fprintf(stderr, "\t-id: print node IDs in graphviz\n");
+	fprintf(stderr, "\t-report <json_file>: write the wall and cpu times of the run phases and the statistics of each objective level into <json_file>\n");
+	fprintf(stderr, "\t-trace <json_file>: write the spans of the run into <json_file> (chrome trace event format)\n");
+	fprintf(stderr, "\t-stats <json_file>: print the model statistics by constraint family and criteria, and write them into <json_file>\n");
+	fprintf(stderr, "\t-cache <directory>: load the model from <directory> if it has already been generated with the same input file, seed and criteria, otherwise save it there (requires -i and -s)\n");
+	fprintf(stderr, "\t-export <model_file>: write the model into <model_file> (.lp or .mps, optionally followed by .gz) before solving it\n");
+	fprintf(stderr, "\t-batch <manifest>: solve the jobs listed in <manifest>, one per line: <input_file> <seed> <criteria combination> [<solver> [<time limit>]]\n");
+	fprintf(stderr, "\t                   where <solver> is -cplex, -highs, -glpk, -lpsolve, -lp:<lpsolver> or - (default), and print out one JSON object per job\n");
+	fprintf(stderr, "\t-daemon <socket>: serve the jobs sent on the Unix domain socket <socket>, one per line as in a manifest (quit, sent by the same user, stops the daemon)\n");
+	fprintf(stderr, "\t-jobs <n>: number of jobs of a batch or of the daemon solved at the same time (1 by default)\n");
+	fprintf(stderr, "\t           by workers which open the solver environment once and solve each job in a forked process\n");
 	fprintf(stderr, "\t-h|-help|--help: print this help\n");
 
 }
@@ -343,6 +461,11 @@ CriteriaList *process_criteria(char *crit_descr, unsigned int &pos, bool first_l
 				exit(-1);
 			}
 
+			// observe the model generated by the criteria (see -stats)
+			// a combiner is labelled by its name, a criteria by its whole description
+			unsigned int label_length = dynamic_cast<abstract_combiner *>(criteria->back()) ? crit_name_length + 1 : pos - sign;
+			criteria->back() = new criteria_probe(criteria->back(), string(crit_descr + sign, label_length));
+
 			if (crit_descr[pos] == ',') pos++; // skip comma
 		}
 	} else {
@@ -362,18 +485,63 @@ CriteriaList *get_criteria(char *crit_descr, bool first_level, vector<abstract_c
 
 // main CUDF function
 
+// create the criteria combiner described by a command line option (NULL if the option is not a combiner)
+abstract_combiner *new_combiner(char *descr, vector<abstract_criteria *> *criteria_with_property) {
+	if (strncmp(descr, "-lex[", 5) == 0) {
+		return makeCombiner<lexicographic_combiner>(get_criteria(descr+4, true, criteria_with_property), C_STR("lexicographic"));
+	} else if (strncmp(descr, "-lexicographic[", 15) == 0) {
+		return makeCombiner<lexicographic_combiner>(get_criteria(descr+14, true, criteria_with_property), C_STR("lexicographic"));
+	} else if (strncmp(descr, "-agregate[", 10) == 0) {
+		return makeCombiner<agregate_combiner>(get_criteria(descr+9, false, criteria_with_property), C_STR("agregate"));
+	} else if (strncmp(descr, "-lexagregate[", 13) == 0) {
+		return makeCombiner<lexagregate_combiner>(get_criteria(descr+12, false, criteria_with_property), C_STR("lexagregate"));
+	} else if (strncmp(descr, "-lexsemiagregate[", 17) == 0) {
+		return makeCombiner<lexsemiagregate_combiner>(get_criteria(descr+16, false, criteria_with_property), C_STR("lexsemiagregate"));
+	} else if (strncmp(descr, "-leximax[", 9) == 0) {
+		return makeCombiner<leximax_combiner>(get_criteria(descr+8, false, criteria_with_property), C_STR("leximax"));
+	} else if (strncmp(descr, "-leximin[", 9) == 0) {
+		return makeCombiner<leximin_combiner>(get_criteria(descr+8, false, criteria_with_property), C_STR("leximin"));
+	} else if (strncmp(descr, "-lexleximax[", 12) == 0) {
+		return makeCombiner<lexleximax_combiner>(get_criteria(descr+11, false, criteria_with_property), C_STR("lexleximax"));
+	} else if (strncmp(descr, "-lexleximin[", 12) == 0) {
+		return makeCombiner<lexleximin_combiner>(get_criteria(descr+11, false, criteria_with_property), C_STR("lexleximin"));
+	}
+	return NULL;
+}
+
 int main(int argc, char *argv[]) {
 	ofstream output_file;
 	abstract_solver *solver = (abstract_solver *) NULL;
+	const char *solver_option = NULL;
+	char *lpsolver = NULL;
 	abstract_combiner *combiner = (abstract_combiner *) NULL;
-	char* obj_descr;
+	char* obj_descr = NULL;
+	vector<criteria_plan> plans;
 	unsigned int* seed = NULL;
 	bool nosolve = false;
 	bool got_input = false;
 	bool got_output = false;
+	char* stats_file = NULL;
+	char* export_file = NULL;
+	char* input_file = NULL;
+	char* cache_dir = NULL;
+	milp_model *recorded_model = NULL;
+	char* report_file = NULL;
+	char* trace_file = NULL;
+	char* batch_file = NULL;
+	char* daemon_socket = NULL;
+	char* placement_file = NULL;
+	int batch_workers = 1;
 	PSLProblem *problem;
 
 	vector<abstract_criteria *> criteria_with_property; //TODO Remove useless list ?
+	// the trace is opened before the input file is parsed
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-trace") == 0) {
+			the_trace = new trace_writer();
+			the_trace->thread_name("main");
+		}
+	}
 	// parameter handling
 	if (argc > 1) {
 		for (int i = 1; i < argc; i++) {
@@ -387,6 +555,7 @@ int main(int argc, char *argv[]) {
 						exit(-1);
 					} else {
 						got_input = true;
+						input_file = argv[i];
 						switch (parse_pslp(in))
 						{
 						case 0: break;
@@ -406,87 +575,144 @@ int main(int argc, char *argv[]) {
 					}
 					got_output=true;
 				}
+			} else if (strcmp(argv[i], "-stats") == 0) {
+				if (++i < argc) {
+					stats_file = argv[i];
+					model_statistics = new model_stats();
+				} else {
+					fprintf(stderr, "ERROR: -stats option require a file: -stats <json_file>\n");
+					exit(-1);
+				}
+			} else if (strcmp(argv[i], "-export") == 0) {
+				if (++i < argc) {
+					export_file = argv[i];
+					recorded_model = new milp_model();
+				} else {
+					fprintf(stderr, "ERROR: -export option require a file: -export <model_file>\n");
+					exit(-1);
+				}
+			} else if (strcmp(argv[i], "-cache") == 0) {
+				if (++i < argc) {
+					cache_dir = argv[i];
+				} else {
+					fprintf(stderr, "ERROR: -cache option require a directory: -cache <directory>\n");
+					exit(-1);
+				}
+			} else if (strcmp(argv[i], "-report") == 0) {
+				if (++i < argc) {
+					report_file = argv[i];
+				} else {
+					fprintf(stderr, "ERROR: -report option require a file: -report <json_file>\n");
+					exit(-1);
+				}
+			} else if (strcmp(argv[i], "-trace") == 0) {
+				if (++i < argc) {
+					trace_file = argv[i];
+				} else {
+					fprintf(stderr, "ERROR: -trace option require a file: -trace <json_file>\n");
+					exit(-1);
+				}
+			} else if (strcmp(argv[i], "-threads") == 0) {
+				if (++i >= argc || sscanf(argv[i], "%d", &solver_threads) != 1 || solver_threads < 1) {
+					fprintf(stderr, "ERROR: -threads option require a positive number: -threads <n>\n");
+					exit(-1);
+				}
+			} else if (strcmp(argv[i], "-batch") == 0) {
+				if (++i < argc) {
+					batch_file = argv[i];
+				} else {
+					fprintf(stderr, "ERROR: -batch option require a file: -batch <manifest>\n");
+					exit(-1);
+				}
+			} else if (strcmp(argv[i], "-daemon") == 0) {
+				if (++i < argc) {
+					daemon_socket = argv[i];
+				} else {
+					fprintf(stderr, "ERROR: -daemon option require a socket: -daemon <socket>\n");
+					exit(-1);
+				}
+			} else if (strcmp(argv[i], "-maxlength") == 0) {
+				if (++i >= argc || sscanf(argv[i], "%u", &max_path_length) != 1) {
+					fprintf(stderr, "ERROR: -maxlength option require a path length: -maxlength <n>\n");
+					exit(-1);
+				}
+			} else if (strcmp(argv[i], "-jobs") == 0) {
+				if (++i >= argc || sscanf(argv[i], "%d", &batch_workers) != 1 || batch_workers < 1) {
+					fprintf(stderr, "ERROR: -jobs option require a positive number: -jobs <n>\n");
+					exit(-1);
+				}
+			} else if (strcmp(argv[i], "-symmetry") == 0) {
+				symmetry_breaking = true;
+			} else if (strcmp(argv[i], "-eval") == 0) {
+				if (++i < argc) {
+					placement_file = argv[i];
+				} else {
+					fprintf(stderr, "ERROR: -eval option require a placement: -eval <file>\n");
+					exit(-1);
+				}
 			} else if (strncmp(argv[i], "-t", 2) == 0) {
 				sscanf(argv[i]+2, "%lf", &time_limit);
 			} else if (strncmp(argv[i], "-v", 2) == 0) {
 				sscanf(argv[i]+2, "%u", &verbosity);
 			} else if (strncmp(argv[i], "-s",2) == 0) {
-				unsigned int tmp;
+				static unsigned int tmp;
 				sscanf(argv[i]+2, "%u", &tmp);
 				seed = &tmp;
 				sscanf(argv[i]+2, "%u", &(*seed));
 			} else if (strcmp(argv[i], "-id") == 0) {
 				showID=true;
-			} else if (strncmp(argv[i], "-lex[", 5) == 0) {
-				CriteriaList *criteria = get_criteria(argv[i]+4, true, &criteria_with_property);
-				combiner = makeCombiner<lexicographic_combiner>(criteria, C_STR("lexicographic"));
-				obj_descr = argv[i];
-			} else if (strncmp(argv[i], "-lexicographic[", 15) == 0) {
-				CriteriaList *criteria = get_criteria(argv[i]+14, true, &criteria_with_property);
-				combiner = makeCombiner<lexicographic_combiner>(criteria, C_STR("lexicographic"));
-				obj_descr = argv[i];
-			} else if (strncmp(argv[i], "-agregate[", 10) == 0) {
-				CriteriaList *criteria = get_criteria(argv[i]+9, false, &criteria_with_property);
-				combiner = makeCombiner<agregate_combiner>(criteria, C_STR("agregate"));
-				obj_descr = argv[i];
-			} else if (strncmp(argv[i], "-lexagregate[", 13) == 0) {
-				CriteriaList *criteria = get_criteria(argv[i]+12, false, &criteria_with_property);
-				combiner = makeCombiner<lexagregate_combiner>(criteria, C_STR("lexagregate"));
-				obj_descr = argv[i];
-			} else if (strncmp(argv[i], "-lexsemiagregate[", 17) == 0) {
-				CriteriaList *criteria = get_criteria(argv[i]+16, false, &criteria_with_property);
-				combiner = makeCombiner<lexsemiagregate_combiner>(criteria, C_STR("lexsemiagregate"));
-				obj_descr = argv[i];
-			} else if (strncmp(argv[i], "-leximax[", 9) == 0) {
-				CriteriaList *criteria = get_criteria(argv[i]+8, false, &criteria_with_property);
-				combiner = makeCombiner<leximax_combiner>(criteria, C_STR("leximax"));
-				obj_descr = argv[i];
-			} else if (strncmp(argv[i], "-leximin[", 9) == 0) {
-				CriteriaList *criteria = get_criteria(argv[i]+8, false, &criteria_with_property);
-				combiner = makeCombiner<leximin_combiner>(criteria, C_STR("leximin"));
-				obj_descr = argv[i];
-			} else if (strncmp(argv[i], "-lexleximax[", 12) == 0) {
-				CriteriaList *criteria = get_criteria(argv[i]+11, false, &criteria_with_property);
-				combiner = makeCombiner<lexleximax_combiner>(criteria, C_STR("lexleximax"));
-				obj_descr = argv[i];
-			} else if (strncmp(argv[i], "-lexleximin[", 12) == 0) {
-				CriteriaList *criteria = get_criteria(argv[i]+11, false, &criteria_with_property);
-				combiner = makeCombiner<lexleximin_combiner>(criteria, C_STR("lexleximin"));
+			} else if ((combiner = new_combiner(argv[i], &criteria_with_property)) != NULL) {
 				obj_descr = argv[i];
+				plans.push_back(criteria_plan(combiner, obj_descr));
 			} else if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "-help") == 0 || strcmp(argv[i], "--help") == 0 ) {
 				print_help();
 				exit(-1);
 			} else if (strcmp(argv[i], "-nosolve") == 0) {
 				nosolve = true;
+			} else if (strcmp(argv[i], "-nonames") == 0) {
+				variable_names = false;
+			} else if (strcmp(argv[i], "-nobounds") == 0) {
+				column_bounds = false;
+			} else if (strcmp(argv[i], "-nowarmstart") == 0) {
+				warm_start = false;
+			} else if (strcmp(argv[i], "-presolve") == 0) {
+				presolve_model = true;
+			} else if (strcmp(argv[i], "-flow") == 0) {
+				flow_formulation = true;
+			} else if (strcmp(argv[i], "-mergegroups") == 0) {
+				merge_groups = true;
+			} else if (strcmp(argv[i], "-contract") == 0) {
+				contract_chains = true;
+			} else if (strcmp(argv[i], "-mergeleaves") == 0) {
+				merge_leaves = true;
 			} else if (strcmp(argv[i], "-lp") == 0) {
 				if (++i < argc) {
 					struct stat sts;
 					if (stat(argv[i], &sts) == -1 && errno == ENOENT) {
 						fprintf(stderr, "ERROR: -lp option require a lp solver: -lp <lpsolver> and %s does not exist.\n", argv[i]);
 						exit(-1);
-					} else
-						fprintf(stderr, "ERROR: -lp option is not yet implemented\n");
-					exit(-1);
-					//solver = new_lp_solver(argv[i]);
+					}
+					solver_option = "-lp";
+					lpsolver = argv[i];
 				} else {
 					fprintf(stderr, "ERROR: -lp option require a lp solver: -lp <lpsolver>\n");
 					exit(-1);
 				}
 #ifdef USECPLEX
 			} else if (strcmp(argv[i], "-cplex") == 0) {
-				solver = new_cplex_solver();
+				solver_option = argv[i];
 #endif
 #ifdef USELPSOLVE
 			} else if (strcmp(argv[i], "-lpsolve") == 0) {
-				fprintf(stderr, "ERROR: -lpsolve option is not yet implemented\n");
-				exit(-1);
-				//solver = new_lpsolve_solver();
+				solver_option = argv[i];
 #endif
 #ifdef USEGLPK
 			} else if (strcmp(argv[i], "-glpk") == 0) {
-				fprintf(stderr, "ERROR: -glpk option is not yet implemented\n");
-				exit(-1);
-				//solver = new_glpk_solver(false);
+				solver_option = argv[i];
+#endif
+#ifdef USEHIGHS
+			} else if (strcmp(argv[i], "-highs") == 0) {
+				solver_option = argv[i];
 #endif
 			} else {
 				fprintf(stderr, "ERROR: unrecognized option %s\n", argv[i]);
@@ -495,11 +721,27 @@ int main(int argc, char *argv[]) {
 		}
 	}
 
+	// solve the jobs of a manifest instead of a single problem (see batch.h)
+	if (batch_file) {
+		int failures = run_batch(batch_file, got_output ? output_file : cout, batch_workers);
+		if (got_output) {
+			output_file.close();
+		}
+		exit(failures > 0 ? 1 : 0);
+	}
+	if (daemon_socket) {
+		exit(run_daemon(daemon_socket, batch_workers));
+	}
 	// if no objective, abort
-	if(! combiner) {
+	if(plans.empty()) {
 		fprintf(stderr, "ERROR: missing objective specification.\n");
 		exit(-1);
 	}
+	// the statistics, the models and the report are written for a single criteria combination
+	if(plans.size() > 1 && (stats_file || export_file || cache_dir || report_file)) {
+		fprintf(stderr, "ERROR: -stats, -export, -cache and -report options require a single objective specification.\n");
+		exit(-1);
+	}
 	// if no input file defined, then use stdin
 	if (! got_input) {
 		switch (parse_pslp(cin)) {
@@ -509,8 +751,29 @@ int main(int argc, char *argv[]) {
 		}
 	}
 	//Generate problem instance
+	if(merge_leaves && ! seed) {
+		// the network is generated again to evaluate the placement (see evaluate_merged_leaves)
+		static unsigned int drawn = static_cast<unsigned int>(time(NULL));
+		seed = &drawn;
+	}
 	if(seed) the_problem->setSeed(*seed);
-	the_problem->generateNetwork(HIERARCHIC);
+	the_problem->setMaxPathLength(max_path_length);
+	{
+		report_phase phase("generateNetwork");
+		the_problem->generateNetwork(HIERARCHIC);
+	}
+	if(merge_groups) {
+		report_phase phase("aggregateGroups");
+		the_problem->aggregateGroups();
+	}
+	if(contract_chains) {
+		report_phase phase("contractChains");
+		the_problem->contractChains();
+	}
+	if(merge_leaves) {
+		report_phase phase("aggregateLeaves");
+		the_problem->aggregateLeaves();
+	}
 
 	ostream& out = got_output ? output_file : cout;
 	// if whished, print out the read problem
@@ -525,22 +788,6 @@ int main(int argc, char *argv[]) {
 	}
 
 
-	// choose the solver
-	if (solver == (abstract_solver *)NULL)
-#ifdef USECPLEX
-		solver = new_cplex_solver();
-#else
-#ifdef USEGLPK
-	solver = new_glpk_solver(false);
-#else
-#ifdef USELPSOLVE
-	solver = new_lpsolve_solver();
-#else
-	{	fprintf(stderr, "ERROR: no solver defined\n"); exit(-1);}
-#endif
-#endif
-#endif
-
 	// check criteria properties
 	//		for (vector<abstract_criteria *>::iterator icrit = criteria_with_property.begin(); icrit != criteria_with_property.end(); icrit++)
 	//			(*icrit)->check_property(the_problem);
@@ -553,70 +800,188 @@ int main(int argc, char *argv[]) {
 	}
 
 	problem = the_problem;
-	// combiner initialization
-	combiner->initialize(problem, solver);
+	// the criteria combinations share the structural constraints which are generated once
+	milp_model *structure = NULL;
+	if (plans.size() > 1) {
+		structure = new milp_model();
+		record_structural_constraints(problem, *structure);
+	}
 
+	int status = ERROR;
+	bool failed = false;
+	for (size_t p = 0; p < plans.size(); p++) {
+		combiner = plans[p].combiner;
+		obj_descr = plans[p].descr;
+		// each criteria combination is solved by a new solver
+		// or the placement is evaluated without solver (see -eval)
+		abstract_solver *backend = placement_file ? new placement_evaluator(placement_file) : create_solver(solver_option, lpsolver);
+		solver = backend;
+		// reduce the model before the solver (see -presolve)
+		if (presolve_model && ! placement_file) solver = new presolve_solver(solver);
+		// look for the model in the cache (see -cache)
+		model_key cache_key;
+		string cache_file;
+		cached_model *cached = NULL;
+		if (cache_dir) {
+			if (seed && input_file && cache_key.add_file(input_file)) {
+				cache_key.add((long long) *seed);
+				cache_key.add((long long) HIERARCHIC);
+				cache_key.add((long long) column_bounds);
+				cache_key.add((long long) flow_formulation);
+				cache_key.add((long long) max_path_length);
+				cache_key.add((long long) merge_leaves);
+				cache_key.add((long long) contract_chains);
+				cache_key.add((long long) merge_groups);
+				cache_key.add((long long) symmetry_breaking);
+				cache_key.add(obj_descr);
+				cache_file = cache_key.filename(cache_dir);
+				cached = new cached_model();
+				if (! cached->load(cache_file.c_str(), cache_key, problem)) {
+					delete cached;
+					cached = NULL;
+					// the model is saved once generated
+					if (! recorded_model) recorded_model = new milp_model();
+				}
+				if (verbosity >= VERBOSE) out << "c MODEL CACHE " << (cached ? "HIT " : "MISS ") << cache_file << endl;
+			} else {
+				if (verbosity >= DEFAULT) fprintf(stderr, "WARNING: the model cache requires an input file (-i) and a seed (-s).\n");
+				cache_dir = NULL;
+			}
+		}
+		// record the generated model (see -export and -cache)
+		if (recorded_model) solver = new model_recorder(solver, recorded_model);
+		// observe the generated model (see -stats)
+		solver = new stats_solver(solver);
+		combiner = new combiner_probe(combiner, string(obj_descr + 1, strcspn(obj_descr + 1, "[")));
+		// combiner initialization
+		combiner->initialize(problem, solver);
 
-	// generate the constraints, solve the problem and print out the solutions
-	//if ((problem->all_packages->size() > 0) && (generate_constraints(problem, *solver, *combiner) == 0) && (! nosolve) && (solver->solve())) {
 
+		// generate the constraints, solve the problem and print out the solutions
+		//if ((problem->all_packages->size() > 0) && (generate_constraints(problem, *solver, *combiner) == 0) && (! nosolve) && (solver->solve())) {
 
 
-	int status = ERROR;
-	if(generate_constraints(problem, *solver, *combiner) == 0) {
-		if(nosolve) status = UNKNOWN;
-		else status = solver->solve();
-	}
 
-	if(verbosity >= DEFAULT) {
-		out << "================================================================" << endl;
-		out << "c " << solver->objectiveCount() << " OBJECTIVES " << obj_descr << endl;
-	}
+		status = ERROR;
+		if((cached ? cached->replay(problem, *solver) : generate_constraints(problem, *solver, *combiner, structure)) == 0) {
+			if(model_statistics) {
+				if(verbosity >= DEFAULT) {
+					model_statistics->print(out);
+				}
+				ofstream stats_out(stats_file);
+				if (!stats_out) {
+					fprintf(stderr, "ERROR: cannot open file %s as statistics file.\n", stats_file);
+					exit(-1);
+				}
+				model_statistics->print_json(stats_out);
+			}
+			if(recorded_model) {
+				report_phase phase("export");
+				if(export_file && write_model(*recorded_model, export_file) != 0) exit(-1);
+				// a failure only disables the cache
+				if(cache_dir && ! cached) save_cached_model(*recorded_model, cache_key, cache_file.c_str());
+				// the recorder does not use the model anymore
+				delete recorded_model;
+				recorded_model = NULL;
+			}
+			if(cached) {
+				delete cached;
+				cached = NULL;
+			}
+			if(nosolve) status = UNKNOWN;
+			else {
+				// start from the greedy placement of the servers (see -nowarmstart)
+				if(warm_start && ! placement_file) set_warm_start(problem, *solver);
+				report_phase phase("solve");
+				status = solver->solve();
+			}
+		}
 
-	if(verbosity >= QUIET) {
-		switch (status) {
-		case UNKNOWN:
-			out << "s UNKNOWN" << endl;
-			break;
-		case UNSAT:
-			out << "s UNSAT" << endl;
-			break;
-		case SAT:
-			out << "s SAT" << endl;
-			break;
-		case OPTIMUM:
-			out << "s OPTIMUM_FOUND" << endl;
-			break;
-		default:
-			out << "s ERROR" << endl;
-			break;
+		// the model of merged leaves is a relaxation: its objective is only a bound,
+		// and its placement is spread over the leaves and evaluated without merging them
+		const bool relaxed = (status == OPTIMUM || status == SAT) && problem->mergedLeafCount() > 0;
+		placement_evaluator evaluation;
+		double bound = 0;
+		if(status == OPTIMUM || status == SAT) {
+			solver->init_solutions();
+			if(relaxed) {
+				bound = solver->objective_value();
+				status = evaluate_merged_leaves(problem, solver, *seed, obj_descr, evaluation);
+			}
 		}
-	}
 
+		if(verbosity >= DEFAULT) {
+			out << "================================================================" << endl;
+			out << "c " << solver->objectiveCount() << " OBJECTIVES " << obj_descr << endl;
+		}
 
-	if(status == OPTIMUM || status == SAT) {
-		solver->init_solutions();
-		double obj = solver->objective_value();
 		if(verbosity >= QUIET) {
-			out << "o " << solver->objective_value() << endl;
+			switch (status) {
+			case UNKNOWN:
+				out << "s UNKNOWN" << endl;
+				break;
+			case UNSAT:
+				out << "s UNSAT" << endl;
+				break;
+			case SAT:
+				out << "s SAT" << endl;
+				break;
+			case OPTIMUM:
+				out << "s OPTIMUM_FOUND" << endl;
+				break;
+			default:
+				out << "s ERROR" << endl;
+				break;
+			}
+		}
 
+
+		if((status == OPTIMUM || status == SAT) && ! relaxed) {
+			if(verbosity >= QUIET) {
+				out << "o " << solver->objective_value() << endl;
+
+			}
+		} else if(status == SAT && evaluation.objectiveCount() > 0) {
+			//the objective of the placement spread over the leaves
+			if(verbosity >= QUIET) out << "o " << evaluation.objective_value() << endl;
 		}
-	}
 
-	if(verbosity >= DEFAULT) {
-		out << "d RUNTIME " << solver->timeCount() << endl;
-		out << "d NODES " << solver->nodeCount() << endl;
-		out << "d NBSOLS " << solver->solutionCount() << endl;
-		if(status == OPTIMUM || status == SAT) {
-			out << "d OBJECTIVE " << solver->objective_value() << endl; //For compatibility with grigrid scripts
-			print_solution(out, the_problem, solver);
-			print_messages(out, the_problem, solver);
-			if(verbosity >= VERBOSE) {
-				export_solution(the_problem, solver, obj_descr);
+		if(verbosity >= DEFAULT) {
+			out << "d RUNTIME " << solver->timeCount() << endl;
+			out << "d NODES " << solver->nodeCount() << endl;
+			out << "d NBSOLS " << solver->solutionCount() << endl;
+			if(relaxed) {
+				out << "d BOUND " << bound << endl;
+				out << "c EVALUATION " << evaluation.pservCount << " PSERV    " << evaluation.localCount << " LOCAL    "
+						<< evaluation.connCount << " CONN    " << (CUDFcoefficient) evaluation.bandwidth << " BANDW" << endl;
+				if(status == UNKNOWN) {
+					out << "c EVALUATION " << evaluation.unconnectedCount() << " UNCONNECTED CLIENTS" << endl;
+				}
+			}
+			if(status == OPTIMUM || status == SAT || relaxed) {
+				if(! relaxed) out << "d OBJECTIVE " << solver->objective_value() << endl; //For compatibility with grigrid scripts
+				print_solution(out, the_problem, solver);
+				print_messages(out, the_problem, solver);
+				if(verbosity >= VERBOSE) {
+					export_solution(the_problem, solver, obj_descr);
+				}
 			}
 		}
+		if(status == ERROR) failed = true;
+		// release the solver and its proxies
+		while (solver != backend) {
+			abstract_solver *next = ((proxy_solver *) solver)->solver;
+			delete solver;
+			solver = next;
+		}
+		delete backend;
+		// the probe releases the combiner of the plan
+		delete combiner;
+		combiner = NULL;
+	}
+	if (structure) {
+		delete structure;
 	}
-
 
 	if (got_output) {
 		output_file.close();
@@ -624,48 +989,92 @@ int main(int argc, char *argv[]) {
 	if(verbosity >= DEFAULT) {
 		out << "================================================================" << endl << endl;
 	}
-	exit( status == ERROR ? 1 : 0);
+	if (report_file) {
+		ofstream report_out(report_file);
+		if (!report_out) {
+			fprintf(stderr, "ERROR: cannot open file %s as report file.\n", report_file);
+			exit(-1);
+		}
+		the_report.print_json(report_out, obj_descr, status);
+	}
+	if (trace_file) {
+		ofstream trace_out(trace_file);
+		if (!trace_out) {
+			fprintf(stderr, "ERROR: cannot open file %s as trace file.\n", trace_file);
+			exit(-1);
+		}
+		the_trace->print_json(trace_out);
+	}
+	exit( failed ? 1 : 0);
 }
 
+// the last parsed input (see evaluate_merged_leaves)
+static string pslp_input;
+
 int parse_pslp(istream& in)
 {
+	report_phase phase("parse");
 	if(the_problem) delete the_problem;
 	the_problem = new PSLProblem();
-	in >> *the_problem;
+	ostringstream content;
+	content << in.rdbuf();
+	pslp_input = content.str();
+	istringstream input(pslp_input);
+	input >> *the_problem;
 	return 0;
 }
 
 
 void print_problem(ostream& out, PSLProblem *problem)
 {
+	trace_span span("print_problem", "writer");
 	out << "================================================================" << endl;
-	out << "c " << problem->groupCount() << " GROUPS    "
+	out << "c " << problem->originalStageCount() - 1 << " GROUPS    "
 			<< problem->facilityTypeCount() << " FTYPES    "
 			<< problem->levelTypeCount() << " LEVELS    "
 			<< endl;
 
 	int clientCount = 0;
 	int pservCount = 0;
+	unsigned int facilityCount = 0;
+	unsigned int generatedCount = 0;
 	for(NodeIterator i = problem->nbegin() ; i!=  problem->nend() ; i++) {
 		clientCount += i->getType()->getTotalDemand();
 		pservCount += i->getType()->getTotalCapacity();
+		facilityCount += problem->getMultiplicity(*i);
+		IntList ids = problem->getOriginalIDs(*i);
+		generatedCount = max(generatedCount, *max_element(ids.begin(), ids.end()) + 1);
 	}
-	out << "c " << problem->nodeCount() <<" FACILITIES    "
+	out << "c " << facilityCount <<" FACILITIES    "
 			<< pservCount << " PSERVERS    "
 			<< clientCount << " CLIENTS "
 			<<endl ;
-	if(problem->groupCount() > 1) {
-		int demands[problem->groupCount()];
-		for (int g = 0; g < problem->groupCount(); ++g) {
+	if(facilityCount > problem->nodeCount()) {
+		out << "c " << problem->nodeCount() << " NODES    "
+				<< facilityCount - problem->nodeCount() << " MERGED LEAVES" << endl;
+	}
+	if(generatedCount > facilityCount) {
+		//the last generated facility is a leaf, which is never contracted
+		out << "c " << generatedCount - facilityCount << " CONTRACTED TRANSIT FACILITIES" << endl;
+	}
+	//the groups of the generated problem
+	const unsigned int groupCount = problem->originalStageCount() - 1;
+	if(groupCount > problem->groupCount()) {
+		out << "c " << problem->groupCount() << " STAGES    "
+				<< groupCount - problem->groupCount() << " MERGED GROUPS" << endl;
+	}
+	if(groupCount > 1) {
+		int demands[groupCount];
+		for (unsigned int g = 0; g < groupCount; ++g) {
 			demands[g] = 0;
 		}
 		for(NodeIterator i = problem->nbegin() ; i!=  problem->nend() ; i++) {
-			for (int g = 0; g < problem->groupCount(); ++g) {
-				demands[g] += i->getType()->getDemand(g);
+			for (unsigned int g = 0; g < groupCount; ++g) {
+				demands[g] += i->getType()->getDemand(problem->getAggregatedStage(g + 1) - 1);
 			}
 		}
 		out << "c ";
-		for (int g = 0; g < problem->groupCount(); ++g) {
+		for (unsigned int g = 0; g < groupCount; ++g) {
 			out << demands[g] << " ";
 		}
 
@@ -688,6 +1097,11 @@ void print_problem(ostream& out, PSLProblem *problem)
 		}
 		out << "PSERVERS" << endl;
 	}
+	if(problem->pathCount() < problem->totalPathCount()) {
+		// the connections are restricted: the solutions may be worse than the ones of the whole model
+		out << "c " << problem->getMaxPathLength() << " MAX_LENGTH    "
+				<< problem->pathCount() << "/" << problem->totalPathCount() << " PATHS" << endl;
+	}
 	if (verbosity >= ALL && problem->getRoot()) {
 		out << endl;
 		problem->getRoot()->print(out);
@@ -696,6 +1110,7 @@ void print_problem(ostream& out, PSLProblem *problem)
 
 extern void export_problem(PSLProblem *problem)
 {
+	trace_span span("export_problem", "writer");
 	inst2dotty(*problem);
 }
 
@@ -703,6 +1118,7 @@ extern void export_problem(PSLProblem *problem)
 
 extern void print_generator_summary(ostream & out, PSLProblem *problem)
 {
+	trace_span span("print_generator_summary", "writer");
 	out << "================================================================" << endl;
 	problem->print_generator(out);
 	out << "================================================================" << endl;
@@ -711,27 +1127,103 @@ extern void print_generator_summary(ostream & out, PSLProblem *problem)
 
 
 
+// Servers of type k of a facility represented by a node (see PSLProblem::aggregateLeaves).
+// The servers of a group of leaves are dealt in turn to its facilities, since the servers of a leaf only serve its own clients.
+static CUDFcoefficient facility_servers(PSLProblem *problem, abstract_solver *solver, FacilityNode *node, unsigned int copy, unsigned int k)
+{
+	CUDFcoefficient multiplicity = problem->getMultiplicity(node);
+	CUDFcoefficient dealt = 0;
+	for (unsigned int t = 0; t < k; ++t) {
+		dealt += solver->get_solution(problem->rankX(node, t));
+	}
+	CUDFcoefficient servers = solver->get_solution(problem->rankX(node, k));
+	//the servers of type k are dealt from the facility following the last served one
+	CUDFcoefficient turn = (copy + multiplicity - dealt % multiplicity) % multiplicity;
+	return servers / multiplicity + (turn < servers % multiplicity ? 1 : 0);
+}
+
+int evaluate_merged_leaves(PSLProblem *problem, abstract_solver *solver, unsigned int seed, char *descr, placement_evaluator &evaluator)
+{
+	report_phase phase("evaluateMergedLeaves");
+	PSLProblem *generated = new PSLProblem();
+	istringstream in(pslp_input);
+	in >> *generated;
+	generated->setSeed(seed);
+	generated->setMaxPathLength(max_path_length);
+	generated->generateNetwork(HIERARCHIC);
+	if(merge_groups) generated->aggregateGroups();
+	if(contract_chains) generated->contractChains();
+	//the node which represents each generated facility
+	map<unsigned int, FacilityNode*> facilities;
+	for(NodeIterator i = generated->nbegin() ; i!=  generated->nend() ; i++) {
+		IntList ids = generated->getOriginalIDs(*i);
+		for (size_t c = 0; c < ids.size(); ++c) {
+			facilities[ids[c]] = *i;
+		}
+	}
+	const unsigned int stypes = problem->serverTypeCount();
+	CUDFcoefficientList servers(generated->nodeCount() * stypes, 0);
+	for(NodeIterator i = problem->nbegin() ; i!=  problem->nend() ; i++) {
+		IntList ids = problem->getOriginalIDs(*i);
+		for (unsigned int c = 0; c < ids.size(); ++c) {
+			for (unsigned int k = 0; k < stypes; ++k) {
+				servers[facilities[ids[c]]->getID() * stypes + k] = facility_servers(problem, solver, *i, c, k);
+			}
+		}
+	}
+	//the objectives are evaluated as with -eval (unless the combination requires additional columns)
+	vector<abstract_criteria *> criteria_with_property;
+	abstract_combiner *objectives = new_combiner(descr, &criteria_with_property);
+	objectives->initialize(generated, &evaluator);
+	if(objectives->column_allocation(generated->rankCount()) == generated->rankCount()) {
+		evaluator.init_solver(generated, 0);
+		evaluator.begin_objectives();
+		objectives->objective_generation();
+		evaluator.end_objectives();
+	}
+	delete objectives;
+	const bool feasible = evaluator.evaluate(generated, servers);
+	delete generated;
+	return feasible ? SAT : UNKNOWN;
+}
+
 void print_solution(ostream & out, PSLProblem *problem, abstract_solver *solver)
 {
+	report_phase phase("print_solution");
+	//the generated facilities ordered by ID, with the node and the copy which represent them
+	vector<pair<unsigned int, pair<FacilityNode*, unsigned int> > > facilities;
+	for(NodeIterator i = problem->nbegin() ; i!=  problem->nend() ; i++) {
+		IntList ids = problem->getOriginalIDs(*i);
+		for (unsigned int c = 0; c < ids.size(); ++c) {
+			facilities.push_back(make_pair(ids[c], make_pair(*i, c)));
+		}
+	}
+	sort(facilities.begin(), facilities.end());
 	int cpt = 0;
 	out << "s";
-	for(NodeIterator i = problem->nbegin() ; i!=  problem->nend() ; i++) {
-		int servers = solver->get_solution(problem->rankX(*i));
+	for (size_t f = 0; f < facilities.size(); ++f) {
+		FacilityNode *node = facilities[f].second.first;
+		unsigned int copy = facilities[f].second.second;
+		CUDFcoefficient servers = 0;
+		for (unsigned int k = 0; k < problem->serverTypeCount(); ++k) {
+			servers += facility_servers(problem, solver, node, copy, k);
+		}
 		if(servers > 0) {
 			out << ( ++cpt % 10 == 0 ? "\ns " : " ");
 			//Print #pservers
-			out << i->getID() << "[" << servers;
+			out << facilities[f].first << "[" << servers;
 			//Print pservers capacity
-			if(servers < i->getType()->getTotalCapacity()) {
-				out << "/" << i->getType()->getTotalCapacity();
+			CUDFcoefficient capacity = node->getType()->getTotalCapacity() / problem->getMultiplicity(node);
+			if(servers < capacity) {
+				out << "/" << capacity;
 			}
 			out << "]";
 			//Print pservers by type
 			if(problem->serverTypeCount() > 1) {
 				out << "{";
-				for (int k = 0; k < problem->serverTypeCount(); ++k) {
+				for (unsigned int k = 0; k < problem->serverTypeCount(); ++k) {
 					if(k > 0) out << ",";
-					out << solver->get_solution(problem->rankX(*i, k));
+					out << facility_servers(problem, solver, node, copy, k);
 				}
 				out << "}";
 			}
@@ -744,6 +1236,7 @@ void print_solution(ostream & out, PSLProblem *problem, abstract_solver *solver)
 
 void export_solution(PSLProblem *problem, abstract_solver *solver,char* objective)
 {
+	trace_span span("export_solution", "writer");
 	solution2dotty(*problem, *solver, objective);
 }
 
@@ -751,6 +1244,7 @@ void export_solution(PSLProblem *problem, abstract_solver *solver,char* objectiv
 
 void print_messages(ostream & out, PSLProblem *problem, abstract_solver *solver)
 {
+	trace_span span("print_messages", "writer");
 
 	//Compute total pserver capacity
 	double capa = 0;
@@ -770,7 +1264,8 @@ void print_messages(ostream & out, PSLProblem *problem, abstract_solver *solver)
 	for(NodeIterator i = problem->nbegin() ; i!=  problem->nend() ; i++) {
 		CUDFcoefficient _pserv = solver->get_solution(problem->rankX(*i));
 		if(_pserv > 0) {
-			tot_facilities++;
+			//the servers of merged leaves are spread over the leaves
+			tot_facilities += min(_pserv, (CUDFcoefficient) problem->getMultiplicity(*i));
 			tot_pserv += _pserv;
 			if(i->isReliableFromRoot()) {
 				tot_rel_pserv += _pserv;
@@ -792,23 +1287,24 @@ void print_messages(ostream & out, PSLProblem *problem, abstract_solver *solver)
 		out <<endl;
 	}
 	out << "d REL_PSERVERS " << tot_rel_pserv << endl;
-	//Display spare capacity.
-	double spare_capa[problem->stageCount()];
+	//Display spare capacity (the merged groups share the solution of their stage).
+	const int stageCount = problem->originalStageCount();
+	double spare_capa[stageCount];
 	double avg_spare_capa = 0;
-	for (int s = 1; s < problem->stageCount(); ++s) {
+	for (int s = 1; s < stageCount; ++s) {
 		double clients = 0;
 		for(NodeIterator i = problem->nbegin() ; i!=  problem->nend() ; i++) {
-			clients += solver->get_solution(problem->rankY(*i, s));
+			clients += solver->get_solution(problem->rankY(*i, problem->getAggregatedStage(s)));
 		}
 		spare_capa[s] = (capa-clients)/capa;
 		avg_spare_capa +=spare_capa[s];
 	}
 	out.precision(3);
-	avg_spare_capa/= problem->stageCount()-1;
+	avg_spare_capa/= stageCount-1;
 	out << "d SPARE_CAPA " << fixed << avg_spare_capa <<endl;
-	if(problem->stageCount() > 2) {
+	if(stageCount > 2) {
 		out << "d VEC_SPARE_CAPA ";
-		for (int s = 1; s < problem->stageCount(); ++s) {
+		for (int s = 1; s < stageCount; ++s) {
 			out << spare_capa[s] << " ";
 		}
 		out << endl;
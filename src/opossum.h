@@ -25,6 +25,28 @@ using namespace std;
 
 // Handling the time limit per subproblem
 extern double time_limit;
+// Handling the number of threads of the solver
+extern int solver_threads;
+// Handling variable names (if false, names are generated on demand by the rank mapper)
+extern bool variable_names;
+// Handling column bounds (if false, the columns are unbounded and the capacities are constraints)
+extern bool column_bounds;
+// Handling the presolve of the model (see presolve.h)
+extern bool presolve_model;
+// Handling the flow formulation (if true, the path columns are the flows from their source entering the subtree of their destination)
+extern bool flow_formulation;
+// Handling the maximal length of the paths with variables (UINT_MAX if unlimited)
+extern unsigned int max_path_length;
+// Handling the aggregation of the identical sibling leaves (see PSLProblem::aggregateLeaves)
+extern bool merge_leaves;
+// Handling the contraction of the chains of transit facilities (see PSLProblem::contractChains)
+extern bool contract_chains;
+// Handling the aggregation of the groups of clients with the same demands (see PSLProblem::aggregateGroups)
+extern bool merge_groups;
+// Handling the symmetry breaking constraints between isomorphic sibling subtrees (see PSLProblem::isomorphicSiblings)
+extern bool symmetry_breaking;
+// Handling the starting solution given by the greedy placement of the servers (see set_warm_start)
+extern bool warm_start;
 ;
 //Solver status
 #define ERROR 0
@@ -35,6 +57,9 @@ extern double time_limit;
 
 
 
+// Generate hierarchic networks
+#define HIERARCHIC true
+
 #define C_STR( text ) ((char*)std::string( text ).c_str())
 
 // current CUDF problem
@@ -0,0 +1,305 @@
+/*******************************************************/
+/* oPoSSuM solver: presolve.c                          */
+/* Reduction of the model before the solver            */
+/* (c) Arnaud Malapert I3S (UNS-CNRS) 2012             */
+/*******************************************************/
+
+#include <presolve.h>
+#include <run_report.h>
+#include <math.h>
+#include <algorithm>
+
+#define PRESOLVE_PASSES 8        // maximal number of passes over the rows
+#define PRESOLVE_MAX_ROWS 8      // maximal number of rows modified by a substitution
+
+static inline CUDFcoefficient floor_div(CUDFcoefficient a, CUDFcoefficient b) {
+	CUDFcoefficient q = a / b;
+	return (a % b != 0 && ((a < 0) != (b < 0))) ? q - 1 : q;
+}
+
+static inline CUDFcoefficient ceil_div(CUDFcoefficient a, CUDFcoefficient b) {
+	CUDFcoefficient q = a / b;
+	return (a % b != 0 && ((a < 0) == (b < 0))) ? q + 1 : q;
+}
+
+static inline double upper_bound(CUDFcoefficient ub) {
+	return ub == MODEL_INFINITY ? HUGE_VAL : (double) ub;
+}
+
+int presolve_solver::init_solver(PSLProblem *problem, int other_vars) {
+	recorder.init_solver(problem, other_vars);
+	// the columns as defined by the solver
+	init_type = model.vartype;
+	init_lb = model.lb;
+	init_ub = model.ub;
+	return solver->init_solver(problem, other_vars);
+}
+
+//----------------------------------------------------------------------------------------------------
+// Reduction
+//----------------------------------------------------------------------------------------------------
+
+void presolve_solver::load() {
+	vartype = model.vartype;
+	lb = model.lb;
+	ub = model.ub;
+	state.assign(model.nb_vars, 'K');
+	values.assign(model.nb_vars, 0);
+	in_objective.assign(model.nb_vars, false);
+	for (size_t k = 0; k < model.obj_index.size(); k++) in_objective[model.obj_index[k]] = true;
+	substitutions.clear();
+	column_rows.assign(model.nb_vars, vector<int>());
+	rows.resize(model.rowCount());
+	for (int r = 0; r < model.rowCount(); r++) {
+		presolve_row &row = rows[r];
+		row.index.assign(model.row_index.begin() + model.row_start[r], model.row_index.begin() + model.row_start[r + 1]);
+		row.coeff.assign(model.row_coeff.begin() + model.row_start[r], model.row_coeff.begin() + model.row_start[r + 1]);
+		row.sense = model.row_sense[r];
+		row.rhs = model.rhs[r];
+		row.active = true;
+		for (size_t t = 0; t < row.index.size(); t++) column_rows[row.index[t]].push_back(r);
+	}
+}
+
+void presolve_solver::fix(int column, CUDFcoefficient value) {
+	state[column] = 'F';
+	values[column] = value;
+	lb[column] = ub[column] = value;
+}
+
+void presolve_solver::activity(const presolve_row &row, int skip, double &min, double &max) const {
+	min = max = 0;
+	for (size_t t = 0; t < row.index.size(); t++) {
+		if ((int) t == skip) continue;
+		int k = row.index[t];
+		double a = row.coeff[t];
+		// a substitution may cancel a coefficient (and 0 * HUGE_VAL is not a number)
+		if (a == 0) continue;
+		if (a > 0) {
+			min += a * lb[k];
+			max += a * upper_bound(ub[k]);
+		} else {
+			min += a * upper_bound(ub[k]);
+			max += a * lb[k];
+		}
+	}
+}
+
+bool presolve_solver::reduce_row(int r, bool &changed) {
+	presolve_row &row = rows[r];
+	size_t n = 0;
+	for (size_t t = 0; t < row.index.size(); t++) {
+		int k = row.index[t];
+		if (state[k] == 'F') {
+			row.rhs -= row.coeff[t] * values[k];
+		} else if (row.coeff[t] != 0) {
+			row.index[n] = k;
+			row.coeff[n] = row.coeff[t];
+			n++;
+		}
+	}
+	row.index.resize(n);
+	row.coeff.resize(n);
+
+	if (n == 0) {
+		if ((row.sense == 'G' && row.rhs > 0) || (row.sense == 'L' && row.rhs < 0) || (row.sense == 'E' && row.rhs != 0)) return false;
+		row.active = false;
+		changed = true;
+		return true;
+	}
+
+	if (n == 1) {
+		int k = row.index[0];
+		CUDFcoefficient a = row.coeff[0];
+		// the bounds of a real column remain integers
+		if (row.rhs % a != 0 && vartype[k] == 'C') return true;
+		if (row.sense == 'E') {
+			if (row.rhs % a != 0) return false;
+			CUDFcoefficient value = row.rhs / a;
+			if (value < lb[k] || value > ub[k]) return false;
+			fix(k, value);
+		} else if ((row.sense == 'G') == (a > 0)) {
+			// a lower bound can not be given to an unbounded column
+			if (ub[k] == MODEL_INFINITY) return true;
+			lb[k] = max(lb[k], ceil_div(row.rhs, a));
+		} else {
+			ub[k] = min(ub[k], floor_div(row.rhs, a));
+		}
+		if (lb[k] > ub[k]) return false;
+		if (lb[k] == ub[k] && state[k] == 'K') fix(k, lb[k]);
+		row.active = false;
+		changed = true;
+		return true;
+	}
+
+	if (row.sense != 'E') {
+		double min, max;
+		activity(row, -1, min, max);
+		if ((row.sense == 'G' && max < row.rhs) || (row.sense == 'L' && min > row.rhs)) return false;
+		if ((row.sense == 'G' && min >= row.rhs) || (row.sense == 'L' && max <= row.rhs)) {
+			row.active = false;
+			changed = true;
+		}
+	}
+	return true;
+}
+
+bool presolve_solver::substitute(int r) {
+	presolve_row &row = rows[r];
+	if (row.index.size() < 2) return false;
+	// the value of the column must remain an integer
+	for (size_t t = 0; t < row.index.size(); t++) {
+		if (vartype[row.index[t]] == 'C' || state[row.index[t]] != 'K') return false;
+	}
+	for (size_t t = 0; t < row.index.size(); t++) {
+		int k = row.index[t];
+		CUDFcoefficient a = row.coeff[t];
+		if ((a != 1 && a != -1) || in_objective[k] || column_rows[k].size() > PRESOLVE_MAX_ROWS + 1) continue;
+		// the bounds of the column are implied by the row: a * x = rhs - S
+		double min, max;
+		activity(row, (int) t, min, max);
+		double xmin = a > 0 ? row.rhs - max : min - row.rhs;
+		double xmax = a > 0 ? row.rhs - min : max - row.rhs;
+		if (xmin < lb[k] || xmax > upper_bound(ub[k])) continue;
+
+		presolve_substitution substitution;
+		substitution.column = k;
+		substitution.coeff = a;
+		substitution.row = row;
+		// c * x = c * a * (rhs - S) in the other rows
+		for (size_t i = 0; i < column_rows[k].size(); i++) {
+			int q = column_rows[k][i];
+			if (q == r || ! rows[q].active) continue;
+			presolve_row &other = rows[q];
+			size_t pos = find(other.index.begin(), other.index.end(), k) - other.index.begin();
+			if (pos == other.index.size()) continue;
+			CUDFcoefficient mult = other.coeff[pos] * a;
+			other.index.erase(other.index.begin() + pos);
+			other.coeff.erase(other.coeff.begin() + pos);
+			for (size_t u = 0; u < row.index.size(); u++) {
+				if (u == t) continue;
+				int j = row.index[u];
+				size_t p = find(other.index.begin(), other.index.end(), j) - other.index.begin();
+				if (p == other.index.size()) {
+					other.index.push_back(j);
+					other.coeff.push_back(0);
+					column_rows[j].push_back(q);
+				}
+				other.coeff[p] -= mult * row.coeff[u];
+			}
+			other.rhs -= mult * row.rhs;
+		}
+		state[k] = 'S';
+		row.active = false;
+		substitutions.push_back(substitution);
+		return true;
+	}
+	return false;
+}
+
+bool presolve_solver::reduce() {
+	bool changed = true;
+	for (int pass = 0; changed && pass < PRESOLVE_PASSES; pass++) {
+		changed = false;
+		for (size_t r = 0; r < rows.size(); r++) {
+			if (rows[r].active && ! reduce_row(r, changed)) return false;
+		}
+		for (size_t r = 0; r < rows.size(); r++) {
+			if (rows[r].active && rows[r].sense == 'E' && substitute(r)) changed = true;
+		}
+	}
+	// the last fixed columns are removed from the remaining rows
+	for (size_t r = 0; r < rows.size(); r++) {
+		if (rows[r].active && ! reduce_row(r, changed)) return false;
+	}
+	return true;
+}
+
+//----------------------------------------------------------------------------------------------------
+// Reduced model
+//----------------------------------------------------------------------------------------------------
+
+void presolve_solver::replay() {
+	for (int k = 0; k < model.nb_vars; k++) {
+		// a substituted column has no coefficient anymore
+		if (state[k] == 'S') ub[k] = lb[k];
+		if (vartype[k] == init_type[k] && lb[k] == init_lb[k] && ub[k] == init_ub[k]) continue;
+		if (ub[k] == MODEL_INFINITY) continue;
+		if (vartype[k] == 'C') solver->set_realvar_range(k, lb[k], ub[k]);
+		else solver->set_intvar_range(k, lb[k], ub[k]);
+	}
+
+	solver->begin_objectives();
+	for (int i = 0; i < model.objectiveCount(); i++) {
+		solver->new_objective();
+		for (long long t = model.obj_start[i]; t < model.obj_start[i + 1]; t++) solver->set_obj_coeff(model.obj_index[t], model.obj_coeff[t]);
+		solver->add_objective();
+	}
+	solver->end_objectives();
+
+	solver->begin_add_constraints();
+	int remaining = 0;
+	for (size_t r = 0; r < rows.size(); r++) {
+		const presolve_row &row = rows[r];
+		if (! row.active) continue;
+		remaining++;
+		solver->new_constraint();
+		for (size_t t = 0; t < row.index.size(); t++) solver->set_constraint_coeff(row.index[t], row.coeff[t]);
+		switch (row.sense) {
+		case 'G': solver->add_constraint_geq(row.rhs); break;
+		case 'L': solver->add_constraint_leq(row.rhs); break;
+		default: solver->add_constraint_eq(row.rhs); break;
+		}
+	}
+	if (verbosity >= VERBOSE) {
+		printf("c PRESOLVE %d/%d ROWS %d FIXED %d SUBSTITUTED\n", remaining, model.rowCount(),
+				(int) count(state.begin(), state.end(), 'F'), (int) substitutions.size());
+	}
+}
+
+int presolve_solver::end_add_constraints(void) {
+	recorder.end_add_constraints();
+	{
+		report_phase phase("presolve");
+		load();
+		// the solver proves the infeasibility by itself
+		if (! reduce()) load();
+		replay();
+	}
+	return solver->end_add_constraints();
+}
+
+int presolve_solver::set_mip_start(const vector<double> &start) {
+	vector<double> reduced(start);
+	// a substituted column is fixed to its lower bound (see replay)
+	for (size_t k = 0; k < reduced.size() && k < state.size(); k++) {
+		if (state[k] != 'K') reduced[k] = lb[k];
+	}
+	return solver->set_mip_start(reduced);
+}
+
+//----------------------------------------------------------------------------------------------------
+// Postsolve
+//----------------------------------------------------------------------------------------------------
+
+int presolve_solver::init_solutions() {
+	int status = solver->init_solutions();
+	// a column is substituted before the columns of its row
+	for (int i = substitutions.size() - 1; i >= 0; i--) {
+		const presolve_substitution &s = substitutions[i];
+		CUDFcoefficient value = s.row.rhs;
+		for (size_t t = 0; t < s.row.index.size(); t++) {
+			if (s.row.index[t] != s.column) value -= s.row.coeff[t] * get_solution(s.row.index[t]);
+		}
+		values[s.column] = s.coeff * value;
+	}
+	return status;
+}
+
+CUDFcoefficient presolve_solver::get_solution(int k) {
+	return state[k] == 'K' ? solver->get_solution(k) : values[k];
+}
+
+double presolve_solver::get_real_solution(int k) {
+	return state[k] == 'K' ? solver->get_real_solution(k) : values[k];
+}
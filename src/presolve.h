@@ -0,0 +1,112 @@
+/*******************************************************/
+/* oPoSSuM solver: presolve.h                          */
+/* Reduction of the model before the solver            */
+/* (c) Arnaud Malapert I3S (UNS-CNRS) 2012             */
+/*******************************************************/
+
+// The whole model is recorded, reduced, and then defined in the underlying solver (at end_add_constraints).
+// The columns can not be removed from the solver (they are numbered by the ranks of the problem):
+// the fixed columns keep their value as bounds and the substituted columns lose all their coefficients.
+// Reductions:
+//  - the fixed columns are removed from the rows;
+//  - a row with a single column becomes a bound (an equality fixes the column);
+//  - a row which is satisfied by the bounds of its columns is dropped;
+//  - an equality defining an integer column with a coefficient +-1 from integer columns is substituted
+//    in the other rows if the bounds of the column are implied (the column must not appear in an objective).
+// The objectives are not modified, so that the objective values are those of the original model.
+// If the model is proved infeasible, it is given to the solver without reduction.
+
+#ifndef _PRESOLVE_H
+#define _PRESOLVE_H
+
+#include <milp_model.h>
+
+// A row of the reduced model
+struct presolve_row {
+	vector<int> index;
+	vector<CUDFcoefficient> coeff;
+	char sense;                  // 'G', 'L' or 'E'
+	CUDFcoefficient rhs;
+	bool active;
+};
+
+// A column substituted by an equality: coeff * column + sum(terms) = rhs (coeff is +-1)
+struct presolve_substitution {
+	int column;
+	CUDFcoefficient coeff;
+	presolve_row row;
+};
+
+class presolve_solver: public proxy_solver {
+public:
+	int init_solver(PSLProblem *problem, int other_vars);
+
+	int set_intvar_range(int rank, CUDFcoefficient lower, CUDFcoefficient upper) { return recorder.set_intvar_range(rank, lower, upper); }
+	int set_realvar_range(int rank, CUDFcoefficient lower, CUDFcoefficient upper) { return recorder.set_realvar_range(rank, lower, upper); }
+	int set_intvar(int rank, char* name, CUDFcoefficient lower, CUDFcoefficient upper) { return recorder.set_intvar_range(rank, lower, upper); }
+	int set_realvar(int rank, char* name, CUDFcoefficient lower, CUDFcoefficient upper) { return recorder.set_realvar_range(rank, lower, upper); }
+	int set_intvar(int rank, char* name) { return recorder.set_intvar(rank, NULL); }
+	int set_realvar(int rank, char* name) { return recorder.set_realvar(rank, NULL); }
+	int set_boolvar(int rank, char* name) { return recorder.set_boolvar(rank, NULL); }
+
+	// the model is defined in the solver once reduced
+	int begin_objectives(void) { return 0; }
+	CUDFcoefficient get_obj_coeff(int rank) { return recorder.get_coeff(rank); }
+	int set_obj_coeff(int rank, CUDFcoefficient value) { return recorder.set_obj_coeff(rank, value); }
+	int new_objective(void) { return recorder.new_objective(); }
+	int add_objective(void) { return recorder.add_objective(); }
+	int end_objectives(void) { return 0; }
+
+	int begin_add_constraints(void) { return 0; }
+	int new_constraint(void) { return recorder.new_constraint(); }
+	CUDFcoefficient get_constraint_coeff(int rank) { return recorder.get_coeff(rank); }
+	int set_constraint_coeff(int rank, CUDFcoefficient value) { return recorder.set_constraint_coeff(rank, value); }
+	int add_constraint_geq(CUDFcoefficient bound) { return recorder.add_constraint_geq(bound); }
+	int add_constraint_leq(CUDFcoefficient bound) { return recorder.add_constraint_leq(bound); }
+	int add_constraint_eq(CUDFcoefficient bound) { return recorder.add_constraint_eq(bound); }
+	// reduce the model and define it in the solver
+	int end_add_constraints(void);
+
+	// the fixed and substituted columns of the starting solution take their values in the reduced model
+	int set_mip_start(const vector<double> &start);
+
+	// the values of the fixed and substituted columns are restored
+	int init_solutions();
+	CUDFcoefficient get_solution(int k);
+	double get_real_solution(int k);
+
+	presolve_solver(abstract_solver *solver) : proxy_solver(solver), recorder(&none, &model) {}
+
+private:
+	milp_model model;             // recorded model
+	abstract_solver none;
+	model_recorder recorder;
+	vector<char> init_type;       // columns as defined by the solver
+	vector<CUDFcoefficient> init_lb, init_ub;
+
+	// Reduced model
+	vector<char> vartype;
+	vector<CUDFcoefficient> lb, ub;
+	vector<char> state;           // 'K'ept, 'F'ixed or 'S'ubstituted
+	vector<bool> in_objective;
+	vector<presolve_row> rows;
+	vector< vector<int> > column_rows;   // rows of each column (possibly inactive or outdated)
+	vector<presolve_substitution> substitutions;
+	vector<CUDFcoefficient> values;      // values of the fixed and substituted columns
+
+	// build the reduced model from the recorded one
+	void load();
+	// reduce the model, return false if it is proved infeasible
+	bool reduce();
+	// remove the fixed columns of a row, then turn it into a bound or drop it if possible
+	bool reduce_row(int r, bool &changed);
+	// substitute a column defined by an equality
+	bool substitute(int r);
+	void fix(int column, CUDFcoefficient value);
+	// bounds of the activity of a row without one of its terms
+	void activity(const presolve_row &row, int skip, double &min, double &max) const;
+	// define the reduced model in the solver
+	void replay();
+};
+
+#endif
@@ -0,0 +1,67 @@
+/*******************************************************/
+/* oPoSSuM solver: proxy_solver.h                      */
+/* Decorator class for solvers                         */
+/* (c) Arnaud malapert I3S (UNS-CNRS) 2012             */
+/*******************************************************/
+
+// A proxy forwards every call to an underlying solver.
+// Concrete proxies only override the calls they want to observe or alter.
+
+#ifndef _PROXY_SOLVER_H
+#define _PROXY_SOLVER_H
+
+#include <abstract_solver.h>
+
+class proxy_solver: public abstract_solver {
+public:
+	abstract_solver *solver;  // underlying solver
+
+	int init_solver(PSLProblem *problem, int other_vars) { return solver->init_solver(problem, other_vars); }
+
+	int set_intvar_range(int rank, CUDFcoefficient lower, CUDFcoefficient upper) { return solver->set_intvar_range(rank, lower, upper); }
+	int set_realvar_range(int rank, CUDFcoefficient lower, CUDFcoefficient upper) { return solver->set_realvar_range(rank, lower, upper); }
+	int set_intvar(int rank, char* name, CUDFcoefficient lower, CUDFcoefficient upper) { return solver->set_intvar(rank, name, lower, upper); }
+	int set_realvar(int rank, char* name, CUDFcoefficient lower, CUDFcoefficient upper) { return solver->set_realvar(rank, name, lower, upper); }
+	int set_intvar(int rank, char* name) { return solver->set_intvar(rank, name); }
+	int set_realvar(int rank, char* name) { return solver->set_realvar(rank, name); }
+	int set_boolvar(int rank, char* name) { return solver->set_boolvar(rank, name); }
+
+	int begin_objectives(void) { return solver->begin_objectives(); }
+	CUDFcoefficient get_obj_coeff(int rank) { return solver->get_obj_coeff(rank); }
+	int set_obj_coeff(int rank, CUDFcoefficient value) { return solver->set_obj_coeff(rank, value); }
+	int new_objective(void) { return solver->new_objective(); }
+	int add_objective(void) { return solver->add_objective(); }
+	int end_objectives(void) { return solver->end_objectives(); }
+
+	int begin_add_constraints(void) { return solver->begin_add_constraints(); }
+	int new_constraint(void) { return solver->new_constraint(); }
+	CUDFcoefficient get_constraint_coeff(int rank) { return solver->get_constraint_coeff(rank); }
+	int set_constraint_coeff(int rank, CUDFcoefficient value) { return solver->set_constraint_coeff(rank, value); }
+	int add_constraint_geq(CUDFcoefficient bound) { return solver->add_constraint_geq(bound); }
+	int add_constraint_leq(CUDFcoefficient bound) { return solver->add_constraint_leq(bound); }
+	int add_constraint_eq(CUDFcoefficient bound) { return solver->add_constraint_eq(bound); }
+	int end_add_constraints(void) { return solver->end_add_constraints(); }
+
+	int writelp(char *filename) { return solver->writelp(filename); }
+
+	int set_mip_start(const vector<double> &start) { return solver->set_mip_start(start); }
+
+	int solve() { return solver->solve(); }
+
+	int init_solutions() { return solver->init_solutions(); }
+	CUDFcoefficient objective_value() { return solver->objective_value(); }
+	CUDFcoefficient get_solution(int k) { return solver->get_solution(k); }
+	double get_real_solution(int k) { return solver->get_real_solution(k); }
+	int solutionCount() { return solver->solutionCount(); }
+	int objectiveCount() { return solver->objectiveCount(); }
+	int nodeCount() { return solver->nodeCount(); }
+	double timeCount() { return solver->timeCount(); }
+
+	// proxy creation
+	proxy_solver(abstract_solver *solver) : solver(solver) {}
+
+	// the underlying solver is not deleted
+	virtual ~proxy_solver() {}
+};
+
+#endif
@@ -27,7 +27,7 @@ void pserv_criteria::initialize_upper_bound(PSLProblem *problem) {
 			}
 }
 // Computing the number of columns required to handle the criteria
-int pserv_criteria::set_variable_range(int first_free_var) {
+Rank pserv_criteria::set_variable_range(Rank first_free_var) {
 	return first_free_var;
 }
 
@@ -24,7 +24,7 @@ public:
 	// Criteria initialization
 	void initialize(PSLProblem *problem, abstract_solver *solver);
 	// Allocate some columns for the criteria
-	int set_variable_range(int first_free_var);
+	Rank set_variable_range(Rank first_free_var);
 	// Add the criteria to the objective
 	int add_criteria_to_objective(CUDFcoefficient lambda);
 	// Add the criteria to the constraint set
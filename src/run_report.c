@@ -0,0 +1,133 @@
+/*******************************************************/
+/* oPoSSuM solver: run_report.c                        */
+/* Phase timing and machine-readable run report        */
+/* (c) Arnaud Malapert I3S (UNS-CNRS) 2012             */
+/*******************************************************/
+
+#include <run_report.h>
+#include <sstream>
+#include <unistd.h>
+
+run_report the_report;
+
+const char *status_name(int status) {
+	switch (status) {
+	case UNKNOWN: return "UNKNOWN";
+	case UNSAT: return "UNSAT";
+	case SAT: return "SAT";
+	case OPTIMUM: return "OPTIMUM_FOUND";
+	default: return "ERROR";
+	}
+}
+
+string json_string(const string &s) {
+	string r = "\"";
+	for (size_t i = 0; i < s.size(); ++i) {
+		if(s[i] == '"' || s[i] == '\\') r += '\\';
+		r += s[i];
+	}
+	return r + "\"";
+}
+
+int run_report::begin_phase(const char *name) {
+	int idx = phases.size();
+	phases.push_back(phase_record(name, stack.empty() ? -1 : stack.back(), elapsed()));
+	stack.push_back(idx);
+	timers.push_back(phase_timer());
+	return idx;
+}
+
+void run_report::end_phase(int idx) {
+	while(! stack.empty()) {
+		int top = stack.back();
+		phases[top].wall = timers.back().wall();
+		phases[top].cpu = timers.back().cpu();
+		phases[top].rss = memory_rss();
+		phases[top].peak_rss = memory_peak_rss();
+		for (int m = 0; m < MEM_SUBSYSTEMS; ++m) phases[top].memory[m] = memory_counters()[m].current;
+		if(the_trace) the_trace->complete(phases[top].name, "phase", timers.back().wall_start, timers.back().wall_start + phases[top].wall);
+		stack.pop_back();
+		timers.pop_back();
+		if(top == idx) break;
+	}
+}
+
+void run_report::begin_level(level_record &level) {
+	level.start = elapsed();
+	level_timer.start();
+}
+
+void run_report::end_level(level_record &level) {
+	level.wall = level_timer.wall();
+	level.cpu = level_timer.cpu();
+	levels.push_back(level);
+	if(the_trace) {
+		ostringstream name;
+		name << "level " << level.objective;
+		the_trace->complete(name.str(), "level", level_timer.wall_start, level_timer.wall_start + level.wall);
+	}
+	if(progress_fd >= 0) {
+		ostringstream line;
+		line << "{\"event\": \"level\", \"objective\": " << level.objective
+				<< ", \"status\": " << json_string(status_name(level.status));
+		if(level.has_value) line << ", \"value\": " << level.value;
+		line << ", \"wall\": " << level.wall << "}" << endl;
+		string s = line.str();
+		if(write(progress_fd, s.data(), s.size()) < 0) progress_fd = -1;
+	}
+}
+
+void run_report::print_json(ostream &out, const char *objective, int status) {
+	trace_span span("run report", "writer");
+	out << "{\"objective\": " << json_string(objective ? objective : "")
+			<< ", \"status\": " << json_string(status_name(status))
+			<< ", \"wall\": " << clock.wall()
+			<< ", \"cpu\": " << clock.cpu()
+			<< ", \"rss\": " << memory_rss()
+			<< ", \"peak_rss\": " << memory_peak_rss() << "," << endl;
+	// bytes allocated by each subsystem
+	out << " \"memory\": {";
+	for (int m = 0; m < MEM_SUBSYSTEMS; ++m) {
+		const memory_counter &c = memory_counters()[m];
+		out << (m > 0 ? ", " : "") << json_string(memory_subsystem_name(m))
+				<< ": {\"current\": " << c.current
+				<< ", \"peak\": " << c.peak
+				<< ", \"allocations\": " << c.allocations << "}";
+	}
+	out << "}," << endl;
+	out << " \"phases\": [";
+	for (size_t i = 0; i < phases.size(); ++i) {
+		const phase_record &p = phases[i];
+		out << (i > 0 ? "," : "") << endl
+				<< "  {\"name\": " << json_string(p.name)
+				<< ", \"parent\": " << (p.parent < 0 ? "null" : json_string(phases[p.parent].name))
+				<< ", \"start\": " << p.start
+				<< ", \"wall\": " << p.wall
+				<< ", \"cpu\": " << p.cpu
+				<< ", \"rss\": " << p.rss
+				<< ", \"peak_rss\": " << p.peak_rss
+				<< ", \"memory\": {";
+		for (int m = 0; m < MEM_SUBSYSTEMS; ++m) {
+			out << (m > 0 ? ", " : "") << json_string(memory_subsystem_name(m)) << ": " << p.memory[m];
+		}
+		out << "}}";
+	}
+	out << "]," << endl;
+	out << " \"levels\": [";
+	for (size_t i = 0; i < levels.size(); ++i) {
+		const level_record &l = levels[i];
+		out << (i > 0 ? "," : "") << endl
+				<< "  {\"objective\": " << l.objective
+				<< ", \"status\": " << json_string(status_name(l.status))
+				<< ", \"start\": " << l.start
+				<< ", \"wall\": " << l.wall
+				<< ", \"cpu\": " << l.cpu
+				<< ", \"nodes\": " << l.nodes
+				<< ", \"solutions\": " << l.solutions;
+		if(l.gap >= 0) out << ", \"gap\": " << l.gap;
+		else out << ", \"gap\": null";
+		if(l.has_value) out << ", \"value\": " << l.value;
+		out << "}";
+	}
+	out << "]}" << endl;
+}
@@ -0,0 +1,102 @@
+/*******************************************************/
+/* oPoSSuM solver: run_report.h                        */
+/* Phase timing and machine-readable run report        */
+/* (c) Arnaud Malapert I3S (UNS-CNRS) 2012             */
+/*******************************************************/
+
+// A run is divided into (nested) phases: parsing, network generation, constraint generation, solving ...
+// The solvers also record each objective level (lexicographic sub-problem) they solve.
+
+#ifndef _RUN_REPORT_H
+#define _RUN_REPORT_H
+
+#include <opossum.h>
+#include <timer.h>
+#include <trace.h>
+
+// A phase of the run
+class phase_record {
+public:
+	string name;
+	int parent;      // index of the enclosing phase (-1 if none)
+	double start;    // start time since the beginning of the run
+	double wall;     // wall time in seconds
+	double cpu;      // cpu time in seconds
+	long long rss;        // resident set size at the end of the phase (bytes)
+	long long peak_rss;   // peak resident set size at the end of the phase (bytes)
+	long long memory[MEM_SUBSYSTEMS];   // memory allocated by each subsystem at the end of the phase (bytes)
+
+	phase_record(string name, int parent, double start) : name(name), parent(parent), start(start), wall(0), cpu(0), rss(0), peak_rss(0) {
+		for (int m = 0; m < MEM_SUBSYSTEMS; ++m) memory[m] = 0;
+	}
+};
+
+// An objective level solved by the solver
+class level_record {
+public:
+	int objective;            // index of the objective
+	double start;             // start time since the beginning of the run
+	double wall;              // wall time in seconds
+	double cpu;               // cpu time in seconds
+	long long nodes;          // number of explored nodes
+	int solutions;            // number of solutions found
+	double gap;               // relative gap (negative if unknown)
+	int status;               // solver status (see opossum.h)
+	bool has_value;           // is the objective value known ?
+	double value;             // objective value
+
+	level_record(int objective) : objective(objective), start(0), wall(0), cpu(0),
+			nodes(0), solutions(0), gap(-1), status(UNKNOWN), has_value(false), value(0) {}
+};
+
+class run_report {
+public:
+	vector<phase_record> phases;
+	vector<level_record> levels;
+	int progress_fd;    // file descriptor receiving a JSON line at the end of each level (-1 if none)
+
+	// start a phase within the current one
+	int begin_phase(const char *name);
+	// end a phase (and all the phases it contains), the phase is also traced
+	// the memory usage is sampled at the end of the phase
+	void end_phase(int idx);
+
+	// start the timer of a level
+	void begin_level(level_record &level);
+	// stop the timer of a level and record it
+	void end_level(level_record &level);
+
+	// time since the beginning of the run
+	double elapsed() const { return clock.wall(); }
+
+	// Print out the report as a JSON object
+	void print_json(ostream &out, const char *objective, int status);
+
+	run_report() : progress_fd(-1) {}
+
+private:
+	phase_timer clock;             // started with the run
+	vector<int> stack;             // opened phases
+	vector<phase_timer> timers;    // timers of the opened phases
+	phase_timer level_timer;
+};
+
+// report of the current run
+extern run_report the_report;
+
+// Record a phase for the lifetime of the object
+class report_phase {
+public:
+	report_phase(const char *name) : idx(the_report.begin_phase(name)) {}
+	~report_phase() { the_report.end_phase(idx); }
+private:
+	int idx;
+};
+
+// Name of a solver status
+extern const char *status_name(int status);
+
+// JSON string (quotes and backslashes are escaped)
+extern string json_string(const string &s);
+
+#endif
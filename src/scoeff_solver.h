@@ -13,6 +13,7 @@
 #include <vector>
 #include <stdlib.h>
 #include <stdio.h>
+#include <memory_usage.h>
 
 
 // Template to allow coefficient saving
@@ -48,11 +49,13 @@ public:
 			this->sindex[k] = sindex[k];
 			this->coefficients[k] = coefficients[k];
 		}
+		memory_alloc(MEM_OBJECTIVES, n * (sizeof(int) + sizeof(coeffT)));
 	};
 
 	~saved_coefficients() {
 		free(sindex);
 		free(coefficients);
+		memory_free(MEM_OBJECTIVES, (nb_coeffs + first_tab_index) * (sizeof(int) + sizeof(coeffT)));
 	};
 };
 
@@ -129,6 +132,7 @@ public:
 			fprintf(stderr, "scoeff_solvers: new: not enough memory to create coefficients.\n");
 			exit(-1);
 		}
+		memory_alloc(MEM_COEFFS, n * (2 * sizeof(int) + sizeof(coeffT)));
 	};
 
 	// Store the multiple objective functions
@@ -145,6 +149,7 @@ public:
 		free(tindex);
 		free(sindex);
 		free(coefficients);
+		memory_free(MEM_COEFFS, (nb_vars + first_tab_index) * (2 * sizeof(int) + sizeof(coeffT)));
 	};
 
 };
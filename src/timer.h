@@ -0,0 +1,43 @@
+/*******************************************************/
+/* oPoSSuM solver: timer.h                             */
+/* High resolution timers                              */
+/* (c) Arnaud Malapert I3S (UNS-CNRS) 2012             */
+/*******************************************************/
+
+
+#ifndef _TIMER_H
+#define _TIMER_H
+
+#include <time.h>
+
+// monotonic wall clock in seconds
+inline double wall_clock() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// cpu time of the process in seconds
+inline double cpu_clock() {
+	struct timespec ts;
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Measure the wall and cpu times elapsed since the timer (re)start
+class phase_timer {
+public:
+	double wall_start;
+	double cpu_start;
+
+	void start() {
+		wall_start = wall_clock();
+		cpu_start = cpu_clock();
+	}
+	double wall() const { return wall_clock() - wall_start; }
+	double cpu() const { return cpu_clock() - cpu_start; }
+
+	phase_timer() { start(); }
+};
+
+#endif
@@ -0,0 +1,64 @@
+/*******************************************************/
+/* oPoSSuM solver: trace.c                             */
+/* Chrome trace event export                           */
+/* (c) Arnaud Malapert I3S (UNS-CNRS) 2012             */
+/*******************************************************/
+
+#include <trace.h>
+#include <run_report.h>
+#include <iomanip>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+trace_writer *the_trace = NULL;
+
+int trace_tid() {
+	return syscall(SYS_gettid);
+}
+
+trace_writer::trace_writer() : origin(wall_clock()) {
+	pthread_mutex_init(&lock, NULL);
+}
+
+trace_writer::~trace_writer() {
+	pthread_mutex_destroy(&lock);
+}
+
+void trace_writer::complete(const string &name, const char *category, double start, double end) {
+	int tid = trace_tid();
+	pthread_mutex_lock(&lock);
+	events.push_back(trace_event(name, category, start, end - start, tid));
+	pthread_mutex_unlock(&lock);
+}
+
+void trace_writer::thread_name(const string &name) {
+	int tid = trace_tid();
+	pthread_mutex_lock(&lock);
+	threads[tid] = name;
+	pthread_mutex_unlock(&lock);
+}
+
+void trace_writer::print_json(ostream &out) {
+	pthread_mutex_lock(&lock);
+	int pid = getpid();
+	out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [" << endl;
+	out << "  {\"name\": \"process_name\", \"ph\": \"M\", \"pid\": " << pid << ", \"tid\": " << pid
+			<< ", \"args\": {\"name\": \"opossum\"}}";
+	for (map<int, string>::iterator i = threads.begin(); i != threads.end(); i++) {
+		out << "," << endl << "  {\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": " << pid << ", \"tid\": " << i->first
+				<< ", \"args\": {\"name\": " << json_string(i->second) << "}}";
+	}
+	// timestamps and durations are in microseconds
+	out << fixed << setprecision(3);
+	for (size_t i = 0; i < events.size(); ++i) {
+		const trace_event &e = events[i];
+		out << "," << endl << "  {\"name\": " << json_string(e.name)
+				<< ", \"cat\": \"" << e.category << "\""
+				<< ", \"ph\": \"X\", \"ts\": " << (e.start - origin) * 1e6
+				<< ", \"dur\": " << e.duration * 1e6
+				<< ", \"pid\": " << pid << ", \"tid\": " << e.tid << "}";
+	}
+	out.unsetf(ios_base::floatfield);
+	out << endl << "]}" << endl;
+	pthread_mutex_unlock(&lock);
+}
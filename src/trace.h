@@ -0,0 +1,79 @@
+/*******************************************************/
+/* oPoSSuM solver: trace.h                             */
+/* Chrome trace event export                           */
+/* (c) Arnaud Malapert I3S (UNS-CNRS) 2012             */
+/*******************************************************/
+
+// Spans (complete events) are buffered in memory and written at the end of the run
+// in the Chrome trace event format (chrome://tracing, Perfetto).
+// Each thread has its own track.
+
+#ifndef _TRACE_H
+#define _TRACE_H
+
+#include <opossum.h>
+#include <timer.h>
+#include <pthread.h>
+
+// A complete event
+class trace_event {
+public:
+	string name;
+	const char *category;
+	double start;    // absolute wall clock in seconds
+	double duration; // in seconds
+	int tid;         // thread of the event
+
+	trace_event(string name, const char *category, double start, double duration, int tid) :
+		name(name), category(category), start(start), duration(duration), tid(tid) {}
+};
+
+class trace_writer {
+public:
+	// record a span of the calling thread
+	void complete(const string &name, const char *category, double start, double end);
+	// give a name to the track of the calling thread
+	void thread_name(const string &name);
+
+	// Print out the events in the Chrome trace event format
+	void print_json(ostream &out);
+
+	trace_writer();
+	virtual ~trace_writer();
+
+private:
+	double origin;                  // wall clock at the trace creation
+	vector<trace_event> events;
+	map<int, string> threads;       // track names
+	pthread_mutex_t lock;
+};
+
+// trace of the current run (NULL if not requested)
+extern trace_writer *the_trace;
+
+// id of the calling thread
+extern int trace_tid();
+
+// Record a span for the lifetime of the object (if a trace is requested)
+class trace_span {
+public:
+	trace_span(const char *name, const char *category) : category(category), start(0) {
+		if (the_trace) {
+			this->name = name;
+			start = wall_clock();
+		}
+	}
+	trace_span(const string &name, const char *category) : category(category), start(0) {
+		if (the_trace) {
+			this->name = name;
+			start = wall_clock();
+		}
+	}
+	~trace_span() { if (the_trace) the_trace->complete(name, category, start, wall_clock()); }
+private:
+	string name;
+	const char *category;
+	double start;
+};
+
+#endif
@@ -8,12 +8,29 @@
 #include <string>
 #include <sstream>
 #include <vector>
+#include <set>
 #include <iterator>
 #include <iostream>
 #include <algorithm>
+#include <unistd.h>
+#include <sys/wait.h>
 
 #include "../src/network.hpp"
 #include "../src/network.cpp"
+#include "../src/milp_model.c"
+#include "../src/presolve.c"
+#include "../src/run_report.c"
+#include "../src/trace.c"
+#include "../src/evaluator.c"
+#include "../src/model_stats.c"
+#include "../src/constraint_generation.c"
+
+//Options of the solver (see opossum.c)
+int verbosity = QUIET;
+bool variable_names = false;
+bool flow_formulation = false;
+bool symmetry_breaking = false;
+bool column_bounds = true;
 
 
 //TODO Add test void forEachPath(FuncType functor) const;
@@ -242,6 +259,399 @@ BOOST_AUTO_TEST_CASE(networkExample)
 
 }
 
+BOOST_AUTO_TEST_CASE(reverseRankMapper)
+{
+	PSLProblem* problem = initProblem();
+	FacilityNode* n0 = problem->getRoot();
+	FacilityNode* n3 = problem->getRoot()->getChild(0)->getChild(0);
+	FacilityNode* n6 = problem->getRoot()->getChild(1)->getChild(0);
+	BOOST_CHECK_EQUAL(problem->rankName(problem->rankX(n3)), "x3");
+	BOOST_CHECK_EQUAL(problem->rankName(problem->rankX(n6, 0)), "x6_0");
+	BOOST_CHECK_EQUAL(problem->rankName(problem->rankY(n3, 0)), "y3'0");
+	BOOST_CHECK_EQUAL(problem->rankName(problem->rankZ(n6, 1)), "z6'1");
+	BOOST_CHECK_EQUAL(problem->rankName(problem->rankY(n3->toFather(), 0)), "y1_3'0");
+	BOOST_CHECK_EQUAL(problem->rankName(problem->rankZ(n0, n3, 0)), "z0_3'0");
+	BOOST_CHECK_EQUAL(problem->rankName(problem->rankB(n0, n6, 1)), "b0_6'1");
+	BOOST_CHECK_EQUAL(problem->rankName(problem->rankCount()), "X0");
+
+	//Each path is found back from its rank
+	for( PathIterator i = problem->getRoot()->pbegin();i != problem->getRoot()->pend();i++) {
+		for (unsigned int s = 0; s < problem->stageCount(); ++s) {
+			ostringstream name;
+			name << "z" << (*i).first->getID() << "_" << (*i).second->getID() << "'" << s;
+			BOOST_CHECK_EQUAL(problem->rankName(problem->rankZ(*i, s)), name.str());
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE(rankMapperBounds)
+{
+	PSLProblem* problem = initProblem();
+	BOOST_CHECK(problem->hasCompactRanks());
+	//The ranks of the paths are consecutive and lower than the rank count
+	Rank last = -1;
+	for (unsigned int s = 0; s < problem->stageCount(); ++s) {
+		for( PathIterator i = problem->getRoot()->pbegin();i != problem->getRoot()->pend();i++) {
+			Rank r = problem->rankB(*i, s);
+			BOOST_CHECK(r >= 0 && r < problem->rankCount());
+			last = max(last, r);
+		}
+	}
+	BOOST_CHECK_EQUAL(last, problem->rankCount() - 1);
+}
+
+BOOST_AUTO_TEST_CASE(rankMapperMaxPathLength)
+{
+	PSLProblem* problem = initProblem();
+	Rank count = problem->rankCount();
+	problem->setMaxPathLength(1);
+	BOOST_CHECK(problem->rankCount() < count);
+	//The ranks of the remaining paths are still consecutive and lower than the rank count
+	Rank last = -1, paths = 0;
+	for( PathIterator i = problem->getRoot()->pbegin();i != problem->getRoot()->pend();i++) {
+		if(problem->hasPath((*i).first, (*i).second)) {
+			paths++;
+			Rank r = problem->rankB(*i, problem->stageCount() - 1);
+			BOOST_CHECK(r >= 0 && r < problem->rankCount());
+			last = max(last, r);
+			ostringstream name;
+			name << "z" << (*i).first->getID() << "_" << (*i).second->getID() << "'0";
+			BOOST_CHECK_EQUAL(problem->rankName(problem->rankZ(*i, 0)), name.str());
+		}
+	}
+	BOOST_CHECK_EQUAL(paths, problem->pathCount());
+	BOOST_CHECK_EQUAL(last, problem->rankCount() - 1);
+	BOOST_CHECK_EQUAL(problem->rankName(problem->rankCount()), "X0");
+}
+
+BOOST_AUTO_TEST_CASE(rankMapperReducedTree)
+{
+	PSLProblem* problem = initProblem();
+	problem->contractChains();
+	problem->aggregateLeaves();
+	BOOST_CHECK(problem->checkNetwork());
+	//The paths of the reduced tree have distinct ranks and names
+	set<Rank> ranks;
+	for( PathIterator i = problem->getRoot()->pbegin();i != problem->getRoot()->pend();i++) {
+		Rank r = problem->rankZ(*i, 0);
+		BOOST_CHECK(r >= 0 && r < problem->rankCount());
+		BOOST_CHECK(ranks.insert(r).second);
+		ostringstream name;
+		name << "z" << (*i).first->getID() << "_" << (*i).second->getID() << "'0";
+		BOOST_CHECK_EQUAL(problem->rankName(r), name.str());
+	}
+}
+
+//Root with two children of type A and one of type B, which only differ by their type, and a leaf of type C under each of them
+const char *siblingsInstance = "2 100 1000  1 10  4 1 "
+		"0 0 1  1 1.0  1.0 0.0  1.0 "
+		"1 0 1  2 1.0  1.0 0.0  1.0 "
+		"1 0 1  1 1.0  1.0 0.0  1.0 "
+		"2 1 1  1 1.0  1.0 0.0  1.0";
+
+//Root with eight leaves of the same type whose links get random bandwidths and reliabilities
+const char *linksInstance = "2 100 1000  1 10  2 1 "
+		"0 0 1  1 1.0  1.0 0.0  1.0 "
+		"1 1 1  8 1.0  0.5 0.5  0.5";
+
+PSLProblem* generateProblem(const char *instance) {
+	istringstream in(instance);
+	PSLProblem* problem = new PSLProblem();
+	in >> *problem;
+	problem->setSeed(SEED);
+	problem->generateNetwork(false);
+	return problem;
+}
+
+BOOST_AUTO_TEST_CASE(isomorphicSiblings)
+{
+	PSLProblem* problem = generateProblem(siblingsInstance);
+	BOOST_REQUIRE_EQUAL(problem->getRoot()->getChildrenCount(), 3);
+	//Only the subtrees of type A are isomorphic, the subtree of type B differs by its type
+	vector<FacilityList> groups = problem->isomorphicSiblings();
+	BOOST_REQUIRE_EQUAL(groups.size(), 1);
+	BOOST_REQUIRE_EQUAL(groups[0].size(), 2);
+	FacilityNode* a1 = problem->getRoot()->getChild(0);
+	FacilityNode* a2 = problem->getRoot()->getChild(1);
+	BOOST_CHECK(a1->getType() != problem->getRoot()->getChild(2)->getType());
+	BOOST_CHECK(groups[0][0] == a1 && groups[0][1] == a2);
+	delete problem;
+
+	//Siblings of the same type are isomorphic iff their links have the same bandwidth and reliability
+	problem = generateProblem(linksInstance);
+	groups = problem->isomorphicSiblings();
+	map<FacilityNode*, int> group;
+	for (size_t g = 0; g < groups.size(); ++g) {
+		for (size_t k = 0; k < groups[g].size(); ++k) {
+			group[groups[g][k]] = g;
+		}
+	}
+	bool bandwidthOnly = false, reliabilityOnly = false;
+	for (LinkListIterator i = problem->getRoot()->cbegin(); i != problem->getRoot()->cend(); ++i) {
+		for (LinkListIterator j = problem->getRoot()->cbegin(); j != i; ++j) {
+			const bool sameBandwidth = (*i)->getBandwidth() == (*j)->getBandwidth();
+			const bool sameReliability = (*i)->isReliable() == (*j)->isReliable();
+			bandwidthOnly |= ! sameBandwidth && sameReliability;
+			reliabilityOnly |= sameBandwidth && ! sameReliability;
+			FacilityNode* u = (*i)->getDestination();
+			FacilityNode* v = (*j)->getDestination();
+			const bool together = group.count(u) && group.count(v) && group[u] == group[v];
+			BOOST_CHECK_EQUAL(together, sameBandwidth && sameReliability);
+		}
+	}
+	BOOST_CHECK(bandwidthOnly && reliabilityOnly);
+	delete problem;
+}
+
+BOOST_AUTO_TEST_CASE(symmetryRows)
+{
+	PSLProblem* problem = generateProblem(siblingsInstance);
+	FacilityNode* a1 = problem->getRoot()->getChild(0);
+	FacilityNode* a2 = problem->getRoot()->getChild(1);
+	milp_model without, with;
+	record_structural_constraints(problem, without);
+	symmetry_breaking = true;
+	record_structural_constraints(problem, with);
+	symmetry_breaking = false;
+	//A single symmetry row x[a1] - x[a2] >= 0 is added for the isomorphic pair
+	BOOST_REQUIRE_EQUAL(with.rowCount(), without.rowCount() + 1);
+	const int r = without.rowCount();
+	map<int, CUDFcoefficient> row;
+	for (long long k = with.row_start[r]; k < with.row_start[r + 1]; ++k) {
+		row[with.row_index[k]] = with.row_coeff[k];
+	}
+	BOOST_CHECK_EQUAL(row.size(), 2);
+	BOOST_CHECK_EQUAL(row[problem->rankX(a1)], 1);
+	BOOST_CHECK_EQUAL(row[problem->rankX(a2)], -1);
+	BOOST_CHECK_EQUAL(with.row_sense[r], 'G');
+	BOOST_CHECK_EQUAL(with.rhs[r], 0);
+	delete problem;
+}
+
+//Root with a leaf whose groups of clients 0 and 2 have the same demands
+const char *groupsInstance = "1 100  1 10  2 3 "
+		"0 0 0 0 1  1 1.0  1.0  1.0 "
+		"1 5 7 5 1  1 1.0  1.0  1.0";
+
+BOOST_AUTO_TEST_CASE(aggregateGroups)
+{
+	PSLProblem* problem = generateProblem(groupsInstance);
+	BOOST_REQUIRE_EQUAL(problem->aggregateGroups(), 1);
+	BOOST_CHECK_EQUAL(problem->groupCount(), 2);
+	BOOST_CHECK_EQUAL(problem->originalStageCount(), 4);
+	//The stage 0 is kept, the stages of the groups 0 and 2 are merged into the stage 1
+	const unsigned int stages[] = {0, 1, 2, 1};
+	for (unsigned int s = 0; s < 4; ++s) {
+		BOOST_CHECK_EQUAL(problem->getAggregatedStage(s), stages[s]);
+	}
+	IntList weights = problem->getStageWeights(0, 3);
+	BOOST_REQUIRE_EQUAL(weights.size(), 3);
+	BOOST_CHECK_EQUAL(weights[0], 1);
+	BOOST_CHECK_EQUAL(weights[1], 2);
+	BOOST_CHECK_EQUAL(weights[2], 1);
+	FacilityType* leaf = problem->getRoot()->getChild(0)->getType();
+	BOOST_CHECK_EQUAL(leaf->getDemand(0), 5);
+	BOOST_CHECK_EQUAL(leaf->getDemand(1), 7);
+	BOOST_CHECK_EQUAL(leaf->getTotalDemand(), 17);
+
+	//A stage range which contains every merged group is accepted
+	param_range all("stages", 1, 3);
+	weights = stage_weights_of(problem, all);
+	BOOST_CHECK_EQUAL(weights[0], 0);
+	BOOST_CHECK_EQUAL(weights[1], 2);
+	//A stage range which separates the merged groups is rejected
+	pid_t pid = fork();
+	if(pid == 0) {
+		freopen("/dev/null", "w", stderr);
+		param_range separating("stages", 1, 2);
+		stage_weights_of(problem, separating);
+		_exit(0);
+	}
+	int status;
+	BOOST_REQUIRE(waitpid(pid, &status, 0) == pid);
+	BOOST_CHECK(WIFEXITED(status) && WEXITSTATUS(status) != 0);
+	delete problem;
+}
+
+//Solver which records the columns and the rows it receives, and returns a given solution
+class recording_solver: public abstract_solver {
+public:
+	map<int, pair<CUDFcoefficient, CUDFcoefficient> > bounds;
+	vector< map<int, CUDFcoefficient> > rows;
+	vector<CUDFcoefficient> solution;
+	vector<double> start;
+
+	int init_solver(PSLProblem *problem, int other_vars) {
+		solution.assign(problem->rankCount() + other_vars, 0);
+		return 0;
+	}
+	int set_intvar_range(int rank, CUDFcoefficient lower, CUDFcoefficient upper) {
+		bounds[rank] = make_pair(lower, upper);
+		return 0;
+	}
+	int new_constraint(void) {
+		rows.push_back(map<int, CUDFcoefficient>());
+		return 0;
+	}
+	int set_constraint_coeff(int rank, CUDFcoefficient value) {
+		rows.back()[rank] = value;
+		return 0;
+	}
+	int set_mip_start(const vector<double> &start) {
+		this->start = start;
+		return 0;
+	}
+	CUDFcoefficient get_solution(int k) { return solution[k]; }
+};
+
+//Define the rows a[r] . x = rhs[r] on the additional columns of the problem
+void presolveRows(presolve_solver &presolve, int first, const vector< vector<CUDFcoefficient> > &a, const vector<CUDFcoefficient> &rhs, const string &senses) {
+	presolve.begin_add_constraints();
+	for (size_t r = 0; r < a.size(); r++) {
+		presolve.new_constraint();
+		for (size_t k = 0; k < a[r].size(); k++) {
+			if(a[r][k] != 0) presolve.set_constraint_coeff(first + k, a[r][k]);
+		}
+		if(senses[r] == 'E') presolve.add_constraint_eq(rhs[r]);
+		else if(senses[r] == 'L') presolve.add_constraint_leq(rhs[r]);
+		else presolve.add_constraint_geq(rhs[r]);
+	}
+	presolve.end_add_constraints();
+}
+
+//Check that the restored solution satisfies the original rows
+void checkPostsolve(presolve_solver &presolve, int first, const vector< vector<CUDFcoefficient> > &a, const vector<CUDFcoefficient> &rhs, const string &senses) {
+	for (size_t r = 0; r < a.size(); r++) {
+		CUDFcoefficient activity = 0;
+		for (size_t k = 0; k < a[r].size(); k++) activity += a[r][k] * presolve.get_solution(first + k);
+		if(senses[r] == 'E') BOOST_CHECK_EQUAL(activity, rhs[r]);
+		else if(senses[r] == 'L') BOOST_CHECK(activity <= rhs[r]);
+		else BOOST_CHECK(activity >= rhs[r]);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(presolveRoundTrip)
+{
+	PSLProblem* problem = initProblem();
+	const int x = problem->rankCount();
+	recording_solver inner;
+	presolve_solver presolve(&inner);
+	presolve.init_solver(problem, 5);
+	//x0 = x1 + x2 is substituted in x0 + x3 <= 8, and x4 = 2 is fixed
+	presolve.set_intvar_range(x, 0, 10);
+	presolve.set_intvar_range(x + 1, 0, 5);
+	presolve.set_intvar_range(x + 2, 0, 5);
+	presolve.set_intvar_range(x + 3, 0, 10);
+	presolve.set_intvar_range(x + 4, 0, 10);
+	presolve.begin_objectives();
+	presolve.new_objective();
+	presolve.set_obj_coeff(x + 1, -1);
+	presolve.set_obj_coeff(x + 3, -1);
+	presolve.add_objective();
+	presolve.end_objectives();
+	CUDFcoefficient a[3][5] = {{1, -1, -1, 0, 0}, {1, 0, 0, 1, 0}, {0, 0, 0, 0, 1}};
+	vector< vector<CUDFcoefficient> > rows;
+	for (int r = 0; r < 3; r++) rows.push_back(vector<CUDFcoefficient>(a[r], a[r] + 5));
+	CUDFcoefficient b[3] = {0, 8, 2};
+	vector<CUDFcoefficient> rhs(b, b + 3);
+	presolveRows(presolve, x, rows, rhs, "ELE");
+
+	//The solver receives the single row x1 + x2 + x3 <= 8, and the removed columns are fixed
+	BOOST_REQUIRE_EQUAL(inner.rows.size(), 1);
+	BOOST_CHECK_EQUAL(inner.rows[0].size(), 3);
+	BOOST_CHECK_EQUAL(inner.rows[0][x + 1], 1);
+	BOOST_CHECK_EQUAL(inner.rows[0][x + 2], 1);
+	BOOST_CHECK_EQUAL(inner.rows[0][x + 3], 1);
+	BOOST_CHECK(inner.bounds[x] == make_pair(0LL, 0LL));
+	BOOST_CHECK(inner.bounds[x + 4] == make_pair(2LL, 2LL));
+
+	//The starting solution respects the bounds of the removed columns
+	vector<double> start(x + 5, 0);
+	start[x] = 5;
+	start[x + 1] = 2;
+	start[x + 2] = 3;
+	start[x + 4] = 2;
+	presolve.set_mip_start(start);
+	BOOST_REQUIRE_EQUAL(inner.start.size(), start.size());
+	BOOST_CHECK_EQUAL(inner.start[x], 0);
+	BOOST_CHECK_EQUAL(inner.start[x + 1], 2);
+	BOOST_CHECK_EQUAL(inner.start[x + 4], 2);
+
+	//The values of the removed columns are restored
+	inner.solution[x + 1] = 2;
+	inner.solution[x + 2] = 3;
+	inner.solution[x + 3] = 3;
+	presolve.init_solutions();
+	BOOST_CHECK_EQUAL(presolve.get_solution(x), 5);
+	BOOST_CHECK_EQUAL(presolve.get_solution(x + 4), 2);
+	checkPostsolve(presolve, x, rows, rhs, "ELE");
+}
+
+BOOST_AUTO_TEST_CASE(presolveUnboundedColumns)
+{
+	PSLProblem* problem = initProblem();
+	const int x = problem->rankCount();
+	recording_solver inner;
+	presolve_solver presolve(&inner);
+	presolve.init_solver(problem, 4);
+	//x0, x1 and x2 are unbounded (see -nobounds)
+	presolve.set_intvar(x, NULL);
+	presolve.set_intvar(x + 1, NULL);
+	presolve.set_intvar(x + 2, NULL);
+	presolve.set_intvar_range(x + 3, 0, 5);
+	presolve.begin_objectives();
+	presolve.end_objectives();
+	//the substitution of x0 = x1 + x2 cancels the coefficient of x1 in x3 = x0 - x1
+	CUDFcoefficient a[2][4] = {{1, -1, -1, 0}, {-1, 1, 0, 1}};
+	vector< vector<CUDFcoefficient> > rows;
+	for (int r = 0; r < 2; r++) rows.push_back(vector<CUDFcoefficient>(a[r], a[r] + 4));
+	vector<CUDFcoefficient> rhs(2, 0);
+	presolveRows(presolve, x, rows, rhs, "EE");
+
+	//x3 = x2 does not imply the bounds of x3: x3 is not substituted
+	BOOST_CHECK(inner.bounds[x + 3] == make_pair(0LL, 5LL));
+	inner.solution[x + 1] = 1;
+	inner.solution[x + 3] = 4;
+	presolve.init_solutions();
+	BOOST_CHECK_EQUAL(presolve.get_solution(x + 3), 4);
+	checkPostsolve(presolve, x, rows, rhs, "EE");
+}
+
+BOOST_AUTO_TEST_CASE(evaluatorGreedyPlacement)
+{
+	PSLProblem* problem = initProblem();
+	CUDFcoefficientList servers = place_servers(problem);
+	BOOST_REQUIRE_EQUAL(servers.size(), problem->nodeCount() * problem->serverTypeCount());
+	placement_evaluator evaluator;
+	BOOST_CHECK(evaluator.evaluate(problem, servers));
+	BOOST_CHECK_EQUAL(evaluator.unconnectedCount(), 0);
+	BOOST_CHECK_EQUAL(evaluator.pservCount, accumulate(servers.begin(), servers.end(), 0LL));
+	//the central facility contains the root pserver
+	BOOST_CHECK(servers[0] >= 1);
+}
+
+BOOST_AUTO_TEST_CASE(evaluatorInfeasiblePlacement)
+{
+	PSLProblem* problem = initProblem();
+	placement_evaluator evaluator;
+	//without any server, the root pserver and all the clients are missing
+	CUDFcoefficientList servers(problem->nodeCount() * problem->serverTypeCount(), 0);
+	BOOST_CHECK(! evaluator.evaluate(problem, servers));
+	CUDFcoefficient clients = 0;
+	for(NodeIterator i = problem->nbegin() ; i!=  problem->nend() ; i++) {
+		clients += i->getType()->getTotalDemand();
+	}
+	BOOST_CHECK_EQUAL(evaluator.unconnectedCount(), 1 + clients);
+	BOOST_CHECK_EQUAL(evaluator.pservCount, 0);
+
+	//the servers beyond the capacity of a facility are not connected
+	servers = place_servers(problem);
+	BOOST_REQUIRE(! servers.empty());
+	servers[0] = problem->getRoot()->getType()->getServerCapacity(0) + 2;
+	BOOST_CHECK(! evaluator.evaluate(problem, servers));
+	BOOST_CHECK_EQUAL(evaluator.unconnectedCount(), 2);
+}
+
 
 
 /*
@@ -0,0 +1,21 @@
+SET(HIGHS_ROOT_DIR "" CACHE PATH "HiGHS root directory")
+
+FIND_PATH(HIGHS_INCLUDE_DIR
+  Highs.h
+  PATH_SUFFIXES highs
+  HINTS ${HIGHS_ROOT_DIR}/include
+)
+FIND_LIBRARY(HIGHS_LIBRARY
+  highs
+  HINTS ${HIGHS_ROOT_DIR}/lib
+)
+
+INCLUDE(FindPackageHandleStandardArgs)
+FIND_PACKAGE_HANDLE_STANDARD_ARGS(HIGHS DEFAULT_MSG HIGHS_LIBRARY HIGHS_INCLUDE_DIR)
+
+IF(HIGHS_FOUND)
+  SET(HIGHS_INCLUDE_DIRS ${HIGHS_INCLUDE_DIR})
+  SET(HIGHS_LIBRARIES ${HIGHS_LIBRARY})
+ENDIF(HIGHS_FOUND)
+
+MARK_AS_ADVANCED(HIGHS_LIBRARY HIGHS_INCLUDE_DIR)